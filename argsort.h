@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "common.h"
+#include "key_index.h"
+#include "managed_dynamic_array.h"
+#pragma once
+
+template <typename T, typename Index>
+/**
+ * @brief Returns the permutation that sorts the given keys, leaving the keys untouched.
+ *
+ * Each key is copied next to its index and the pairs are sorted by @p sorter, so
+ * the keys stay close to the indices that follow them and any sorter can be used.
+ * Element i of the result is the index of the key that belongs at position i once
+ * sorted. Equal keys keep their original order.
+ *
+ * @tparam T The type of the keys.
+ * @tparam Index The unsigned integer type of the indices, std::uint32_t or std::uint64_t.
+ * Both are deduced from the type of @p sorter.
+ * @param keys The keys to sort.
+ * @param sorter The sorter used to order the key and index pairs.
+ * @return The sorting permutation, with one index per key.
+ * @throws std::runtime_error If there are more keys than Index can address.
+ *
+ * @section Example
+ * @code
+ * PdqSorter<KeyIndex<std::int64_t>> sorter;
+ * auto permutation = argsort(keys.to_span(), sorter);
+ * apply_permutation(permutation.to_span(), records.to_span());
+ * @endcode
+ */
+ManagedDynamicArray<Index> argsort(std::span<const std::type_identity_t<T>> keys, const Sorter<KeyIndex<T, Index>> & sorter);
+
+template <typename Index, typename... Columns>
+/**
+ * @brief Reorders one or more columns in place so that position i receives the
+ * element previously at permutation[i].
+ *
+ * The permutation is followed one cycle at a time, holding a single element of
+ * each column aside per cycle, so every element is moved exactly once plus one
+ * extra move per cycle and no column is copied. All of the columns are walked
+ * together, which reads the permutation only once however many columns there are.
+ *
+ * @tparam Index The unsigned integer type of the indices, which may be const.
+ * @tparam Columns The element types of the columns.
+ * @param permutation A permutation such as the one returned by argsort(). Every index
+ * must be less than its size and appear exactly once.
+ * @param columns The columns to reorder, each the same size as @p permutation.
+ * @throws std::runtime_error If a column is not the same size as @p permutation.
+ */
+void apply_permutation(std::span<Index> permutation, std::span<Columns>... columns)
+{
+    static_assert(std::is_unsigned_v<Index>, "Permutation indices must be unsigned");
+    int count = permutation.size();
+    if (((static_cast<int>(columns.size()) != count) || ...))
+    {
+        throw std::runtime_error("Every column must hold " + std::to_string(count) + " elements to apply the permutation");
+    }
+
+    // Marks the positions already filled, so each cycle is followed once.
+    ManagedDynamicArray<bool> placed(count);
+    auto placed_span = placed.to_span();
+    std::fill(placed_span.begin(), placed_span.end(), false);
+    for (int start = 0; start < count; ++start)
+    {
+        if (placed_span[start])
+        {
+            continue;
+        }
+        placed_span[start] = true;
+        int source = permutation[start];
+        if (source == start)
+        {
+            continue;
+        }
+
+        std::tuple<Columns...> held(std::move(columns[start])...);
+        int hole = start;
+        while (source != start)
+        {
+            ((columns[hole] = std::move(columns[source])), ...);
+            placed_span[source] = true;
+            hole = source;
+            source = permutation[hole];
+        }
+        std::apply([&](auto &... values) { ((columns[hole] = std::move(values)), ...); }, held);
+    }
+}
+
+template <typename T, typename Index>
+ManagedDynamicArray<Index> argsort(std::span<const std::type_identity_t<T>> keys, const Sorter<KeyIndex<T, Index>> & sorter)
+{
+    static_assert(std::is_unsigned_v<Index>, "Permutation indices must be unsigned");
+    if (keys.size() > std::numeric_limits<Index>::max())
+    {
+        throw std::runtime_error("Too many keys to index with " + std::to_string(sizeof(Index) * 8) + "-bit indices");
+    }
+
+    int count = keys.size();
+    ManagedDynamicArray<KeyIndex<T, Index>> pairs(count);
+    for (int i = 0; i < count; ++i)
+    {
+        pairs[i] = KeyIndex<T, Index>{keys[i], static_cast<Index>(i)};
+    }
+    sorter.sort(pairs.to_span());
+
+    ManagedDynamicArray<Index> permutation(count);
+    for (int i = 0; i < count; ++i)
+    {
+        permutation[i] = pairs[i].index;
+    }
+    return permutation;
+}
@@ -0,0 +1,445 @@
+#include <algorithm>
+#include <climits>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include "autotune.h"
+#include "insertion.h"
+#include "managed_dynamic_array.h"
+#include "merge.h"
+#include "parallel_merge.h"
+#include "pdq.h"
+#include "power.h"
+#include "quick.h"
+#include "radix.h"
+#include "stopwatch.h"
+
+/// Each measurement of a small size sorts a batch of arrays with about this many elements in all.
+static const int BATCH_ELEMENTS = 1 << 16;
+
+/// Sizes up to this also try insertion sort, which is quadratic.
+static const int MAX_INSERTION_SIZE = 1024;
+
+/// Sizes from this on also try parallel-merge, if there is more than one hardware thread.
+static const int MIN_PARALLEL_SIZE = 65536;
+
+/// The first line of a profile file.
+static const char * PROFILE_HEADER = "# cppsort tuning profile";
+
+template <typename T>
+/**
+ * @brief Builds the sorter a band names.
+ *
+ * @param algorithm The name of the sorter.
+ * @param parameter The sorter's tuning parameter.
+ * @param helper Receives the sorter the new one hands small ranges to, if it needs one.
+ * It must outlive the new sorter.
+ * @return The sorter.
+ * @throws std::runtime_error If there is no sorter of that name for T.
+ */
+static std::unique_ptr<Sorter<T>> make_tuned_sorter(const std::string & algorithm, int parameter,
+    std::unique_ptr<Sorter<T>> & helper)
+{
+    if (algorithm == "insertion")
+    {
+        return std::make_unique<InsertionSorter<T>>();
+    }
+    if (algorithm == "merge")
+    {
+        helper = std::make_unique<InsertionSorter<T>>();
+        return std::make_unique<MergeSorter<T>>(*helper, parameter);
+    }
+    if (algorithm == "block-quick")
+    {
+        return std::make_unique<QuickSorter<T>>(PartitionScheme::BLOCK, parameter);
+    }
+    if (algorithm == "pdq")
+    {
+        return std::make_unique<PdqSorter<T>>();
+    }
+    if (algorithm == "power")
+    {
+        return std::make_unique<PowerSorter<T>>(parameter);
+    }
+    if (algorithm == "parallel-merge")
+    {
+        helper = std::make_unique<PowerSorter<T>>();
+        return std::make_unique<ParallelMergeSorter<T>>(*helper, 0, parameter);
+    }
+    if constexpr (std::is_integral_v<T>)
+    {
+        if (algorithm == "radix")
+        {
+            return std::make_unique<RadixSorter<T>>();
+        }
+    }
+    throw std::runtime_error("There is no tunable sorter named " + algorithm + " for " + tuning_type_name<T>());
+}
+
+template <typename T>
+/**
+ * @brief Lists the sorters and parameters calibrate() tries at a size.
+ *
+ * @param size The size of the arrays to be sorted.
+ * @return The candidates, with max_size set to @p size.
+ */
+static std::vector<TuningBand> candidates(int size)
+{
+    // pdqsort is never far from the fastest, so trying it first lets the others be abandoned early.
+    std::vector<TuningBand> bands = {{size, "pdq", 0}};
+    if (size <= MAX_INSERTION_SIZE)
+    {
+        bands.push_back({size, "insertion", 0});
+    }
+    for (int cutoff : {8, 16, 32, 64})
+    {
+        bands.push_back({size, "merge", cutoff});
+    }
+    for (int cutoff : {1, 16, 32, 64})
+    {
+        bands.push_back({size, "block-quick", cutoff});
+    }
+    for (int min_run : {16, 32, 64})
+    {
+        bands.push_back({size, "power", min_run});
+    }
+    if constexpr (std::is_integral_v<T>)
+    {
+        bands.push_back({size, "radix", 0});
+    }
+    if (size >= MIN_PARALLEL_SIZE && std::thread::hardware_concurrency() > 1)
+    {
+        for (int grain_size : {16384, 65536})
+        {
+            bands.push_back({size, "parallel-merge", grain_size});
+        }
+    }
+    return bands;
+}
+
+template <typename T>
+/**
+ * @brief Times a sorter on a batch of arrays.
+ *
+ * @param sorter The sorter.
+ * @param input The batch, whose arrays are each @p size elements long.
+ * @param work Where each run sorts a copy of @p input.
+ * @param size Number of elements in each array.
+ * @param repetitions Number of runs.
+ * @param limit Nanoseconds after which the sorter has lost anyway, so a run taking longer ends the timing.
+ * @return Nanoseconds taken by the fastest run.
+ */
+static std::int64_t time_batch(const Sorter<T> & sorter, std::span<const T> input, std::span<T> work, int size,
+    int repetitions, std::int64_t limit)
+{
+    std::int64_t fastest = std::numeric_limits<std::int64_t>::max();
+    for (int rep = 0; rep < repetitions; rep++)
+    {
+        std::copy(input.begin(), input.end(), work.begin());
+        Stopwatch stopwatch;
+        for (std::size_t first = 0; first < work.size(); first += size)
+        {
+            sorter.sort(work.subspan(first, size));
+        }
+        fastest = std::min(fastest, stopwatch.elapsed_nanoseconds());
+        if (fastest > limit)
+        {
+            break;
+        }
+    }
+    return fastest;
+}
+
+template <typename T>
+const char * tuning_type_name()
+{
+    if constexpr (std::is_same_v<T, int>)
+    {
+        return "int";
+    }
+    else if constexpr (std::is_same_v<T, std::int64_t>)
+    {
+        return "int64";
+    }
+    else if constexpr (std::is_same_v<T, double>)
+    {
+        return "double";
+    }
+    else
+    {
+        return "string";
+    }
+}
+
+template <typename T>
+TuningProfile default_tuning_profile()
+{
+    TuningProfile profile;
+    profile.type = tuning_type_name<T>();
+    profile.bands.push_back({16, "insertion", 0});
+    if constexpr (std::is_integral_v<T>)
+    {
+        profile.bands.push_back({4096, "pdq", 0});
+        profile.bands.push_back({INT_MAX, "radix", 0});
+    }
+    else
+    {
+        profile.bands.push_back({INT_MAX, "pdq", 0});
+    }
+    return profile;
+}
+
+template <typename T>
+TuningProfile calibrate(const CalibrationOptions & options)
+{
+    if (options.sizes.empty() || options.distributions.empty())
+    {
+        throw std::runtime_error("Calibration needs at least one size and one distribution");
+    }
+
+    // Two bands with the same size would leave the profile unreadable, since read_profile() wants them ascending.
+    std::vector<int> sorted_sizes = options.sizes;
+    std::sort(sorted_sizes.begin(), sorted_sizes.end());
+    if (std::adjacent_find(sorted_sizes.begin(), sorted_sizes.end()) != sorted_sizes.end())
+    {
+        throw std::runtime_error("Calibration sizes must be distinct");
+    }
+
+    TuningProfile profile;
+    profile.type = tuning_type_name<T>();
+    InputGenerator<T> generator;
+    for (int size : options.sizes)
+    {
+        if (size < 1)
+        {
+            throw std::runtime_error("Calibration sizes must be positive");
+        }
+        int batch_count = std::max(1, BATCH_ELEMENTS / size) * size;
+        std::vector<ManagedDynamicArray<T>> inputs;
+        for (Distribution distribution : options.distributions)
+        {
+            DistributionSpec spec;
+            spec.distribution = distribution;
+            spec.seed = options.seed + size;
+            inputs.emplace_back(batch_count);
+            generator.generate(inputs.back().to_span(), spec);
+        }
+        ManagedDynamicArray<T> work(batch_count);
+
+        TuningBand best{size, "", 0};
+        std::int64_t best_time = std::numeric_limits<std::int64_t>::max();
+        for (const TuningBand & candidate : candidates<T>(size))
+        {
+            std::unique_ptr<Sorter<T>> helper;
+            std::unique_ptr<Sorter<T>> sorter = make_tuned_sorter<T>(candidate.algorithm, candidate.parameter, helper);
+            std::int64_t total = 0;
+            // Stop timing a candidate once it has lost, so a quick sort that goes quadratic cannot dominate.
+            for (ManagedDynamicArray<T> & input : inputs)
+            {
+                total += time_batch<T>(*sorter, input.to_span(), work.to_span(), size, options.repetitions,
+                    best_time - total);
+                if (total >= best_time)
+                {
+                    break;
+                }
+            }
+            if (total < best_time)
+            {
+                best_time = total;
+                best = candidate;
+            }
+        }
+        profile.bands.push_back(best);
+    }
+
+    std::sort(profile.bands.begin(), profile.bands.end(),
+        [](const TuningBand & x, const TuningBand & y) { return x.max_size < y.max_size; });
+    profile.bands.back().max_size = INT_MAX;
+    return profile;
+}
+
+void write_profile(std::ostream & out, const TuningProfile & profile)
+{
+    out << PROFILE_HEADER << '\n';
+    out << "type " << profile.type << '\n';
+    for (const TuningBand & band : profile.bands)
+    {
+        out << "band " << band.max_size << ' ' << band.algorithm << ' ' << band.parameter << '\n';
+    }
+}
+
+TuningProfile read_profile(std::istream & in)
+{
+    TuningProfile profile;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(in, line))
+    {
+        line_number++;
+        std::istringstream fields(line);
+        std::string keyword;
+        if (!(fields >> keyword) || keyword[0] == '#')
+        {
+            continue;
+        }
+
+        bool parsed = false;
+        if (keyword == "type")
+        {
+            parsed = static_cast<bool>(fields >> profile.type);
+        }
+        else if (keyword == "band")
+        {
+            TuningBand band;
+            parsed = static_cast<bool>(fields >> band.max_size >> band.algorithm >> band.parameter);
+            if (parsed)
+            {
+                if (band.max_size < 1 || (!profile.bands.empty() && band.max_size <= profile.bands.back().max_size))
+                {
+                    throw std::runtime_error("Profile line " + std::to_string(line_number)
+                        + ": band sizes must be positive and ascending");
+                }
+                profile.bands.push_back(band);
+            }
+        }
+        std::string extra;
+        if (!parsed || fields >> extra)
+        {
+            throw std::runtime_error("Profile line " + std::to_string(line_number) + " cannot be parsed: " + line);
+        }
+    }
+
+    if (profile.type.empty() || profile.bands.empty())
+    {
+        throw std::runtime_error("A profile needs a type and at least one band");
+    }
+    return profile;
+}
+
+void save_profile(const TuningProfile & profile, const std::filesystem::path & path)
+{
+    // Written beside the target under a name of its own, then renamed over it, so a process
+    // loading the profile at the same time sees the old file or the new one, never part of one.
+    std::filesystem::path temp_path = path;
+    temp_path += ".tmp-" + std::to_string(std::random_device()());
+    std::ofstream out(temp_path);
+    write_profile(out, profile);
+    out.close();
+    std::error_code error;
+    if (!out)
+    {
+        std::filesystem::remove(temp_path, error);
+        throw std::runtime_error("Cannot write the profile to " + path.string());
+    }
+    std::filesystem::rename(temp_path, path, error);
+    if (error)
+    {
+        std::filesystem::remove(temp_path, error);
+        throw std::runtime_error("Cannot write the profile to " + path.string());
+    }
+}
+
+TuningProfile load_profile(const std::filesystem::path & path)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        throw std::runtime_error("Cannot read the profile from " + path.string());
+    }
+    return read_profile(in);
+}
+
+template <typename T>
+TuningProfile load_or_calibrate(const std::filesystem::path & path, const CalibrationOptions & options)
+{
+    if (!std::filesystem::exists(path))
+    {
+        TuningProfile profile = calibrate<T>(options);
+        save_profile(profile, path);
+        return profile;
+    }
+
+    TuningProfile profile = load_profile(path);
+    if (profile.type != tuning_type_name<T>())
+    {
+        throw std::runtime_error(path.string() + " holds a profile for " + profile.type + ", not "
+            + tuning_type_name<T>());
+    }
+    return profile;
+}
+
+template <typename T>
+AutoSorter<T>::AutoSorter(const TuningProfile & profile) : Sorter<T>("Auto"), profile_(profile)
+{
+    if (profile_.type != tuning_type_name<T>())
+    {
+        throw std::runtime_error("The profile is for " + profile_.type + ", not " + tuning_type_name<T>());
+    }
+    if (profile_.bands.empty())
+    {
+        throw std::runtime_error("The profile has no bands");
+    }
+    for (const TuningBand & band : profile_.bands)
+    {
+        Band built;
+        built.max_size = band.max_size;
+        built.sorter = make_tuned_sorter<T>(band.algorithm, band.parameter, built.helper);
+        bands_.push_back(std::move(built));
+    }
+}
+
+template <typename T>
+const TuningProfile & AutoSorter<T>::profile() const
+{
+    return profile_;
+}
+
+template <typename T>
+const Sorter<T> & AutoSorter<T>::sorter_for(int size) const
+{
+    for (const Band & band : bands_)
+    {
+        if (size <= band.max_size)
+        {
+            return *band.sorter;
+        }
+    }
+    return *bands_.back().sorter;
+}
+
+template <typename T>
+void AutoSorter<T>::sort(std::span<T> ary) const
+{
+    sorter_for(static_cast<int>(ary.size())).sort(ary);
+}
+
+template const char * tuning_type_name<int>();
+template const char * tuning_type_name<std::int64_t>();
+template const char * tuning_type_name<double>();
+template const char * tuning_type_name<std::string>();
+
+template TuningProfile default_tuning_profile<int>();
+template TuningProfile default_tuning_profile<std::int64_t>();
+template TuningProfile default_tuning_profile<double>();
+template TuningProfile default_tuning_profile<std::string>();
+
+template TuningProfile calibrate<int>(const CalibrationOptions &);
+template TuningProfile calibrate<std::int64_t>(const CalibrationOptions &);
+template TuningProfile calibrate<double>(const CalibrationOptions &);
+template TuningProfile calibrate<std::string>(const CalibrationOptions &);
+
+template TuningProfile load_or_calibrate<int>(const std::filesystem::path &, const CalibrationOptions &);
+template TuningProfile load_or_calibrate<std::int64_t>(const std::filesystem::path &, const CalibrationOptions &);
+template TuningProfile load_or_calibrate<double>(const std::filesystem::path &, const CalibrationOptions &);
+template TuningProfile load_or_calibrate<std::string>(const std::filesystem::path &, const CalibrationOptions &);
+
+template class AutoSorter<int>;
+template class AutoSorter<std::int64_t>;
+template class AutoSorter<double>;
+template class AutoSorter<std::string>;
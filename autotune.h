@@ -0,0 +1,218 @@
+#include <cstdint>
+#include <filesystem>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+#include "common.h"
+#include "generator.h"
+#pragma once
+
+/**
+ * @struct TuningBand
+ * @brief The sorter a TuningProfile uses for arrays up to a size.
+ */
+struct TuningBand
+{
+    /// Arrays with at most this many elements, and more than the previous band, use this band.
+    int max_size;
+
+    /// The sorter: insertion, merge, block-quick, pdq, power, radix or parallel-merge.
+    std::string algorithm;
+
+    /**
+     * The sorter's tuning parameter: the small range cutoff of merge and block-quick,
+     * the minimum run length of power or the grain size of parallel-merge. Other
+     * sorters ignore it.
+     */
+    int parameter;
+};
+
+/**
+ * @struct TuningProfile
+ * @brief The sorters that calibration found fastest on one machine, by array size.
+ */
+struct TuningProfile
+{
+    /// The element type the profile was calibrated for, as tuning_type_name() gives it.
+    std::string type;
+
+    /// The bands in ascending order of size. The last one covers every larger size as well.
+    std::vector<TuningBand> bands;
+};
+
+/**
+ * @struct CalibrationOptions
+ * @brief Describes what calibrate() measures.
+ */
+struct CalibrationOptions
+{
+    /// The largest size of each band, in ascending order. Each band is timed at this size.
+    std::vector<int> sizes = {16, 128, 1024, 16384, 262144};
+
+    /// The inputs each candidate is timed on. The candidate with the least total time wins.
+    std::vector<Distribution> distributions = {Distribution::UNIFORM, Distribution::NEARLY_SORTED,
+        Distribution::FEW_UNIQUE};
+
+    /// Number of timed runs of each candidate on each input, of which the fastest counts.
+    int repetitions = 3;
+
+    /// Seeds the inputs.
+    std::uint64_t seed = 1;
+};
+
+template <typename T>
+/**
+ * @brief Returns the name profiles use for an element type.
+ *
+ * @return int, int64, double or string.
+ */
+const char * tuning_type_name();
+
+template <typename T>
+/**
+ * @brief Returns a profile that suits most machines, for use before any calibration.
+ *
+ * @return Insertion sort for small arrays, then pdqsort, then radix sort for large arrays of integers.
+ */
+TuningProfile default_tuning_profile();
+
+template <typename T>
+/**
+ * @brief Times every candidate sorter and cutoff at each band size and keeps the fastest.
+ *
+ * Small sizes are timed by sorting a batch of arrays back to back, so every
+ * measurement covers enough elements to be well above the timer's resolution.
+ * With the default options this takes a few seconds for numbers and longer for strings.
+ *
+ * @param options The sizes and inputs to time.
+ * @return The profile.
+ * @throws std::runtime_error If there are no sizes or no distributions, or a size is not positive or appears twice.
+ */
+TuningProfile calibrate(const CalibrationOptions & options = CalibrationOptions());
+
+/**
+ * @brief Writes a profile as text, one band per line.
+ *
+ * @param out The stream to write to.
+ * @param profile The profile.
+ */
+void write_profile(std::ostream & out, const TuningProfile & profile);
+
+/**
+ * @brief Reads a profile written by write_profile().
+ *
+ * @param in The stream to read from.
+ * @return The profile.
+ * @throws std::runtime_error If a line cannot be parsed, or there are no bands or they are out of order.
+ */
+TuningProfile read_profile(std::istream & in);
+
+/**
+ * @brief Saves a profile to a file, replacing it if it exists.
+ *
+ * The profile is written to a temporary file in the same directory and renamed
+ * into place, so a reader never sees a partly written profile.
+ *
+ * @param profile The profile.
+ * @param path The file.
+ * @throws std::runtime_error If the file cannot be written.
+ */
+void save_profile(const TuningProfile & profile, const std::filesystem::path & path);
+
+/**
+ * @brief Loads a profile from a file.
+ *
+ * @param path The file.
+ * @return The profile.
+ * @throws std::runtime_error If the file cannot be read or parsed.
+ */
+TuningProfile load_profile(const std::filesystem::path & path);
+
+template <typename T>
+/**
+ * @brief Loads a profile from a file, or calibrates one and saves it there if the file does not exist.
+ *
+ * Only the first process on a machine pays for calibration.
+ *
+ * @param path The profile file.
+ * @param options What to calibrate with if the file does not exist.
+ * @return The profile.
+ * @throws std::runtime_error If the file cannot be read, written or parsed, or holds a profile for another type.
+ */
+TuningProfile load_or_calibrate(const std::filesystem::path & path,
+    const CalibrationOptions & options = CalibrationOptions());
+
+template <typename T>
+/**
+ * @class AutoSorter
+ * @brief Sorts each array with the sorter a TuningProfile picked for its size.
+ *
+ * @tparam T int, std::int64_t, double or std::string.
+ *
+ * Every sorter the profile names is built once, up front, so sort() only has to
+ * find the band. Arrays are sorted in ascending order.
+ *
+ * @section Example
+ * @code
+ * AutoSorter<int> sorter(load_or_calibrate<int>("cppsort-int.profile"));
+ * sorter.sort(values);
+ * @endcode
+ */
+class AutoSorter : public Sorter<T>
+{
+    /**
+     * @struct Band
+     * @brief A band of the profile with its sorter built.
+     */
+    struct Band
+    {
+        /// Arrays with at most this many elements use this band.
+        int max_size;
+
+        /// A sorter @p sorter hands small ranges to, if it needs one.
+        std::unique_ptr<Sorter<T>> helper;
+
+        /// The sorter for the band.
+        std::unique_ptr<Sorter<T>> sorter;
+    };
+
+    /// The profile the sorters were built from.
+    TuningProfile profile_;
+
+    /// The bands in ascending order of size.
+    std::vector<Band> bands_;
+
+public:
+    /**
+     * @brief Builds the sorters a profile names.
+     *
+     * @param profile The profile.
+     * @throws std::runtime_error If the profile is for another type, has no bands or names an unknown sorter.
+     */
+    explicit AutoSorter(const TuningProfile & profile);
+
+    /**
+     * @brief Returns the profile the sorter was built from.
+     *
+     * @return The profile.
+     */
+    const TuningProfile & profile() const;
+
+    /**
+     * @brief Returns the sorter used for arrays of a size.
+     *
+     * @param size Number of elements.
+     * @return The sorter.
+     */
+    const Sorter<T> & sorter_for(int size) const;
+
+    /**
+     * @brief Sorts the given array in place with the sorter for its size.
+     *
+     * @param ary A std::span<T> representing the array to be sorted.
+     */
+    void sort(std::span<T> ary) const override;
+};
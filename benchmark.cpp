@@ -0,0 +1,831 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "benchmark.h"
+#include "bubble.h"
+#include "common.h"
+#include "heap.h"
+#include "insertion.h"
+#include "managed_dynamic_array.h"
+#include "merge.h"
+#include "perf_counters.h"
+#include "power.h"
+#include "probing.h"
+#include "network.h"
+#include "parallel_merge.h"
+#include "pdq.h"
+#include "quick.h"
+#include "radix.h"
+#include "record.h"
+#include "selection.h"
+#include "stopwatch.h"
+
+static const int DEFAULT_REPETITIONS = 10;
+static const int DEFAULT_WARMUP = 1;
+static const double DEFAULT_SIZE_FACTOR = 2.0;
+
+template <typename T>
+/**
+ * @class SorterCatalog
+ * @brief Owns one instance of every sorter that can sort T, looked up by a short key.
+ */
+class SorterCatalog
+{
+    /// The sorters in the order they are listed, along with their keys.
+    std::vector<std::pair<std::string, std::unique_ptr<Sorter<T>>>> entries_;
+
+    /// Keys of the sorters that are timed when none are chosen.
+    std::vector<std::string> defaults_;
+
+    /**
+     * @brief Adds a sorter to the catalog.
+     *
+     * @param key The key the sorter is chosen by.
+     * @param sorter The sorter.
+     * @param is_default true if the sorter is timed when none are chosen.
+     * @return The sorter, for use by sorters added later.
+     */
+    const Sorter<T> & add(const char * key, std::unique_ptr<Sorter<T>> sorter, bool is_default)
+    {
+        if (is_default)
+        {
+            defaults_.push_back(key);
+        }
+        entries_.emplace_back(key, std::move(sorter));
+        return *entries_.back().second;
+    }
+
+public:
+    SorterCatalog()
+    {
+        add("bubble", std::make_unique<BubbleSorter<T>>(), false);
+        add("cocktail", std::make_unique<CocktailShakerSorter<T>>(), false);
+        add("insertion", std::make_unique<InsertionSorter<T>>(), false);
+        add("selection", std::make_unique<SelectionSorter<T>>(), false);
+        add("heap", std::make_unique<HeapSorter<T>>(), true);
+        const Sorter<T> & network = add("network", std::make_unique<NetworkSorter<T>>(), true);
+        const Sorter<T> & merge = add("merge", std::make_unique<MergeSorter<T>>(network, NetworkSorter<T>::BLOCK_SIZE), true);
+        add("parallel-merge", std::make_unique<ParallelMergeSorter<T>>(merge), true);
+        add("quick", std::make_unique<QuickSorter<T>>(), true);
+        add("block-quick", std::make_unique<QuickSorter<T>>(PartitionScheme::BLOCK), true);
+        add("pdq", std::make_unique<PdqSorter<T>>(), true);
+        add("power", std::make_unique<PowerSorter<T>>(), true);
+        add("probing", std::make_unique<ProbingSorter<T>>(), true);
+        if constexpr (std::is_integral_v<T>)
+        {
+            add("radix", std::make_unique<RadixSorter<T>>(), true);
+            add("parallel-radix", std::make_unique<ParallelRadixSorter<T>>(), true);
+        }
+    }
+
+    /**
+     * @brief Returns the sorter with the given key.
+     *
+     * @param key The key of the sorter.
+     * @return The sorter.
+     * @throws std::runtime_error If no sorter for T has the key.
+     */
+    const Sorter<T> & find(const std::string & key) const
+    {
+        for (const auto & [entry_key, sorter] : entries_)
+        {
+            if (entry_key == key)
+            {
+                return *sorter;
+            }
+        }
+        throw std::runtime_error("Unknown sorter " + key + " for this element type");
+    }
+
+    /**
+     * @brief Returns the keys of the sorters that are timed when none are chosen.
+     *
+     * @return The keys of every n log n sorter.
+     */
+    const std::vector<std::string> & defaults() const
+    {
+        return defaults_;
+    }
+};
+
+/**
+ * @brief Returns the sample at a percentile using the nearest-rank method.
+ *
+ * @param sorted_samples The samples, sorted in ascending order. There must be at least one.
+ * @param percentile The percentile, from 0 to 100.
+ * @return The smallest sample that at least @p percentile percent of the samples do not exceed.
+ */
+static std::int64_t percentile_of(const std::vector<std::int64_t> & sorted_samples, double percentile)
+{
+    int count = sorted_samples.size();
+    int rank = std::ceil(percentile / 100.0 * count);
+    return sorted_samples[std::clamp(rank - 1, 0, count - 1)];
+}
+
+template <typename T>
+/**
+ * @brief Times a sorter on fresh copies of an input.
+ *
+ * @param type The name of T for the result.
+ * @param key The key of the sorter for the result.
+ * @param sorter The sorter to time.
+ * @param distribution The distribution of the input, for the result.
+ * @param input The input, which is copied before every sort.
+ * @param options The number of repetitions and warm-up runs.
+ * @param counters The hardware counters to read around every timed sort, or nullptr to only time.
+ * @return The timings.
+ * @throws std::runtime_error If the sorter leaves a copy unsorted.
+ */
+static BenchmarkResult time_sorter(const std::string & type, const std::string & key, const Sorter<T> & sorter,
+    Distribution distribution, std::span<const T> input, const BenchmarkOptions & options, PerfCounters * counters)
+{
+    int count = input.size();
+    ManagedDynamicArray<T> to_sort(count);
+    std::span<T> span_to_sort = to_sort.to_span();
+    std::vector<std::int64_t> samples;
+    std::optional<SortStats> last_stats;
+    // The total of each event over the timed sorts, dropped if any sort could not count it.
+    std::optional<std::uint64_t> event_totals[NUM_HARDWARE_EVENTS];
+    if (counters != nullptr)
+    {
+        std::fill(event_totals, event_totals + NUM_HARDWARE_EVENTS, std::uint64_t(0));
+    }
+    for (int run = 0; run < options.warmup + options.repetitions; ++run)
+    {
+        std::copy(input.begin(), input.end(), span_to_sort.begin());
+        Instrumentation::reset();
+        if (counters != nullptr)
+        {
+            counters->start();
+        }
+        Stopwatch stopwatch;
+        sorter.sort(span_to_sort);
+        std::int64_t elapsed = stopwatch.elapsed_nanoseconds();
+        CounterReading reading = counters != nullptr ? counters->stop() : CounterReading();
+        SortStats stats = Instrumentation::read();
+        if (!std::is_sorted(span_to_sort.begin(), span_to_sort.end()))
+        {
+            throw std::runtime_error(std::string(sorter.name()) + " left " + std::to_string(count) + " " + type
+                + " elements unsorted");
+        }
+        if (run >= options.warmup)
+        {
+            samples.push_back(elapsed);
+            if constexpr (Instrumentation::ENABLED)
+            {
+                last_stats = stats;
+            }
+            for (int event = 0; event < NUM_HARDWARE_EVENTS; ++event)
+            {
+                if (event_totals[event] && reading.counts[event])
+                {
+                    *event_totals[event] += *reading.counts[event];
+                }
+                else
+                {
+                    event_totals[event].reset();
+                }
+            }
+        }
+    }
+
+    std::sort(samples.begin(), samples.end());
+    BenchmarkResult result;
+    result.type = type;
+    result.sorter = key;
+    result.distribution = distribution_name(distribution);
+    result.size = count;
+    result.repetitions = options.repetitions;
+    result.min_ns = samples.front();
+    result.median_ns = percentile_of(samples, 50);
+    result.p95_ns = percentile_of(samples, 95);
+    double median_ns = std::max<std::int64_t>(result.median_ns, 1);
+    result.elements_per_second = count * 1e9 / median_ns;
+    result.ns_per_n_log_n = count > 1 ? median_ns / (count * std::log2(count)) : median_ns;
+    result.stats = last_stats;
+    for (int event = 0; event < NUM_HARDWARE_EVENTS; ++event)
+    {
+        if (event_totals[event])
+        {
+            result.events_per_element[event] = static_cast<double>(*event_totals[event]) / options.repetitions / count;
+        }
+    }
+    const std::optional<std::uint64_t> & cycles = event_totals[static_cast<int>(HardwareEvent::CYCLES)];
+    const std::optional<std::uint64_t> & instructions = event_totals[static_cast<int>(HardwareEvent::INSTRUCTIONS)];
+    if (cycles && instructions && *cycles > 0)
+    {
+        result.instructions_per_cycle = static_cast<double>(*instructions) / *cycles;
+    }
+    return result;
+}
+
+template <typename T>
+/**
+ * @brief Times the selected sorters for one element type.
+ *
+ * @param options What to time.
+ * @param results Receives one result per sorter, distribution and size.
+ */
+static void run_benchmarks_for(const BenchmarkOptions & options, std::vector<BenchmarkResult> & results)
+{
+    SorterCatalog<T> catalog;
+    const std::vector<std::string> & keys = options.sorters.empty() ? catalog.defaults() : options.sorters;
+    // Look every key up before timing anything, so a typo fails straight away.
+    std::vector<const Sorter<T> *> sorters;
+    for (const std::string & key : keys)
+    {
+        sorters.push_back(&catalog.find(key));
+    }
+
+    std::optional<PerfCounters> counters;
+    if (options.counters)
+    {
+        counters.emplace();
+    }
+    PerfCounters * counters_ptr = counters && counters->available() ? &*counters : nullptr;
+
+    InputGenerator<T> generator;
+    for (Distribution distribution : options.distributions)
+    {
+        DistributionSpec spec = options.input;
+        spec.distribution = distribution;
+        for (int size : options.sizes)
+        {
+            ManagedDynamicArray<T> input(size);
+            generator.generate(input.to_span(), spec);
+            for (int i = 0; i < static_cast<int>(keys.size()); ++i)
+            {
+                results.push_back(time_sorter<T>(options.type, keys[i], *sorters[i], distribution, input.to_span(),
+                    options, counters_ptr));
+            }
+        }
+    }
+}
+
+std::vector<BenchmarkResult> run_benchmarks(const BenchmarkOptions & options)
+{
+    std::vector<BenchmarkResult> results;
+    if (options.type == "int")
+    {
+        run_benchmarks_for<int>(options, results);
+    }
+    else if (options.type == "int64")
+    {
+        run_benchmarks_for<std::int64_t>(options, results);
+    }
+    else if (options.type == "double")
+    {
+        run_benchmarks_for<double>(options, results);
+    }
+    else if (options.type == "string")
+    {
+        run_benchmarks_for<std::string>(options, results);
+    }
+    else if (options.type == "record")
+    {
+        run_benchmarks_for<Record>(options, results);
+    }
+    else
+    {
+        throw std::runtime_error("Unknown element type " + options.type);
+    }
+    return results;
+}
+
+/**
+ * @brief Splits a string at every separator.
+ *
+ * @param text The string to split.
+ * @param separator The character to split at.
+ * @return The pieces, including empty ones.
+ */
+static std::vector<std::string> split(const std::string & text, char separator)
+{
+    std::vector<std::string> pieces;
+    std::stringstream stream(text);
+    std::string piece;
+    while (std::getline(stream, piece, separator))
+    {
+        pieces.push_back(piece);
+    }
+    return pieces;
+}
+
+/**
+ * @brief Parses a number that is not negative.
+ *
+ * @param text The number to parse.
+ * @param option The option it belongs to, for error messages.
+ * @return The number.
+ * @throws std::runtime_error If the text is not such a number.
+ */
+static double parse_number(const std::string & text, const std::string & option)
+{
+    std::size_t end = 0;
+    double value = -1;
+    try
+    {
+        value = std::stod(text, &end);
+    }
+    catch (const std::exception &)
+    {
+    }
+    if (end != text.size() || !(value >= 0))
+    {
+        throw std::runtime_error("Bad value " + text + " for " + option);
+    }
+    return value;
+}
+
+/**
+ * @brief Parses a positive number, which may end in k, M or G for thousands, millions or billions.
+ *
+ * @param text The number to parse.
+ * @param option The option it belongs to, for error messages.
+ * @return The number.
+ * @throws std::runtime_error If the text is not such a number or is too large for an int.
+ */
+static int parse_count(const std::string & text, const std::string & option)
+{
+    std::size_t end = 0;
+    double value = -1;
+    try
+    {
+        value = std::stod(text, &end);
+    }
+    catch (const std::exception &)
+    {
+    }
+    std::string suffix = text.substr(std::min(end, text.size()));
+    if (suffix == "k")
+    {
+        value *= 1e3;
+    }
+    else if (suffix == "M")
+    {
+        value *= 1e6;
+    }
+    else if (suffix == "G")
+    {
+        value *= 1e9;
+    }
+    else if (!suffix.empty())
+    {
+        value = -1;
+    }
+    if (!(value >= 0 && value <= INT_MAX))
+    {
+        throw std::runtime_error("Bad value " + text + " for " + option);
+    }
+    return std::llround(value);
+}
+
+/**
+ * @brief Parses a list of sizes such as "1000,1k:1M:10".
+ *
+ * Each item is either a single size or START:END[:FACTOR], the geometric sequence
+ * from START that multiplies by FACTOR, 2 by default, up to END.
+ *
+ * @param text The list to parse.
+ * @return The sizes, in the order given.
+ * @throws std::runtime_error If an item is malformed.
+ */
+static std::vector<int> parse_sizes(const std::string & text)
+{
+    std::vector<int> sizes;
+    for (const std::string & item : split(text, ','))
+    {
+        std::vector<std::string> parts = split(item, ':');
+        if (parts.size() == 1)
+        {
+            sizes.push_back(parse_count(parts[0], "--sizes"));
+            continue;
+        }
+        if (parts.size() > 3)
+        {
+            throw std::runtime_error("Bad size range " + item);
+        }
+        int start = parse_count(parts[0], "--sizes");
+        int end = parse_count(parts[1], "--sizes");
+        double factor = DEFAULT_SIZE_FACTOR;
+        if (parts.size() == 3)
+        {
+            try
+            {
+                factor = std::stod(parts[2]);
+            }
+            catch (const std::exception &)
+            {
+                factor = 0;
+            }
+        }
+        if (start < 1 || end < start || factor <= 1)
+        {
+            throw std::runtime_error("Bad size range " + item);
+        }
+        for (double size = start; size <= end; size *= factor)
+        {
+            int rounded = std::llround(size);
+            if (sizes.empty() || sizes.back() != rounded)
+            {
+                sizes.push_back(rounded);
+            }
+        }
+    }
+    for (int size : sizes)
+    {
+        if (size < 1)
+        {
+            throw std::runtime_error("Every size must be at least 1");
+        }
+    }
+    return sizes;
+}
+
+BenchmarkOptions parse_benchmark_options(std::span<char * const> args)
+{
+    BenchmarkOptions options;
+    options.sizes = parse_sizes("1000:1000000:10");
+    options.type = "int";
+    options.repetitions = DEFAULT_REPETITIONS;
+    options.warmup = DEFAULT_WARMUP;
+    options.distributions = {Distribution::UNIFORM};
+    options.counters = false;
+    options.format = ReportFormat::TABLE;
+    options.help = false;
+
+    int num_args = args.size();
+    for (int i = 0; i < num_args; ++i)
+    {
+        std::string option = args[i];
+        if (option == "--help")
+        {
+            options.help = true;
+            continue;
+        }
+        if (i + 1 >= num_args)
+        {
+            throw std::runtime_error("Missing value for " + option);
+        }
+        std::string value = args[++i];
+        if (option == "--sizes")
+        {
+            options.sizes = parse_sizes(value);
+        }
+        else if (option == "--type")
+        {
+            options.type = value;
+        }
+        else if (option == "--sorters")
+        {
+            options.sorters = value == "all" ? std::vector<std::string>() : split(value, ',');
+        }
+        else if (option == "--repetitions")
+        {
+            options.repetitions = parse_count(value, option);
+            if (options.repetitions < 1)
+            {
+                throw std::runtime_error("--repetitions must be at least 1");
+            }
+        }
+        else if (option == "--warmup")
+        {
+            options.warmup = parse_count(value, option);
+        }
+        else if (option == "--distributions")
+        {
+            options.distributions.clear();
+            if (value == "all")
+            {
+                for (int d = 0; d < NUM_DISTRIBUTIONS; ++d)
+                {
+                    options.distributions.push_back(static_cast<Distribution>(d));
+                }
+            }
+            else
+            {
+                for (const std::string & name : split(value, ','))
+                {
+                    options.distributions.push_back(parse_distribution(name));
+                }
+            }
+        }
+        else if (option == "--seed")
+        {
+            options.input.seed = parse_count(value, option);
+        }
+        else if (option == "--swap-percent")
+        {
+            options.input.swap_percent = parse_number(value, option);
+        }
+        else if (option == "--num-unique")
+        {
+            options.input.num_unique = parse_count(value, option);
+        }
+        else if (option == "--zipf-exponent")
+        {
+            options.input.zipf_exponent = parse_number(value, option);
+        }
+        else if (option == "--format")
+        {
+            if (value == "table")
+            {
+                options.format = ReportFormat::TABLE;
+            }
+            else if (value == "json")
+            {
+                options.format = ReportFormat::JSON;
+            }
+            else if (value == "csv")
+            {
+                options.format = ReportFormat::CSV;
+            }
+            else
+            {
+                throw std::runtime_error("Bad value " + value + " for --format");
+            }
+        }
+        else if (option == "--counters")
+        {
+            if (value != "on" && value != "off")
+            {
+                throw std::runtime_error("Bad value " + value + " for --counters");
+            }
+            options.counters = value == "on";
+        }
+        else if (option == "--output")
+        {
+            options.output = value;
+        }
+        else
+        {
+            throw std::runtime_error("Unknown option " + option);
+        }
+    }
+    return options;
+}
+
+std::string benchmark_usage()
+{
+    return "  --sizes LIST         sizes or START:END[:FACTOR] ranges, comma separated, with k, M or G suffixes\n"
+        "                       (default 1000:1000000:10)\n"
+        "  --type TYPE          int, int64, double, string or record (default int)\n"
+        "  --sorters LIST       comma separated keys such as pdq,merge,radix, or all (default all n log n)\n"
+        "  --repetitions N      timed sorts per input (default 10)\n"
+        "  --warmup N           untimed sorts per input before the timed ones (default 1)\n"
+        "  --distributions LIST uniform, sorted, reversed, organ-pipe, sawtooth, nearly-sorted, few-unique,\n"
+        "                       all-equal or zipf, comma separated, or all (default uniform)\n"
+        "  --swap-percent P     swaps in nearly-sorted inputs, as a percentage of the size (default 1)\n"
+        "  --num-unique N       distinct keys in few-unique inputs (default 16)\n"
+        "  --zipf-exponent S    exponent of zipf inputs (default 1)\n"
+        "  --seed N             seed for the inputs (default 1)\n"
+        "  --counters on|off    count hardware events with perf_event_open where allowed (default off)\n"
+        "  --format FORMAT      table, json or csv (default table)\n"
+        "  --output FILE        write the report to FILE instead of standard output\n"
+        "  --help               print this text and exit\n";
+}
+
+/**
+ * @brief Quotes a string for JSON.
+ *
+ * @param text The string to quote.
+ * @return The string in double quotes, with quotes, backslashes and control characters escaped.
+ */
+static std::string json_string(const std::string & text)
+{
+    std::ostringstream quoted;
+    quoted << '"';
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            quoted << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            quoted << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        }
+        else
+        {
+            quoted << c;
+        }
+    }
+    quoted << '"';
+    return quoted.str();
+}
+
+/**
+ * @brief Checks whether any result has a hardware event count.
+ *
+ * @param results The results to check.
+ * @return true if the counter columns are worth writing; false otherwise.
+ */
+static bool any_counters(std::span<const BenchmarkResult> results)
+{
+    for (const BenchmarkResult & result : results)
+    {
+        for (const std::optional<double> & per_element : result.events_per_element)
+        {
+            if (per_element)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Checks whether any result has instrumentation counts.
+ *
+ * @param results The results to check.
+ * @return true if the instrumentation columns are worth writing; false otherwise.
+ */
+static bool any_stats(std::span<const BenchmarkResult> results)
+{
+    return std::any_of(results.begin(), results.end(),
+        [](const BenchmarkResult & result) { return result.stats.has_value(); });
+}
+
+/**
+ * @brief Returns the JSON and CSV field name of an event's per-element count.
+ *
+ * @param event The index of the event in HardwareEvent.
+ * @return The event name with underscores for hyphens, such as "branch_misses_per_element".
+ */
+static std::string per_element_field(int event)
+{
+    std::string name = PerfCounters::event_name(static_cast<HardwareEvent>(event));
+    std::replace(name.begin(), name.end(), '-', '_');
+    return name + "_per_element";
+}
+
+/**
+ * @brief Writes an optional number, or a placeholder if it is empty.
+ *
+ * @param out The stream to write to.
+ * @param value The number.
+ * @param missing What to write if @p value is empty.
+ */
+static void write_optional(std::ostream & out, const std::optional<double> & value, const char * missing)
+{
+    if (value)
+    {
+        out << *value;
+    }
+    else
+    {
+        out << missing;
+    }
+}
+
+void write_report(std::ostream & out, std::span<const BenchmarkResult> results, ReportFormat format)
+{
+    // Restored after every row, so one row's number formatting does not leak into the next.
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    bool with_stats = any_stats(results);
+    bool with_counters = any_counters(results);
+    if (format == ReportFormat::TABLE)
+    {
+        out << std::left << std::setw(8) << "type" << std::setw(16) << "sorter" << std::setw(15) << "distribution"
+            << std::right
+            << std::setw(12) << "size" << std::setw(6) << "reps" << std::setw(15) << "min ns"
+            << std::setw(15) << "median ns" << std::setw(15) << "p95 ns" << std::setw(14) << "Melem/s"
+            << std::setw(15) << "ns/(n log n)";
+        if (with_stats)
+        {
+            out << std::setw(15) << "comparisons" << std::setw(13) << "swaps" << std::setw(13) << "moves"
+                << std::setw(7) << "depth" << std::setw(14) << "scratch bytes";
+        }
+        if (with_counters)
+        {
+            out << std::setw(8) << "IPC";
+            for (int event = 0; event < NUM_HARDWARE_EVENTS; ++event)
+            {
+                out << std::setw(16) << std::string(PerfCounters::event_name(static_cast<HardwareEvent>(event))) + "/n";
+            }
+        }
+        out << std::endl;
+        for (const BenchmarkResult & result : results)
+        {
+            out << std::left << std::setw(8) << result.type << std::setw(16) << result.sorter
+                << std::setw(15) << result.distribution << std::right
+                << std::setw(12) << result.size << std::setw(6) << result.repetitions
+                << std::setw(15) << result.min_ns << std::setw(15) << result.median_ns
+                << std::setw(15) << result.p95_ns << std::fixed << std::setprecision(2)
+                << std::setw(14) << result.elements_per_second / 1e6
+                << std::setprecision(3) << std::setw(15) << result.ns_per_n_log_n;
+            if (with_stats)
+            {
+                SortStats stats = result.stats.value_or(SortStats());
+                out << std::setw(15) << stats.comparisons << std::setw(13) << stats.swaps << std::setw(13) << stats.moves
+                    << std::setw(7) << stats.max_recursion_depth << std::setw(14) << stats.allocated_bytes;
+            }
+            if (with_counters)
+            {
+                out << std::setprecision(2) << std::setw(8);
+                write_optional(out, result.instructions_per_cycle, "-");
+                out << std::setprecision(3);
+                for (const std::optional<double> & per_element : result.events_per_element)
+                {
+                    out << std::setw(16);
+                    write_optional(out, per_element, "-");
+                }
+            }
+            out << std::endl;
+            out.flags(flags);
+            out.precision(precision);
+        }
+    }
+    else if (format == ReportFormat::JSON)
+    {
+        out << "[" << std::endl;
+        for (std::size_t i = 0; i < results.size(); ++i)
+        {
+            const BenchmarkResult & result = results[i];
+            out << "  {\"type\": " << json_string(result.type) << ", \"sorter\": " << json_string(result.sorter)
+                << ", \"distribution\": " << json_string(result.distribution)
+                << ", \"size\": " << result.size << ", \"repetitions\": " << result.repetitions
+                << ", \"min_ns\": " << result.min_ns << ", \"median_ns\": " << result.median_ns
+                << ", \"p95_ns\": " << result.p95_ns << std::fixed << std::setprecision(1)
+                << ", \"elements_per_second\": " << result.elements_per_second << std::setprecision(4)
+                << ", \"ns_per_n_log_n\": " << result.ns_per_n_log_n;
+            if (result.stats)
+            {
+                out << ", \"comparisons\": " << result.stats->comparisons << ", \"swaps\": " << result.stats->swaps
+                    << ", \"moves\": " << result.stats->moves
+                    << ", \"max_recursion_depth\": " << result.stats->max_recursion_depth
+                    << ", \"allocated_bytes\": " << result.stats->allocated_bytes;
+            }
+            if (with_counters)
+            {
+                out << ", \"instructions_per_cycle\": ";
+                write_optional(out, result.instructions_per_cycle, "null");
+                for (int event = 0; event < NUM_HARDWARE_EVENTS; ++event)
+                {
+                    out << ", " << json_string(per_element_field(event)) << ": ";
+                    write_optional(out, result.events_per_element[event], "null");
+                }
+            }
+            out << "}" << (i + 1 < results.size() ? "," : "") << std::endl;
+            out.flags(flags);
+            out.precision(precision);
+        }
+        out << "]" << std::endl;
+    }
+    else
+    {
+        out << "type,sorter,distribution,size,repetitions,min_ns,median_ns,p95_ns,elements_per_second,ns_per_n_log_n";
+        if (with_stats)
+        {
+            out << ",comparisons,swaps,moves,max_recursion_depth,allocated_bytes";
+        }
+        if (with_counters)
+        {
+            out << ",instructions_per_cycle";
+            for (int event = 0; event < NUM_HARDWARE_EVENTS; ++event)
+            {
+                out << "," << per_element_field(event);
+            }
+        }
+        out << std::endl;
+        for (const BenchmarkResult & result : results)
+        {
+            out << result.type << "," << result.sorter << "," << result.distribution << "," << result.size << ","
+                << result.repetitions << "," << result.min_ns << "," << result.median_ns << "," << result.p95_ns
+                << std::fixed << std::setprecision(1) << "," << result.elements_per_second << std::setprecision(4)
+                << "," << result.ns_per_n_log_n;
+            if (with_stats)
+            {
+                SortStats stats = result.stats.value_or(SortStats());
+                out << "," << stats.comparisons << "," << stats.swaps << "," << stats.moves << ","
+                    << stats.max_recursion_depth << "," << stats.allocated_bytes;
+            }
+            if (with_counters)
+            {
+                out << ",";
+                write_optional(out, result.instructions_per_cycle, "");
+                for (const std::optional<double> & per_element : result.events_per_element)
+                {
+                    out << ",";
+                    write_optional(out, per_element, "");
+                }
+            }
+            out << std::endl;
+            out.flags(flags);
+            out.precision(precision);
+        }
+    }
+    out.flags(flags);
+}
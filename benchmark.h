@@ -0,0 +1,157 @@
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+#include "generator.h"
+#include "instrumentation.h"
+#include "perf_counters.h"
+#pragma once
+
+/**
+ * @brief Selects how write_report() lays out benchmark results.
+ */
+enum class ReportFormat
+{
+    /// Aligned columns for reading in a terminal.
+    TABLE = 0,
+    /// A JSON array with one object per result, for tracking results over time.
+    JSON = 1,
+    /// A header row followed by one row per result, for spreadsheets.
+    CSV = 2
+};
+
+/**
+ * @struct BenchmarkOptions
+ * @brief Describes which sorters run_benchmarks() times, on what inputs and how often.
+ */
+struct BenchmarkOptions
+{
+    /// Number of elements in each input, timed in this order.
+    std::vector<int> sizes;
+
+    /// The element type: int, int64, double, string or record.
+    std::string type;
+
+    /// Keys of the sorters to time, such as pdq or merge. Empty times every n log n sorter for the type.
+    std::vector<std::string> sorters;
+
+    /// The shapes of the inputs, each timed at every size.
+    std::vector<Distribution> distributions;
+
+    /// The seed and the parameters of the distributions. Its distribution is ignored.
+    DistributionSpec input;
+
+    /// Number of timed sorts of each input.
+    int repetitions;
+
+    /// Number of untimed sorts of each input before the timed ones.
+    int warmup;
+
+    /// true to count hardware events around every timed sort, where the system allows it.
+    bool counters;
+
+    /// How the results are written.
+    ReportFormat format;
+
+    /// The file the results are written to, or empty for standard output.
+    std::string output;
+
+    /// true if --help asked for the usage text instead of a benchmark.
+    bool help;
+};
+
+/**
+ * @struct BenchmarkResult
+ * @brief The timings of one sorter on one input.
+ */
+struct BenchmarkResult
+{
+    /// The element type that was sorted.
+    std::string type;
+
+    /// The key of the sorter that was timed.
+    std::string sorter;
+
+    /// The name of the distribution of the input.
+    std::string distribution;
+
+    /// Number of elements in the input.
+    int size;
+
+    /// Number of timed sorts.
+    int repetitions;
+
+    /// Fastest wall time of a sort, in nanoseconds.
+    std::int64_t min_ns;
+
+    /// Median wall time of a sort, in nanoseconds.
+    std::int64_t median_ns;
+
+    /// 95th percentile wall time of a sort, in nanoseconds.
+    std::int64_t p95_ns;
+
+    /// Elements sorted per second at the median time.
+    double elements_per_second;
+
+    /// Median time divided by n log2 n, which stays flat for an n log n sorter.
+    double ns_per_n_log_n;
+
+    /// Instructions retired per cycle, if both could be counted.
+    std::optional<double> instructions_per_cycle;
+
+    /// The mean count of each hardware event per element, indexed by HardwareEvent, if it could be counted.
+    std::optional<double> events_per_element[NUM_HARDWARE_EVENTS];
+
+    /// The work counted during the last timed sort, if the build is instrumented.
+    std::optional<SortStats> stats;
+};
+
+/**
+ * @brief Parses the command-line options of the bench command.
+ *
+ * Options the arguments leave out keep their defaults: sizes 1000 to 1000000 in
+ * steps of 10, int elements, every n log n sorter, uniform inputs, 10 repetitions
+ * after 1 warm-up, seed 1, no hardware counters and a table on standard output.
+ * --help takes no value and sets BenchmarkOptions::help.
+ *
+ * @param args The arguments that follow the command name.
+ * @return The parsed options.
+ * @throws std::runtime_error If an option is unknown, lacks a value or has a bad value.
+ */
+BenchmarkOptions parse_benchmark_options(std::span<char * const> args);
+
+/**
+ * @brief Returns a description of the options parse_benchmark_options() accepts.
+ *
+ * @return The usage text, one option per line.
+ */
+std::string benchmark_usage();
+
+/**
+ * @brief Times every selected sorter on an input of every selected distribution and size.
+ *
+ * Each sort runs on a fresh copy of the input, and only the sort itself is timed,
+ * on the wall clock. Every sorted copy is checked. When options.counters is set,
+ * hardware events are counted around every timed sort as well, and any event the
+ * system cannot count is left empty in the results. Builds with
+ * CPPSORT_INSTRUMENTATION also record the comparisons, swaps, moves, recursion
+ * depth and scratch bytes of the last timed sort.
+ *
+ * @param options What to time.
+ * @return One result per sorter, distribution and size, grouped by distribution and then size.
+ * @throws std::runtime_error If the type or a sorter key is unknown, or a sorter leaves an input unsorted.
+ */
+std::vector<BenchmarkResult> run_benchmarks(const BenchmarkOptions & options);
+
+/**
+ * @brief Writes benchmark results in the given format.
+ *
+ * The instrumentation and hardware counter columns are only written if some result has them.
+ *
+ * @param out The stream to write to.
+ * @param results The results to write.
+ * @param format The layout of the results.
+ */
+void write_report(std::ostream & out, std::span<const BenchmarkResult> results, ReportFormat format);
@@ -1,13 +1,15 @@
+#include <functional>
 #include <span>
 #include "common.h"
 #pragma once
 
-template <typename T>
+template <typename T, typename Compare = std::less<T>>
 /**
  * @class BubbleSorter
  * @brief Implements the bubble sort algorithm for sorting arrays.
  * 
  * @tparam T The type of elements to sort.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
  *
  * Inherits from the Sorter base class and provides an implementation of the
  * bubble sort algorithm. The class supports sorting arrays using
@@ -16,6 +18,9 @@ template <typename T>
 class BubbleSorter : virtual public Sorter<T>
 {
 protected:
+    /// Orders the elements.
+    [[no_unique_address]] InstrumentedCompare<Compare> compare_;
+
     /**
      * @brief Sorts the given array using bubble sort going from left-to-right.
      *
@@ -30,26 +35,29 @@ public:
      *
      * This constructor initializes the BubbleSorter by calling the base Sorter
      * class constructor with the sorting algorithm name "Bubble".
+     *
+     * @param compare The comparator used to order the elements.
      */
-    BubbleSorter() : Sorter<T>("Bubble") {}
+    BubbleSorter(Compare compare = Compare()) : Sorter<T>("Bubble"), compare_(compare) {}
 
     /**
      * @brief Sorts the given array in-place using a specific sorting algorithm.
      * 
      * This function overrides a virtual method from a base class and sorts the elements
-     * of the provided std::span<T> in ascending order.
+     * of the provided std::span<T> in the order given by Compare.
      * 
      * @param ary A std::span<T> representing the array to be sorted.
      */
     void sort(std::span<T> ary) const override;
 };
 
-template <typename T>
+template <typename T, typename Compare = std::less<T>>
 /**
  * @class CocktailShakerSorter
  * @brief Implements the cocktail shaker sort algorithm, a bidirectional variant of bubble sort.
  * 
  * @tparam T The type of elements to sort.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
  *
  * Inherits from BubbleSorter and provides an implementation of the cocktail shaker sort,
  * which sorts the array in both directions on each pass through the list, improving performance
@@ -57,7 +65,7 @@ template <typename T>
  *
  * @note The class overrides the sort method to perform cocktail shaker sorting.
  */
-class CocktailShakerSorter : public BubbleSorter<T>
+class CocktailShakerSorter : public BubbleSorter<T, Compare>
 {
 private:
     /**
@@ -74,16 +82,92 @@ public:
      *
      * This constructor initializes the CocktailShakerSorter by calling the base Sorter
      * class constructor with the sorting algorithm name "CocktailShaker".
+     *
+     * @param compare The comparator used to order the elements.
      */
-    CocktailShakerSorter() : Sorter<T>("Cocktail Shaker") {}
+    CocktailShakerSorter(Compare compare = Compare())
+        : Sorter<T>("Cocktail Shaker"), BubbleSorter<T, Compare>(compare) {}
 
     /**
      * @brief Sorts the given array in-place using a specific sorting algorithm.
      * 
      * This function overrides a virtual method from a base class and sorts the elements
-     * of the provided std::span<T> in ascending order.
+     * of the provided std::span<T> in the order given by Compare.
      * 
      * @param ary A std::span<T> representing the array to be sorted.
      */
     void sort(std::span<T> ary) const override;
 };
+
+template <typename T, typename Compare>
+bool BubbleSorter<T, Compare>::ltr_sort(std::span<T> ary) const
+{
+    bool swapped = false;
+    int count = ary.size();
+    for (int i = 1; i < count; ++i)
+    {
+        if (compare_(ary[i], ary[i - 1]))
+        {
+            this->swap_values(ary, i - 1, i);
+            swapped = true;
+        }
+    }
+    return swapped;
+}
+
+template <typename T, typename Compare>
+bool CocktailShakerSorter<T, Compare>::rtl_sort(std::span<T> ary) const
+{
+    int count = ary.size();
+    bool swapped = false;
+    for (int i = count - 1; i > 0; --i)
+    {
+        if (this->compare_(ary[i], ary[i - 1]))
+        {
+            this->swap_values(ary, i - 1, i);
+            swapped = true;
+        }
+    }
+    return swapped;
+}
+
+template <typename T, typename Compare>
+void BubbleSorter<T, Compare>::sort(std::span<T> ary) const
+{
+    int count = ary.size();
+    if (count < 2)
+    {
+        return;
+    }
+
+    while(ltr_sort(ary));
+}
+
+template <typename T, typename Compare>
+void CocktailShakerSorter<T, Compare>::sort(std::span<T> ary) const
+{
+    int count = ary.size();
+    if (count < 2)
+    {
+        return;
+    }
+
+    /* By applying a bitmask of 1 less than a power of 2, I can cleanly
+    * alternate sorting left to right followed by right to left. */
+    const int BITMASK = 1;
+    // One can't put member functions directly in the array,
+    // so use a lambda to wrap them.
+    std::function<bool(std::span<T>)> cmp[2] = { 
+        [this](std::span<T> ary) { return this->ltr_sort(ary); }, 
+        [this](std::span<T> ary) { return rtl_sort(ary); } 
+    };
+    int i = 0;
+    while (true)
+    {
+        if (!cmp[i](ary))
+        {
+            break;
+        }
+        i = (i + 1) & BITMASK;
+    }
+}
@@ -1,7 +1,26 @@
+#include <functional>
 #include <memory>
 #include <span>
+#include <utility>
+#include "instrumentation.h"
 #pragma once
 
+/**
+ * @brief Describes the order in which a sorter touches the elements of the array.
+ *
+ * A sorter sorting a memory-mapped file reports this so the kernel can be told
+ * how to page the file in.
+ */
+enum class AccessPattern
+{
+    /// No particular order, or a mix such as partitioning inwards from both ends.
+    NORMAL = 0,
+    /// Whole passes from the front of the array to the back.
+    SEQUENTIAL = 1,
+    /// Jumps between distant elements, so reading ahead wastes I/O.
+    RANDOM = 2
+};
+
 template <typename T>
 /**
  * @class Sorter
@@ -13,6 +32,11 @@ template <typename T>
  * different sorting algorithms. Derived classes must implement the
  * pure virtual sort() method.
  *
+ * The ordering is not part of this interface. Each derived class takes it as a
+ * Compare template parameter so comparisons in the inner loops are inlined, and
+ * this class serves as the type-erased facade for code that picks a sorter at
+ * runtime.
+ *
  * @note This class is not intended to be instantiated directly.
  */
 class Sorter
@@ -23,7 +47,7 @@ class Sorter
 
 protected:
     /**
-     * @brief Swaps the values at two specified indices in the given array.
+     * @brief Swaps the values at two specified indices in the given array by moving them.
      *
      * @param ary A std::span<T> representing the array.
      * @param x Index of the first element to swap.
@@ -39,6 +63,11 @@ public:
      */
     Sorter(const char * name) : name_(name) {}
 
+    /**
+     * @brief Destroys the Sorter. Virtual so sorters can be owned through a pointer to this class.
+     */
+    virtual ~Sorter() = default;
+
     /**
      * @brief Returns the name associated with the object.
      * 
@@ -55,4 +84,71 @@ public:
      * @param ary A std::span<T> representing the array to be sorted.
      */
     virtual void sort(std::span<T> ary) const = 0;
+
+    /**
+     * @brief Returns the order in which sort() touches the elements of the array.
+     *
+     * @return AccessPattern::NORMAL unless a derived class knows better.
+     */
+    virtual AccessPattern access_pattern() const
+    {
+        return AccessPattern::NORMAL;
+    }
+};
+
+template <typename T>
+void Sorter<T>::swap_values(std::span<T> ary, int x, int y) const
+{
+    if (x == y)
+    {
+        return;
+    }
+    Instrumentation::count_swap();
+    std::swap(ary[x], ary[y]);
+}
+
+template <typename T>
+const char * Sorter<T>::name() const
+{
+    return name_;
+}
+
+template <typename Projection, typename Compare = std::less<>>
+/**
+ * @struct ProjectedCompare
+ * @brief A comparator that orders elements by a key projected from each of them.
+ *
+ * @tparam Projection A function object, or pointer to member, that returns the key of an element.
+ * @tparam Compare The comparator applied to the projected keys.
+ *
+ * Any sorter can order by a projected key by taking this as its Compare parameter.
+ * Both the projection and the comparison are known at compile time, so they are
+ * inlined into the sorter's inner loops.
+ *
+ * @section Example
+ * @code
+ * using ByKey = ProjectedCompare<decltype(&Record::key)>;
+ * PdqSorter<Record, ByKey> sorter(ByKey{&Record::key});
+ * @endcode
+ */
+struct ProjectedCompare
+{
+    /// Returns the key an element is ordered by.
+    [[no_unique_address]] Projection projection;
+
+    /// Orders two keys.
+    [[no_unique_address]] Compare compare;
+
+    /**
+     * @brief Compares two elements by their projected keys.
+     *
+     * @param x The first element.
+     * @param y The second element.
+     * @return true if the key of @p x is ordered before the key of @p y; false otherwise.
+     */
+    template <typename T>
+    bool operator()(const T & x, const T & y) const
+    {
+        return compare(std::invoke(projection, x), std::invoke(projection, y));
+    }
 };
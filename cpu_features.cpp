@@ -0,0 +1,11 @@
+#include "cpu_features.h"
+
+bool cpu_supports_avx2()
+{
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+/**
+ * @brief Reports whether the processor running the program supports AVX2.
+ *
+ * The answer is worked out once and cached. Compilers without a way to query
+ * the processor always report false, which keeps callers on their scalar paths.
+ *
+ * @return true if AVX2 instructions can be executed; false otherwise.
+ */
+bool cpu_supports_avx2();
@@ -0,0 +1,340 @@
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#pragma once
+
+template <typename T, int D = 4, typename Compare = std::less<T>>
+/**
+ * @class DAryHeap
+ * @brief A fixed-capacity priority queue where every node has D children.
+ *
+ * @tparam T The type of elements stored in the heap.
+ * @tparam D The number of children per node, a power of two such as 2, 4 or 8.
+ * @tparam Compare A function object where Compare(x, y) is true if x should leave the
+ * heap before y. The default, std::less<T>, makes a min heap like Heap<T>.
+ *
+ * A wider node makes the heap shallower, so a sift touches fewer levels. The storage
+ * is aligned to a cache line and offset so the children of every node start on a
+ * multiple of D elements, which keeps each group of siblings within one cache line
+ * whenever D * sizeof(T) is no more than 64 bytes. Every sift level therefore costs
+ * at most one cache miss. The comparator is a template parameter, so comparisons are
+ * inlined rather than made through a virtual call.
+ *
+ * Unlike Heap<T>, peek() and take() return the element directly rather than as a
+ * std::optional, so callers must check empty() first.
+ *
+ * The members are defined in this header so the heap can hold any element type with
+ * any comparator.
+ *
+ * @section Example
+ * @code
+ * DAryHeap<int, 4> heap(100);
+ * heap.store(42);
+ * int top = heap.peek();
+ * int removed = heap.take();
+ * @endcode
+ */
+class DAryHeap
+{
+    static_assert(D >= 2 && (D & (D - 1)) == 0, "DAryHeap arity must be a power of two");
+
+    /// Byte alignment of the storage, which is at least one cache line.
+    static constexpr std::size_t ALIGNMENT = std::max<std::size_t>(64, alignof(T));
+
+    /// Number of unused slots before the root that line up each group of siblings.
+    static constexpr int PADDING = D - 1;
+
+    /**
+     * @brief Destroys the elements and releases the aligned storage.
+     */
+    struct AlignedDeleter
+    {
+        /// Number of elements constructed in the storage, padding included.
+        std::size_t count;
+
+        void operator()(T * ptr) const
+        {
+            std::destroy_n(ptr, count);
+            ::operator delete(ptr, std::align_val_t(ALIGNMENT));
+        }
+    };
+
+    /// Owns the aligned storage, including the padding before the root.
+    std::unique_ptr<T, AlignedDeleter> storage_;
+
+    /// Points at the root, so data_[i] is the element with 0-based index i.
+    T * data_;
+
+    /// The maximum number of elements the heap can hold.
+    int capacity_;
+
+    /// The current number of elements in the heap.
+    int size_;
+
+    /// Orders the elements.
+    [[no_unique_address]] Compare compare_;
+
+    /**
+     * @brief Moves a value up from a hole until its parent should leave the heap first.
+     *
+     * @param hole The index of the hole, whose current value is ignored.
+     * @param value The value to place.
+     */
+    void sift_up(int hole, T value);
+
+    /**
+     * @brief Moves a value down from a hole until none of its children should leave the heap first.
+     *
+     * @param hole The index of the hole, whose current value is ignored.
+     * @param value The value to place.
+     */
+    void sift_down(int hole, T value);
+
+    /**
+     * @brief Throws if the heap cannot take the given number of extra elements.
+     *
+     * @param num_extra The number of elements about to be stored.
+     * @throws std::runtime_error If the capacity would be exceeded.
+     */
+    void check_capacity(int num_extra) const;
+
+public:
+    /**
+     * @brief Constructs an empty heap able to hold the given number of elements.
+     *
+     * @param capacity The maximum number of elements the heap can hold.
+     * @param compare The comparator used to order the elements.
+     */
+    DAryHeap(int capacity, Compare compare = Compare());
+
+    /**
+     * @brief Returns the number of elements in the heap.
+     *
+     * @return The number of elements.
+     */
+    int size() const
+    {
+        return size_;
+    }
+
+    /**
+     * @brief Returns the maximum number of elements the heap can hold.
+     *
+     * @return The capacity.
+     */
+    int capacity() const
+    {
+        return capacity_;
+    }
+
+    /**
+     * @brief Checks whether the heap holds no elements.
+     *
+     * @return true if the heap is empty; false otherwise.
+     */
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    /**
+     * @brief Returns the element at the top of the heap without removing it.
+     *
+     * @return A constant reference to the top element.
+     * @note The heap must not be empty.
+     */
+    const T & peek() const
+    {
+        return data_[0];
+    }
+
+    /**
+     * @brief Stores a value in the heap.
+     *
+     * @param value The value to store.
+     * @throws std::runtime_error If the heap is full.
+     */
+    void store(T value);
+
+    /**
+     * @brief Stores a batch of values in the heap.
+     *
+     * When the batch is at least as large as the heap already is, the values are
+     * appended and the whole heap is rebuilt bottom-up in O(n). Smaller batches are
+     * stored one at a time.
+     *
+     * @param values The values to store.
+     * @throws std::runtime_error If the heap cannot hold all of the values.
+     */
+    void store(std::span<const T> values);
+
+    /**
+     * @brief Removes and returns the top element.
+     *
+     * @return The element that was at the top of the heap.
+     * @note The heap must not be empty.
+     */
+    T take();
+
+    /**
+     * @brief Removes the top element and stores a new value in a single sift.
+     *
+     * This is cheaper than take() followed by store(), which is the usual pattern
+     * when a timer fires and is rescheduled.
+     *
+     * @param value The value to store.
+     * @return The element that was at the top of the heap.
+     * @note The heap must not be empty.
+     */
+    T replace_top(T value);
+};
+
+template <typename T, int D, typename Compare>
+DAryHeap<T, D, Compare>::DAryHeap(int capacity, Compare compare)
+    : data_(nullptr), capacity_(std::max(capacity, 0)), size_(0), compare_(compare)
+{
+    std::size_t num_slots = capacity_ + PADDING;
+    T * ptr = static_cast<T *>(::operator new(num_slots * sizeof(T), std::align_val_t(ALIGNMENT)));
+    try
+    {
+        std::uninitialized_default_construct_n(ptr, num_slots);
+    }
+    catch (...)
+    {
+        ::operator delete(ptr, std::align_val_t(ALIGNMENT));
+        throw;
+    }
+    storage_ = std::unique_ptr<T, AlignedDeleter>(ptr, AlignedDeleter{num_slots});
+    /* With the root PADDING slots in, the children of node i, which are
+     * D * i + 1 to D * i + D, sit at slots D * (i + 1) onwards. */
+    data_ = ptr + PADDING;
+}
+
+template <typename T, int D, typename Compare>
+void DAryHeap<T, D, Compare>::check_capacity(int num_extra) const
+{
+    if (num_extra > capacity_ - size_)
+    {
+        throw std::runtime_error("Number of elements exceeds DAryHeap capacity of " + std::to_string(capacity_));
+    }
+}
+
+template <typename T, int D, typename Compare>
+void DAryHeap<T, D, Compare>::sift_up(int hole, T value)
+{
+    while (hole > 0)
+    {
+        int parent = (hole - 1) / D;
+        if (!compare_(value, data_[parent]))
+        {
+            break;
+        }
+        data_[hole] = std::move(data_[parent]);
+        hole = parent;
+    }
+    data_[hole] = std::move(value);
+}
+
+template <typename T, int D, typename Compare>
+void DAryHeap<T, D, Compare>::sift_down(int hole, T value)
+{
+    while (true)
+    {
+        int first_child = D * hole + 1;
+        if (first_child >= size_)
+        {
+            break;
+        }
+
+        int best = first_child;
+        if (first_child + D <= size_)
+        {
+            // A full group of siblings has a fixed trip count, so the loop unrolls.
+            for (int i = 1; i < D; ++i)
+            {
+                if (compare_(data_[first_child + i], data_[best]))
+                {
+                    best = first_child + i;
+                }
+            }
+        }
+        else
+        {
+            for (int child = first_child + 1; child < size_; ++child)
+            {
+                if (compare_(data_[child], data_[best]))
+                {
+                    best = child;
+                }
+            }
+        }
+
+        if (!compare_(data_[best], value))
+        {
+            break;
+        }
+        data_[hole] = std::move(data_[best]);
+        hole = best;
+    }
+    data_[hole] = std::move(value);
+}
+
+template <typename T, int D, typename Compare>
+void DAryHeap<T, D, Compare>::store(T value)
+{
+    check_capacity(1);
+    sift_up(size_++, std::move(value));
+}
+
+template <typename T, int D, typename Compare>
+void DAryHeap<T, D, Compare>::store(std::span<const T> values)
+{
+    int num_values = values.size();
+    check_capacity(num_values);
+    if (num_values == 0)
+    {
+        // Heapifying would otherwise sift an empty heap's unconstructed first slot into itself.
+        return;
+    }
+    if (num_values < size_)
+    {
+        for (const T & value : values)
+        {
+            sift_up(size_++, value);
+        }
+        return;
+    }
+
+    std::copy(values.begin(), values.end(), data_ + size_);
+    size_ += num_values;
+    for (int i = (size_ - 2) / D; i >= 0; --i)
+    {
+        sift_down(i, std::move(data_[i]));
+    }
+}
+
+template <typename T, int D, typename Compare>
+T DAryHeap<T, D, Compare>::take()
+{
+    T top = std::move(data_[0]);
+    --size_;
+    if (size_ > 0)
+    {
+        sift_down(0, std::move(data_[size_]));
+    }
+    return top;
+}
+
+template <typename T, int D, typename Compare>
+T DAryHeap<T, D, Compare>::replace_top(T value)
+{
+    T top = std::move(data_[0]);
+    sift_down(0, std::move(value));
+    return top;
+}
@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "common.h"
+#include "file_stream.h"
+#include "loser_tree.h"
+#include "managed_dynamic_array.h"
+#pragma once
+
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @class ExternalSorter
+ * @brief Sorts a binary file of fixed-size elements that may be far larger than memory.
+ *
+ * @tparam T The trivially copyable type of the elements, stored in the file in native byte order.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
+ *
+ * The input is read in chunks that fit the memory budget. Each chunk is sorted with
+ * an in-memory sorter and written to a run file in a private temporary directory.
+ * Two chunk buffers are used, so a background thread writes one sorted chunk while
+ * the next one is read and sorted. The runs are then combined by a k-way merge
+ * through a LoserTree, which costs log2(k) comparisons per element, with the budget
+ * split into one large sequential buffer per run plus one for the output. When
+ * there are too many runs to give each a buffer of at least MIN_MERGE_BUFFER_BYTES,
+ * groups of runs are merged into longer runs first. Elements from earlier runs win
+ * ties, so the sort is stable if the chunk sorter is.
+ *
+ * An input that fits in a single chunk is sorted and written straight to the output
+ * without a run file.
+ *
+ * @note The chunk_sorter reference must remain valid for the lifetime of the ExternalSorter instance,
+ * and it must sort in the same order as Compare.
+ *
+ * @section Example
+ * @code
+ * PdqSorter<int> pdq_sorter;
+ * ExternalSorter<int> sorter(pdq_sorter, 512 << 20);
+ * sorter.sort("unsorted.bin", "sorted.bin");
+ * @endcode
+ */
+class ExternalSorter
+{
+    static_assert(std::is_trivially_copyable_v<T>, "ExternalSorter only sorts trivially copyable types");
+
+    /// Reference to the sorter used for each chunk.
+    std::reference_wrapper<const Sorter<T>> chunk_sorter_;
+
+    /// Number of bytes of elements held in memory at once.
+    std::size_t memory_budget_;
+
+    /// The directory the temporary directory for the run files is created in.
+    std::filesystem::path temp_dir_;
+
+    /// Orders the elements.
+    [[no_unique_address]] Compare compare_;
+
+    /**
+     * @brief Returns how many elements fit in a share of a memory budget, capped to an int.
+     *
+     * @param num_bytes The number of bytes available.
+     * @param element_size The size of one element.
+     * @return The number of elements, at least one.
+     */
+    static int elements_in(std::size_t num_bytes, std::size_t element_size)
+    {
+        return std::clamp<std::size_t>(num_bytes / element_size, 1, INT_MAX);
+    }
+
+    /**
+     * @brief Merges sorted run files into a single sorted file.
+     *
+     * @param runs The run files, in the order they were written.
+     * @param output The file to write the merged elements to.
+     * @param buffer_size Number of elements in the read buffer of each run and in the output buffer.
+     */
+    void merge_runs(const std::vector<std::filesystem::path> & runs, const std::filesystem::path & output,
+        int buffer_size) const;
+
+public:
+    /// Default number of bytes of elements held in memory at once.
+    static constexpr std::size_t DEFAULT_MEMORY_BUDGET = std::size_t(256) << 20;
+
+    /// The smallest read buffer given to a run while merging, so reads stay large and sequential.
+    static constexpr std::size_t MIN_MERGE_BUFFER_BYTES = std::size_t(1) << 20;
+
+    /**
+     * @brief Constructs an ExternalSorter.
+     *
+     * @param chunk_sorter Constant reference to a Sorter used for each chunk.
+     * @param memory_budget Number of bytes of elements held in memory at once.
+     * @param temp_dir The directory the run files are written under.
+     * @param compare The comparator used to order the elements.
+     * @throws std::runtime_error If the budget is too small to merge two runs.
+     */
+    ExternalSorter(const Sorter<T> & chunk_sorter, std::size_t memory_budget = DEFAULT_MEMORY_BUDGET,
+        std::filesystem::path temp_dir = std::filesystem::temp_directory_path(), Compare compare = Compare());
+
+    /**
+     * @brief Returns the number of bytes of elements held in memory at once.
+     *
+     * @return The memory budget.
+     */
+    std::size_t memory_budget() const
+    {
+        return memory_budget_;
+    }
+
+    /**
+     * @brief Sorts the elements of one file into another.
+     *
+     * The run files and their directory are removed afterwards, even if sorting fails.
+     *
+     * @param input The file to sort, whose size must be a multiple of sizeof(T).
+     * @param output The file to write the sorted elements to. It is replaced if it exists,
+     * and it must not be the same file as @p input.
+     * @throws std::runtime_error If a file cannot be opened, read or written, or if the
+     * size of @p input is not a multiple of sizeof(T).
+     */
+    void sort(const std::filesystem::path & input, const std::filesystem::path & output) const;
+};
+
+template <typename T, typename Compare>
+ExternalSorter<T, Compare>::ExternalSorter(const Sorter<T> & chunk_sorter, std::size_t memory_budget,
+    std::filesystem::path temp_dir, Compare compare)
+    : chunk_sorter_(chunk_sorter), memory_budget_(memory_budget), temp_dir_(std::move(temp_dir)), compare_(compare)
+{
+    if (memory_budget_ < 3 * MIN_MERGE_BUFFER_BYTES)
+    {
+        throw std::runtime_error("ExternalSorter needs a memory budget of at least "
+            + std::to_string(3 * MIN_MERGE_BUFFER_BYTES) + " bytes");
+    }
+}
+
+template <typename T, typename Compare>
+void ExternalSorter<T, Compare>::merge_runs(const std::vector<std::filesystem::path> & runs,
+    const std::filesystem::path & output, int buffer_size) const
+{
+    kway_merge<T, Compare>(runs, output, buffer_size, compare_);
+}
+
+template <typename T, typename Compare>
+void ExternalSorter<T, Compare>::sort(const std::filesystem::path & input, const std::filesystem::path & output) const
+{
+    std::uintmax_t input_bytes = std::filesystem::file_size(input);
+    if (input_bytes % sizeof(T) != 0)
+    {
+        throw std::runtime_error(input.string() + " does not hold a whole number of "
+            + std::to_string(sizeof(T)) + "-byte elements");
+    }
+    FilePtr in = open_file(input, "rb");
+
+    std::uintmax_t num_elements = input_bytes / sizeof(T);
+    if (num_elements <= static_cast<std::uintmax_t>(elements_in(memory_budget_, sizeof(T))))
+    {
+        ManagedDynamicArray<T> all(num_elements);
+        int count = read_elements(in.get(), all.to_span(), input);
+        std::span<T> elements = all.to_span(count);
+        chunk_sorter_.get().sort(elements);
+        FilePtr out = open_file(output, "wb");
+        write_elements<T>(out.get(), elements, output);
+        return;
+    }
+
+    // Declared first so it is removed last, after every run file is closed.
+    TempDirectory run_dir(temp_dir_);
+    std::vector<std::filesystem::path> runs;
+    {
+        // Half the budget goes to each chunk so one can be written while the next is sorted.
+        int chunk_size = elements_in(memory_budget_ / 2, sizeof(T));
+        ManagedDynamicArray<T> chunk_buffers[] = {ManagedDynamicArray<T>(chunk_size), ManagedDynamicArray<T>(chunk_size)};
+        // Declared after the buffers so a failure waits for the write before freeing them.
+        std::future<void> writing;
+        for (int which = 0; ; which ^= 1)
+        {
+            int count = read_elements(in.get(), chunk_buffers[which].to_span(), input);
+            if (count == 0)
+            {
+                break;
+            }
+            std::span<T> chunk = chunk_buffers[which].to_span(count);
+            chunk_sorter_.get().sort(chunk);
+            if (writing.valid())
+            {
+                writing.get();
+            }
+            runs.push_back(run_dir.path() / ("run-" + std::to_string(runs.size())));
+            writing = std::async(std::launch::async, [chunk, path = runs.back()]()
+            {
+                FilePtr out = open_file(path, "wb");
+                write_elements<T>(out.get(), chunk, path);
+            });
+        }
+        if (writing.valid())
+        {
+            writing.get();
+        }
+    }
+    in.reset();
+
+    // Every run being merged, and the output, gets an equal share of the budget.
+    int max_fan_in = memory_budget_ / MIN_MERGE_BUFFER_BYTES - 1;
+    for (int pass = 0; static_cast<int>(runs.size()) > max_fan_in; ++pass)
+    {
+        int num_runs = runs.size();
+        int num_groups = (num_runs + max_fan_in - 1) / max_fan_in;
+        std::vector<std::filesystem::path> merged;
+        for (int group = 0; group < num_groups; ++group)
+        {
+            // Consecutive runs are merged together so earlier runs still win ties.
+            std::vector<std::filesystem::path> group_runs(runs.begin() + static_cast<long>(num_runs) * group / num_groups,
+                runs.begin() + static_cast<long>(num_runs) * (group + 1) / num_groups);
+            merged.push_back(run_dir.path() / ("pass-" + std::to_string(pass) + "-run-" + std::to_string(group)));
+            int group_size = group_runs.size();
+            merge_runs(group_runs, merged.back(), elements_in(memory_budget_ / (group_size + 1), sizeof(T)));
+            for (const std::filesystem::path & run : group_runs)
+            {
+                std::filesystem::remove(run);
+            }
+        }
+        runs = std::move(merged);
+    }
+    int num_runs = runs.size();
+    merge_runs(runs, output, elements_in(memory_budget_ / (num_runs + 1), sizeof(T)));
+}
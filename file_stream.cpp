@@ -0,0 +1,60 @@
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include "file_stream.h"
+
+#if defined(__unix__)
+#define CPPSORT_HAVE_FADVISE 1
+#include <fcntl.h>
+#endif
+
+static const int TEMP_DIR_ATTEMPTS = 100;
+
+FilePtr open_file(const std::filesystem::path & path, const char * mode)
+{
+    FilePtr file(std::fopen(path.c_str(), mode));
+    if (!file)
+    {
+        throw std::runtime_error("Could not open " + path.string());
+    }
+    std::setvbuf(file.get(), nullptr, _IONBF, 0);
+    return file;
+}
+
+void advise_sequential([[maybe_unused]] std::FILE * file)
+{
+#ifdef CPPSORT_HAVE_FADVISE
+    ::posix_fadvise(::fileno(file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+}
+
+void advise_will_need([[maybe_unused]] std::FILE * file, [[maybe_unused]] std::int64_t offset,
+    [[maybe_unused]] std::size_t num_bytes)
+{
+#ifdef CPPSORT_HAVE_FADVISE
+    ::posix_fadvise(::fileno(file), offset, num_bytes, POSIX_FADV_WILLNEED);
+#endif
+}
+
+TempDirectory::TempDirectory(const std::filesystem::path & parent)
+{
+    std::random_device random;
+    for (int i = 0; i < TEMP_DIR_ATTEMPTS; ++i)
+    {
+        std::filesystem::path candidate = parent / ("cppsort-" + std::to_string(random()));
+        std::error_code error;
+        if (std::filesystem::create_directory(candidate, error))
+        {
+            path_ = candidate;
+            return;
+        }
+    }
+    throw std::runtime_error("Could not create a temporary directory in " + parent.string());
+}
+
+TempDirectory::~TempDirectory()
+{
+    std::error_code error;
+    std::filesystem::remove_all(path_, error);
+}
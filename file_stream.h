@@ -0,0 +1,133 @@
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#pragma once
+
+/**
+ * @brief Closes a C stream when the std::unique_ptr owning it is destroyed.
+ */
+struct FileCloser
+{
+    void operator()(std::FILE * file) const
+    {
+        std::fclose(file);
+    }
+};
+
+/// An open C stream that is closed automatically.
+using FilePtr = std::unique_ptr<std::FILE, FileCloser>;
+
+/**
+ * @brief Opens a file for unbuffered binary access.
+ *
+ * The callers read and write through buffers of their own that are far larger than
+ * the one stdio would add, so stdio's buffering only costs an extra copy.
+ *
+ * @param path The file to open.
+ * @param mode The fopen mode, such as "rb" or "wb".
+ * @return The open stream.
+ * @throws std::runtime_error If the file cannot be opened.
+ */
+FilePtr open_file(const std::filesystem::path & path, const char * mode);
+
+/**
+ * @brief Tells the operating system a file will be read from start to end.
+ *
+ * It may then read ahead more aggressively. Does nothing where posix_fadvise() is missing.
+ *
+ * @param file The stream that will be read.
+ */
+void advise_sequential(std::FILE * file);
+
+/**
+ * @brief Tells the operating system a range of a file will be read soon.
+ *
+ * It may then start reading the range into the page cache in the background.
+ * Does nothing where posix_fadvise() is missing.
+ *
+ * @param file The stream that will be read.
+ * @param offset Byte offset of the range.
+ * @param num_bytes Length of the range in bytes.
+ */
+void advise_will_need(std::FILE * file, std::int64_t offset, std::size_t num_bytes);
+
+/**
+ * @class TempDirectory
+ * @brief A uniquely named directory that is removed, along with everything in it, when destroyed.
+ */
+class TempDirectory
+{
+    /// The directory that was created.
+    std::filesystem::path path_;
+
+public:
+    /**
+     * @brief Creates a new directory with a random name.
+     *
+     * @param parent The directory to create it in.
+     * @throws std::runtime_error If no directory could be created.
+     */
+    explicit TempDirectory(const std::filesystem::path & parent);
+
+    TempDirectory(const TempDirectory &) = delete;
+    TempDirectory & operator=(const TempDirectory &) = delete;
+
+    ~TempDirectory();
+
+    /**
+     * @brief Returns the directory that was created.
+     *
+     * @return The path of the directory.
+     */
+    const std::filesystem::path & path() const
+    {
+        return path_;
+    }
+};
+
+template <typename T>
+/**
+ * @brief Reads as many elements as are left in a file, up to the size of a buffer.
+ *
+ * @param file The stream to read from.
+ * @param buffer The buffer to fill.
+ * @param path The name of the file, for error messages.
+ * @return The number of elements read, which is zero at the end of the file.
+ * @throws std::runtime_error If the read fails or the file ends part way through an element.
+ */
+int read_elements(std::FILE * file, std::span<T> buffer, const std::filesystem::path & path);
+
+template <typename T>
+/**
+ * @brief Writes every element of a span to a file.
+ *
+ * @param file The stream to write to.
+ * @param elements The elements to write.
+ * @param path The name of the file, for error messages.
+ * @throws std::runtime_error If the write fails.
+ */
+void write_elements(std::FILE * file, std::span<const T> elements, const std::filesystem::path & path);
+
+template <typename T>
+int read_elements(std::FILE * file, std::span<T> buffer, const std::filesystem::path & path)
+{
+    std::size_t num_bytes = std::fread(buffer.data(), 1, buffer.size_bytes(), file);
+    if (std::ferror(file) || num_bytes % sizeof(T) != 0)
+    {
+        throw std::runtime_error("Could not read " + path.string());
+    }
+    return num_bytes / sizeof(T);
+}
+
+template <typename T>
+void write_elements(std::FILE * file, std::span<const T> elements, const std::filesystem::path & path)
+{
+    if (std::fwrite(elements.data(), 1, elements.size_bytes(), file) != elements.size_bytes())
+    {
+        throw std::runtime_error("Could not write " + path.string());
+    }
+}
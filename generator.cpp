@@ -0,0 +1,325 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "generator.h"
+#include "record.h"
+
+/// The names of the distributions, in the order of Distribution.
+static const char * const DISTRIBUTION_NAMES[NUM_DISTRIBUTIONS] = {
+    "uniform", "sorted", "reversed", "organ-pipe", "sawtooth", "nearly-sorted", "few-unique", "all-equal", "zipf"
+};
+
+/**
+ * @brief Advances a SplitMix64 state and returns its next output.
+ *
+ * @param state The state to advance.
+ * @return The next 64 bits of the sequence.
+ */
+static std::uint64_t splitmix64(std::uint64_t & state)
+{
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+Xoshiro256::Xoshiro256(std::uint64_t seed)
+{
+    for (std::uint64_t & word : state_)
+    {
+        word = splitmix64(seed);
+    }
+}
+
+Xoshiro256::Xoshiro256(std::uint64_t seed, std::uint64_t stream)
+{
+    // Stepping the hashed seed by the stream, rather than xoring two hashes, keeps (a, b) apart from (b, a).
+    std::uint64_t stepped = splitmix64(seed) + stream * 0x9e3779b97f4a7c15;
+    std::uint64_t mixed = splitmix64(stepped);
+    for (std::uint64_t & word : state_)
+    {
+        word = splitmix64(mixed);
+    }
+}
+
+const char * distribution_name(Distribution distribution)
+{
+    return DISTRIBUTION_NAMES[static_cast<int>(distribution)];
+}
+
+Distribution parse_distribution(const std::string & name)
+{
+    for (int i = 0; i < NUM_DISTRIBUTIONS; ++i)
+    {
+        if (name == DISTRIBUTION_NAMES[i])
+        {
+            return static_cast<Distribution>(i);
+        }
+    }
+    throw std::runtime_error("Unknown distribution " + name);
+}
+
+/**
+ * @class ZipfSampler
+ * @brief Draws ranks from a Zipf distribution in constant time without tables.
+ *
+ * Uses the rejection-inversion method of Hörmann and Derflinger, which inverts the
+ * integral of a continuous hat function over the ranks and rarely rejects a sample.
+ */
+class ZipfSampler
+{
+    /// Number of ranks.
+    double num_ranks_;
+
+    /// The exponent s.
+    double exponent_;
+
+    /// The integral of the hat function up to the lower edge of rank 1.
+    double h_integral_x1_;
+
+    /// The integral of the hat function up to the upper edge of the last rank.
+    double h_integral_num_ranks_;
+
+    /// Samples this close to their rank are accepted without evaluating the hat function.
+    double squeeze_;
+
+    /// log1p(x) / x, accurate near zero.
+    static double helper1(double x)
+    {
+        return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+    }
+
+    /// expm1(x) / x, accurate near zero.
+    static double helper2(double x)
+    {
+        return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1 + x * 0.5 * (1 + x * (1.0 / 3) * (1 + 0.25 * x));
+    }
+
+    /// The hat function, x^-s.
+    double h(double x) const
+    {
+        return std::exp(-exponent_ * std::log(x));
+    }
+
+    /// The integral of the hat function, (x^(1-s) - 1) / (1 - s), or log(x) when s is 1.
+    double h_integral(double x) const
+    {
+        double log_x = std::log(x);
+        return helper2((1 - exponent_) * log_x) * log_x;
+    }
+
+    /// The inverse of h_integral().
+    double h_integral_inverse(double x) const
+    {
+        double t = std::max(x * (1 - exponent_), -1.0);
+        return std::exp(helper1(t) * x);
+    }
+
+public:
+    /**
+     * @brief Prepares to draw ranks.
+     *
+     * @param num_ranks Number of ranks, at least 1.
+     * @param exponent The exponent s, greater than zero.
+     */
+    ZipfSampler(int num_ranks, double exponent)
+        : num_ranks_(num_ranks), exponent_(exponent)
+    {
+        h_integral_x1_ = h_integral(1.5) - 1;
+        h_integral_num_ranks_ = h_integral(num_ranks_ + 0.5);
+        squeeze_ = 2 - h_integral_inverse(h_integral(2.5) - h(2));
+    }
+
+    /**
+     * @brief Draws a rank.
+     *
+     * @param random The generator to draw with.
+     * @return A rank from 1 to the number of ranks.
+     */
+    std::int64_t operator()(Xoshiro256 & random) const
+    {
+        while (true)
+        {
+            double u = h_integral_num_ranks_ + random.uniform() * (h_integral_x1_ - h_integral_num_ranks_);
+            double x = h_integral_inverse(u);
+            double k = std::clamp(std::floor(x + 0.5), 1.0, num_ranks_);
+            if (k - x <= squeeze_ || u >= h_integral(k + 0.5) - h(k))
+            {
+                return static_cast<std::int64_t>(k);
+            }
+        }
+    }
+};
+
+template <typename T>
+/**
+ * @brief Draws a uniform key as wide as T, or 64 bits wide for types that are not integers.
+ *
+ * @param random The generator to draw with.
+ * @return The key.
+ */
+static std::int64_t uniform_key(Xoshiro256 & random)
+{
+    if constexpr (std::is_integral_v<T> && sizeof(T) == 4)
+    {
+        return static_cast<std::int32_t>(random() >> 32);
+    }
+    else
+    {
+        return static_cast<std::int64_t>(random());
+    }
+}
+
+template <typename T>
+/**
+ * @brief Converts an integer key to T, keeping keys in the same order.
+ *
+ * @param key The key.
+ * @param value Receives the converted key.
+ */
+static void store_key(std::int64_t key, T & value)
+{
+    if constexpr (std::is_same_v<T, double>)
+    {
+        value = std::ldexp(static_cast<double>(key), -63);
+    }
+    else if constexpr (std::is_same_v<T, std::string>)
+    {
+        // Flipping the sign bit and padding to 20 digits makes string order match key order.
+        char digits[21];
+        std::snprintf(digits, sizeof(digits), "%020llu",
+            static_cast<unsigned long long>(static_cast<std::uint64_t>(key) ^ (std::uint64_t(1) << 63)));
+        value = "customer-";
+        value += digits;
+    }
+    else if constexpr (std::is_same_v<T, Record>)
+    {
+        value.key = key;
+        std::fill(value.payload, value.payload + Record::PAYLOAD_SIZE, static_cast<unsigned char>(key));
+    }
+    else
+    {
+        value = static_cast<T>(key);
+    }
+}
+
+template <typename T>
+InputGenerator<T>::InputGenerator(int num_threads)
+{
+    if (num_threads <= 0)
+    {
+        num_threads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    }
+    // The thread calling generate() helps while it waits, so it counts as one of the threads.
+    pool_ = std::make_unique<ThreadPool>(num_threads - 1);
+}
+
+template <typename T>
+int InputGenerator<T>::num_threads() const
+{
+    return pool_->num_threads() + 1;
+}
+
+template <typename T>
+void InputGenerator<T>::generate(std::span<T> values, const DistributionSpec & spec, std::int64_t first_index,
+    std::int64_t total_count) const
+{
+    if (first_index < 0 || first_index % BLOCK_SIZE != 0)
+    {
+        throw std::runtime_error("Generated windows must start at a multiple of " + std::to_string(BLOCK_SIZE));
+    }
+    if ((spec.distribution == Distribution::FEW_UNIQUE && spec.num_unique < 1)
+        || (spec.distribution == Distribution::SAWTOOTH && spec.num_teeth < 1)
+        || (spec.distribution == Distribution::ZIPF && (spec.zipf_ranks < 1 || !(spec.zipf_exponent > 0)))
+        || (spec.distribution == Distribution::NEARLY_SORTED && !(spec.swap_percent >= 0)))
+    {
+        throw std::runtime_error(std::string("Bad parameters for the ") + distribution_name(spec.distribution)
+            + " distribution");
+    }
+
+    std::int64_t window_size = values.size();
+    std::int64_t count = total_count < 0 ? first_index + window_size : total_count;
+    std::int64_t tooth_size = std::max<std::int64_t>((count + spec.num_teeth - 1) / std::max(spec.num_teeth, 1), 1);
+    ZipfSampler zipf(std::max(spec.zipf_ranks, 1), spec.zipf_exponent > 0 ? spec.zipf_exponent : 1);
+    auto fill_block = [&](Xoshiro256 & random, std::int64_t start, std::span<T> block)
+    {
+        int block_size = block.size();
+        for (int i = 0; i < block_size; ++i)
+        {
+            std::int64_t index = start + i;
+            std::int64_t key = 0;
+            switch (spec.distribution)
+            {
+            case Distribution::UNIFORM:
+                key = uniform_key<T>(random);
+                break;
+            case Distribution::SORTED:
+            case Distribution::NEARLY_SORTED:
+                key = index;
+                break;
+            case Distribution::REVERSED:
+                key = count - 1 - index;
+                break;
+            case Distribution::ORGAN_PIPE:
+                key = std::min(index, count - 1 - index);
+                break;
+            case Distribution::SAWTOOTH:
+                key = index % tooth_size;
+                break;
+            case Distribution::FEW_UNIQUE:
+                key = random.below(spec.num_unique);
+                break;
+            case Distribution::ALL_EQUAL:
+                break;
+            case Distribution::ZIPF:
+                key = zipf(random);
+                break;
+            }
+            store_key<T>(key, block[i]);
+        }
+        if (spec.distribution == Distribution::NEARLY_SORTED)
+        {
+            std::int64_t num_swaps = std::llround(block_size * spec.swap_percent / 100);
+            for (std::int64_t swap = 0; swap < num_swaps; ++swap)
+            {
+                std::swap(block[random.below(block_size)], block[random.below(block_size)]);
+            }
+        }
+    };
+
+    std::int64_t num_blocks = (window_size + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    std::int64_t skipped_blocks = first_index / BLOCK_SIZE;
+    int num_chunks = std::min<std::int64_t>(num_threads(), std::max<std::int64_t>(num_blocks, 1));
+    auto generate_chunk = [&](int chunk)
+    {
+        std::int64_t first_block = num_blocks * chunk / num_chunks;
+        std::int64_t end_block = num_blocks * (chunk + 1) / num_chunks;
+        for (std::int64_t block = first_block; block < end_block; ++block)
+        {
+            Xoshiro256 random(spec.seed, skipped_blocks + block);
+            std::int64_t start = block * BLOCK_SIZE;
+            fill_block(random, first_index + start,
+                values.subspan(start, std::min<std::int64_t>(BLOCK_SIZE, window_size - start)));
+        }
+    };
+
+    TaskGroup group(*pool_);
+    for (int chunk = 1; chunk < num_chunks; ++chunk)
+    {
+        group.run([&generate_chunk, chunk] { generate_chunk(chunk); });
+    }
+    generate_chunk(0);
+    group.wait();
+}
+
+template class InputGenerator<int>;
+template class InputGenerator<std::int64_t>;
+template class InputGenerator<double>;
+template class InputGenerator<std::string>;
+template class InputGenerator<Record>;
@@ -0,0 +1,308 @@
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include "thread_pool.h"
+#pragma once
+
+/**
+ * @class Xoshiro256
+ * @brief The xoshiro256** pseudo-random number generator.
+ *
+ * It is several times faster than std::mt19937_64 with a quarter of the state, and
+ * it meets the UniformRandomBitGenerator requirements so it also works with the
+ * standard distributions. The state is seeded through SplitMix64, so similar seeds
+ * still give unrelated sequences. A stream number can be mixed into the seed to
+ * split one seed into many independent streams, in constant time per stream.
+ *
+ * @section Example
+ * @code
+ * Xoshiro256 random(42);
+ * std::uint64_t bits = random();
+ * std::uint64_t die = random.below(6) + 1;
+ * @endcode
+ */
+class Xoshiro256
+{
+    /// The generator state, which is never all zero.
+    std::uint64_t state_[4];
+
+    /**
+     * @brief Rotates the bits of a value to the left.
+     *
+     * @param x The value to rotate.
+     * @param k Number of bits to rotate by, from 1 to 63.
+     * @return The rotated value.
+     */
+    static std::uint64_t rotl(std::uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    /**
+     * @brief Multiplies two values into their full 128-bit product.
+     *
+     * @param x The first value.
+     * @param y The second value.
+     * @param low Receives the low 64 bits of the product.
+     * @return The high 64 bits of the product.
+     */
+    static std::uint64_t multiply(std::uint64_t x, std::uint64_t y, std::uint64_t & low)
+    {
+#ifdef __SIZEOF_INT128__
+        // __extension__ keeps -Wpedantic quiet about a type ISO C++ does not have.
+        __extension__ typedef unsigned __int128 Product;
+        Product product = static_cast<Product>(x) * y;
+        low = static_cast<std::uint64_t>(product);
+        return static_cast<std::uint64_t>(product >> 64);
+#else
+        // Multiply the 32-bit halves. The middle sum is at most (2^32 - 1)^2 + 2 (2^32 - 1) = 2^64 - 1.
+        const std::uint64_t HALF_MASK = 0xffffffff;
+        std::uint64_t low_low = (x & HALF_MASK) * (y & HALF_MASK);
+        std::uint64_t high_low = (x >> 32) * (y & HALF_MASK);
+        std::uint64_t low_high = (x & HALF_MASK) * (y >> 32);
+        std::uint64_t high_high = (x >> 32) * (y >> 32);
+        std::uint64_t middle = (low_low >> 32) + (high_low & HALF_MASK) + low_high;
+        low = (middle << 32) | (low_low & HALF_MASK);
+        return high_high + (high_low >> 32) + (middle >> 32);
+#endif
+    }
+
+public:
+    /// The type of the values the generator returns.
+    using result_type = std::uint64_t;
+
+    /**
+     * @brief Seeds the generator.
+     *
+     * @param seed Any value, including zero.
+     */
+    explicit Xoshiro256(std::uint64_t seed);
+
+    /**
+     * @brief Seeds one of many independent streams that share a seed.
+     *
+     * The seed is hashed with SplitMix64, stepped by the stream number times the
+     * golden ratio and hashed again, so neighbouring streams start from unrelated
+     * states and swapping the seed and the stream gives a different generator.
+     *
+     * @param seed Any value, including zero.
+     * @param stream The number of the stream.
+     */
+    Xoshiro256(std::uint64_t seed, std::uint64_t stream);
+
+    /**
+     * @brief Returns the smallest value the generator returns.
+     *
+     * @return Zero.
+     */
+    static constexpr result_type min()
+    {
+        return 0;
+    }
+
+    /**
+     * @brief Returns the largest value the generator returns.
+     *
+     * @return The largest 64-bit unsigned value.
+     */
+    static constexpr result_type max()
+    {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    /**
+     * @brief Returns the next 64 random bits.
+     *
+     * @return A uniformly distributed 64-bit value.
+     */
+    result_type operator()()
+    {
+        std::uint64_t result = rotl(state_[1] * 5, 7) * 9;
+        std::uint64_t shifted = state_[1] << 17;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= shifted;
+        state_[3] = rotl(state_[3], 45);
+        return result;
+    }
+
+    /**
+     * @brief Returns a random value below a bound.
+     *
+     * Uses Lemire's multiply-shift method, which needs no division in the common case
+     * and, unlike taking the remainder, does not favour small values.
+     *
+     * @param bound One more than the largest value to return. Must not be zero.
+     * @return A uniformly distributed value in [0, bound).
+     */
+    std::uint64_t below(std::uint64_t bound)
+    {
+        std::uint64_t low;
+        std::uint64_t high = multiply((*this)(), bound, low);
+        if (low < bound)
+        {
+            std::uint64_t threshold = -bound % bound;
+            while (low < threshold)
+            {
+                high = multiply((*this)(), bound, low);
+            }
+        }
+        return high;
+    }
+
+    /**
+     * @brief Returns a random value in [0, 1).
+     *
+     * @return A uniformly distributed double with 53 random bits.
+     */
+    double uniform()
+    {
+        return ((*this)() >> 11) * 0x1.0p-53;
+    }
+};
+
+/**
+ * @brief Selects the shape of the values an InputGenerator produces.
+ */
+enum class Distribution
+{
+    /// Independent random keys spanning the whole range of the type.
+    UNIFORM = 0,
+    /// Distinct keys in ascending order.
+    SORTED = 1,
+    /// Distinct keys in descending order.
+    REVERSED = 2,
+    /// Ascending to the middle, then descending.
+    ORGAN_PIPE = 3,
+    /// A number of ascending runs of equal length.
+    SAWTOOTH = 4,
+    /// Ascending keys with a percentage of them swapped with nearby keys.
+    NEARLY_SORTED = 5,
+    /// Random keys drawn from a handful of distinct values.
+    FEW_UNIQUE = 6,
+    /// Every key the same.
+    ALL_EQUAL = 7,
+    /// Ranks drawn from a Zipf distribution, so a few keys are very common.
+    ZIPF = 8
+};
+
+/// Number of values in Distribution.
+static constexpr int NUM_DISTRIBUTIONS = 9;
+
+/**
+ * @brief Returns the name a distribution is chosen by on the command line.
+ *
+ * @param distribution The distribution.
+ * @return A lower-case name such as "nearly-sorted".
+ */
+const char * distribution_name(Distribution distribution);
+
+/**
+ * @brief Looks a distribution up by the name distribution_name() gives it.
+ *
+ * @param name The name of the distribution.
+ * @return The distribution.
+ * @throws std::runtime_error If no distribution has the name.
+ */
+Distribution parse_distribution(const std::string & name);
+
+/**
+ * @struct DistributionSpec
+ * @brief Describes an input for an InputGenerator to produce.
+ */
+struct DistributionSpec
+{
+    /// The shape of the values.
+    Distribution distribution = Distribution::UNIFORM;
+
+    /// Seeds the generator. The same seed always gives the same values, whatever the number of threads.
+    std::uint64_t seed = 1;
+
+    /// For NEARLY_SORTED, the number of swaps as a percentage of the number of elements.
+    double swap_percent = 1.0;
+
+    /// For FEW_UNIQUE, the number of distinct keys.
+    int num_unique = 16;
+
+    /// For SAWTOOTH, the number of ascending runs.
+    int num_teeth = 16;
+
+    /// For ZIPF, the number of distinct ranks.
+    int zipf_ranks = 1000000;
+
+    /// For ZIPF, the exponent s. Rank k is drawn with a probability proportional to 1 / k^s.
+    double zipf_exponent = 1.0;
+};
+
+template <typename T>
+/**
+ * @class InputGenerator
+ * @brief Fills arrays with reproducible test inputs, on several threads at once.
+ *
+ * @tparam T int, std::int64_t, double, std::string or Record.
+ *
+ * The input is split into blocks of BLOCK_SIZE elements. Block b draws from stream
+ * b of the seed, so the values do not depend on how the blocks are shared out
+ * between threads, and any block can be generated without generating the ones
+ * before it. Keys are
+ * generated as integers and converted to T in an order-preserving way: a double is
+ * the key divided by 2^63, a string is the key zero-padded after a fixed prefix and
+ * a Record takes the key directly. 32-bit types draw uniform keys from 32 random
+ * bits and the others from 64.
+ *
+ * @section Example
+ * @code
+ * InputGenerator<int> generator;
+ * DistributionSpec spec;
+ * spec.distribution = Distribution::ZIPF;
+ * generator.generate(values.to_span(), spec);
+ * @endcode
+ */
+class InputGenerator
+{
+    /// The pool the blocks are generated on.
+    std::unique_ptr<ThreadPool> pool_;
+
+public:
+    /// Number of elements generated from each stream.
+    static constexpr int BLOCK_SIZE = 1 << 16;
+
+    /**
+     * @brief Constructs an InputGenerator.
+     *
+     * @param num_threads Number of threads to generate with, including the calling thread.
+     * Zero or less uses the number of hardware threads.
+     */
+    InputGenerator(int num_threads = 0);
+
+    /**
+     * @brief Returns the number of threads used to generate, including the calling thread.
+     *
+     * @return The number of threads.
+     */
+    int num_threads() const;
+
+    /**
+     * @brief Fills an array with values of the given distribution.
+     *
+     * NEARLY_SORTED swaps elements within the same block, so no element moves more
+     * than BLOCK_SIZE places from where it belongs.
+     *
+     * An input too large for memory can be produced a window at a time by passing
+     * the position of each window and the size of the whole input. The windows then
+     * hold exactly what one call for the whole input would have produced.
+     *
+     * @param values The array to fill.
+     * @param spec The distribution and its parameters.
+     * @param first_index The position of values[0] in the whole input, a multiple of BLOCK_SIZE.
+     * @param total_count Number of elements in the whole input, or less than zero if @p values is all of it.
+     * @throws std::runtime_error If a parameter of the distribution is out of range, or
+     * @p first_index is not a multiple of BLOCK_SIZE.
+     */
+    void generate(std::span<T> values, const DistributionSpec & spec, std::int64_t first_index = 0,
+        std::int64_t total_count = -1) const;
+};
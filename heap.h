@@ -1,26 +1,359 @@
+#include <functional>
+#include <optional>
+#include <utility>
 #include "common.h"
+#include "managed_dynamic_array.h"
 #pragma once
 
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @class Heap
+ * @brief A generic heap data structure with dynamic storage.
+ * 
+ * The Heap class provides a flexible implementation of a heap (priority queue)
+ * that supports dynamic resizing and custom comparison logic. It manages its
+ * elements using a managed dynamic array and allows for efficient insertion,
+ * removal, and access to the top element. The heap supports both min-heap and
+ * max-heap behavior through the Compare parameter, which is inlined rather than
+ * called virtually.
+ * 
+ * @tparam T The type of elements stored in the heap.
+ * @tparam Compare A function object where Compare(x, y) is true if x should leave the
+ * heap before y. The default, std::less<T>, makes a min heap.
+ * 
+ * @section Features
+ * - Dynamic storage management via ManagedDynamicArray.
+ * - Customizable comparison logic for heap ordering.
+ * - Efficient access to the top element.
+ * - Bounds checking utilities.
+ * 
+ * @section Usage
+ * Construct a Heap with a specified capacity, then use store() to insert elements,
+ * take() to remove the top element, and peek() to access the top element without removal.
+ * 
+ * @section Example
+ * @code
+ * Heap<int> minHeap(100);
+ * minHeap.store(42);
+ * int top = minHeap.peek();
+ * int removed = minHeap.take();
+ * @endcode
+ */
+class Heap
+{
+    // Stores the current number of elements in the heap.
+    int size_;
+
+    /**
+     * @brief Internal storage for the heap elements.
+     * 
+     * This managed dynamic array holds the elements of the heap,
+     * providing dynamic resizing and memory management.
+     * 
+     * @tparam T Type of elements stored in the heap.
+     */
+    ManagedDynamicArray<T> storage_;
+
+    /// Orders the elements.
+    [[no_unique_address]] Compare compare_;
+
+public:
+    /// Index of the top element in the storage, which starts at 1 so the children of i are 2i and 2i + 1.
+    static constexpr int ROOT_INDEX = 1;
+
+    /**
+     * @brief Constructs a Heap with a specified capacity.
+     * 
+     * Initializes the heap with zero elements and allocates internal storage
+     * to hold up to the given capacity. The storage is sized as (capacity + 1)
+     * to accommodate heap indexing starting from 1.
+     * 
+     * @param capacity The maximum number of elements the heap can hold.
+     * @param compare The comparator used to order the elements.
+     */
+    Heap(int capacity, Compare compare = Compare())
+        : size_(0), storage_(capacity + 1), compare_(compare)
+    {
+    }
+
+    /**
+     * @brief Compares two values of type T using the Compare policy.
+     *
+     * This function determines the ordering between two elements, x and y. It
+     * returns true if x should come before y according to the comparison logic,
+     * and false otherwise.
+     *
+     * @param x The first value to compare.
+     * @param y The second value to compare.
+     * @return true if x is before y; false otherwise.
+     */
+    bool compare(const T & x, const T & y) const
+    {
+        return compare_(x, y);
+    }
+
+    /**
+     * @brief Provides access to the element at the specified index.
+     * 
+     * This operator returns a reference to the element in the underlying storage
+     * at the given index, allowing both reading and modification of the value.
+     * 
+     * @param idx The index of the element to access.
+     * @return Reference to the element at the specified index.
+     * @throws std::out_of_range If idx is out of bounds (behavior depends on storage_ implementation).
+     */
+    T & operator[](size_t idx)
+    {
+        return storage_[idx];
+    }
+
+    /**
+     * @brief Provides read-only access to the element at the specified index.
+     * 
+     * @param idx The index of the element to access.
+     * @return const int& A constant reference to the element at the given index.
+     * @note No bounds checking is performed.
+     */
+    const T & operator[](size_t idx) const
+    {
+        return storage_[idx];
+    }
+
+    /**
+     * @brief Checks if the given index is out of the valid range.
+     *
+     * Determines whether the specified index exceeds the current size of the container.
+     *
+     * @param index The index to check.
+     * @return true if the index is greater than the current size; false otherwise.
+     */
+    bool is_out_of_range(int index) const
+    {
+        return index > size_;
+    }
+
+    /**
+     * @brief Returns the number of elements in the heap.
+     *
+     * @return The number of elements.
+     */
+    int size() const
+    {
+        return size_;
+    }
+
+    /**
+     * @brief Returns the element at the top of the heap without removing it.
+     * 
+     * @tparam T The type of the elements stored in the heap.
+     *
+     * @return std::optional<T> The top element if the heap is not empty; std::nullopt otherwise.
+     */
+    std::optional<T> peek() const
+    {
+        if (size_ == 0) return std::nullopt;
+
+        return storage_[ROOT_INDEX];
+    }
+
+    /**
+     * @brief Stores the given number in the data structure.
+     * 
+     * @tparam T The type of the number to be stored.
+     * @param num The number to store, which is moved into the heap.
+     */
+    void store(T num);
+
+    /**
+     * @brief Removes and returns the top element from the heap, if available.
+     * 
+     * @tparam T The type of the elements stored in the heap.
+     * @return std::optional<T> The top element if the heap is not empty; std::nullopt otherwise.
+     */
+    std::optional<T> take();
+
+    /**
+     * @brief Replaces the top element with the given value and restores the heap.
+     *
+     * This does the work of take() followed by store() in a single sift, which is what
+     * keeping the best k of a stream in a bounded heap needs. The heap must not be empty.
+     *
+     * @param num The value to put in place of the top element, which is moved into the heap.
+     */
+    void replace_top(T num);
+};
+
 template <typename T>
+/**
+ * @class MaxHeap
+ * @brief A heap data structure that always extracts the maximum element.
+ * 
+ * Inherits from the generic Heap class with std::greater<T> as the comparison
+ * policy to maintain the max-heap property, where each parent node is
+ * greater than or equal to its child nodes.
+ * 
+ * @tparam T The type of elements stored in the heap.
+ * 
+ * @constructor
+ * @param capacity The maximum number of elements the heap can hold.
+ */
+class MaxHeap : public Heap<T, std::greater<T>>
+{
+public:
+    /**
+     * @brief Constructs a MaxHeap with the specified capacity.
+     * 
+     * @param capacity The maximum number of elements the heap can hold.
+     */
+    MaxHeap(int capacity) : Heap<T, std::greater<T>>(capacity) {}
+};
+
+/**
+ * @brief The way a HeapNode moves to restore the heap property.
+ */
+enum class HeapifyDirection
+{
+    /// Towards the leaves.
+    DOWN = 0,
+    /// Towards the root.
+    UP = 1
+};
+
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @brief Represents a node within a heap data structure.
+ * 
+ * @tparam T The type of value stored in the heap.
+ * @tparam Compare The comparison policy of the heap.
+ */
+class HeapNode
+{
+    /// The index of a node that does not exist, such as the parent of the root.
+    static constexpr int INVALID_INDEX = -1;
+
+    /**
+     * @brief The index of this node within the heap.
+     */
+    int index_ = INVALID_INDEX;
+
+    /**
+     * @brief Reference wrapper for the heap that contains this node.
+     */
+    std::reference_wrapper<Heap<T, Compare>> heap_;
+    // NOTE: I initially stored a plain reference to the heap, but it as well
+    // as a const pointer prevents me from reassigning a local variable
+    // to another node like so:
+    // HeapNode<T> node = some_other_node;
+    // error: use of deleted function 'HeapNode<int>& HeapNode<int>::operator=(const HeapNode<int>&)'
+
+public:
+    /**
+     * @brief Constructs a HeapNode for a given heap and index.
+     * @param heap Constant pointer to the heap containing this node.
+     * @param index Index of the node within the heap.
+     */
+    HeapNode(Heap<T, Compare> & heap, int index);
+
+    /**
+     * @brief Checks whether the object exists insofar as it references
+     * a valid index in the heap.
+     * 
+     * @return true if the object exists; false otherwise.
+     */
+    bool exists() const;
+
+    /**
+     * @brief Retrieves the value stored at this node.
+     * @return A reference to the value of type T at this node.
+     */
+    T & get_value() const;
+
+    /**
+     * @brief Restores the heap property by moving the node down the heap if necessary.
+     */
+    void heapify_down() const;
+
+    /**
+     * @brief Restores the heap property by moving the node up the heap if necessary.
+     */
+    void heapify_up() const;
+
+    /**
+     * @brief Returns the HeapNode at the specified index.
+     * @param index The index of the desired node.
+     * @return the HeapNode at the given index.
+     */
+    HeapNode from_index(int index) const;
+
+    /**
+     * @brief Returns the left child node.
+     * @return the left child HeapNode.
+     */
+    HeapNode left() const;
+
+    /**
+     * @brief Returns the right child node.
+     * @return the right child HeapNode.
+     */
+    HeapNode right() const;
+
+    /**
+     * @brief Returns the parent node.
+     * @return the parent HeapNode.
+     */
+    HeapNode parent() const;
+
+    /**
+     * @brief Attempts to swap the value of this node with another node, based on heapify direction.
+     * @param other Reference to the other HeapNode.
+     * @param direction The direction of heapification (up or down).
+     */
+    void try_swap_value(const HeapNode & other, HeapifyDirection direction) const;
+};
+
+template <typename T, typename Compare = std::less<T>>
 /**
  * @class HeapSorter
  * @brief Implements the heap sort algorithm for sorting arrays.
  * 
  * @tparam T The type of elements to sort.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
  *
  * Inherits from the Sorter base class and provides an implementation of the
- * sort method using the heap sort technique. The class includes a private
- * helper function, heapify, to maintain the heap property during sorting.
+ * sort method using the heap sort technique. A heap whose root is the last
+ * element in Compare order is built bottom-up in O(n) directly in the array,
+ * then the root is repeatedly swapped to the end of the shrinking heap. Nothing
+ * is allocated and no virtual calls are made.
  */
 class HeapSorter : public Sorter<T>
 {
+    /// Orders the elements.
+    [[no_unique_address]] InstrumentedCompare<Compare> compare_;
+
+    /**
+     * @brief Places a value into the heap starting at a hole, using Floyd's leaf search.
+     *
+     * The hole is first walked all the way down to a leaf by always promoting the
+     * child that comes later in Compare order, which takes one comparison per level. The value is then sifted
+     * back up from that leaf. The value usually belongs near the bottom, so this
+     * makes about half the comparisons of a standard sift-down.
+     *
+     * @param ary A std::span<T> representing the array holding the heap.
+     * @param hole The index of the hole, whose current value is ignored.
+     * @param count The number of elements in the heap.
+     * @param value The value to place.
+     */
+    void sift_down(std::span<T> ary, int hole, int count, T value) const;
+
 public:
     /**
      * @brief Constructs a HeapSorter object with the name "Heap".
      *
      * This constructor initializes the base Sorter class with the sorting algorithm name "Heap".
+     *
+     * @param compare The comparator used to order the elements.
      */
-    HeapSorter() : Sorter<T>("Heap") {}
+    HeapSorter(Compare compare = Compare()) : Sorter<T>("Heap"), compare_(compare) {}
 
     /**
      * @brief Sorts the given array in-place using the heap sort algorithm.
@@ -30,4 +363,208 @@ public:
      * @note This function overrides a virtual method from a base class.
      */
     void sort(std::span<T> ary) const override;
+
+    /**
+     * @brief Returns the order in which sort() touches the elements of the array.
+     *
+     * @return AccessPattern::RANDOM, since every sift jumps from a node to children twice as far into the array.
+     */
+    AccessPattern access_pattern() const override
+    {
+        return AccessPattern::RANDOM;
+    }
 };
+
+template <typename T, typename Compare>
+void Heap<T, Compare>::store(T num)
+{
+    ++size_;
+    storage_[size_] = std::move(num);
+    bool setting_root = size_ == ROOT_INDEX;
+    if (!setting_root)
+    {
+        HeapNode<T, Compare> added(*this, size_);
+        added.heapify_up();
+    }
+}
+
+template <typename T, typename Compare>
+HeapNode<T, Compare>::HeapNode(Heap<T, Compare> & heap, int index) : heap_(heap), index_(index) {}
+
+template <typename T, typename Compare>
+std::optional<T> Heap<T, Compare>::take()
+{
+    if (size_ == 0) return std::nullopt;
+
+    std::optional<T> taken(std::move(storage_[ROOT_INDEX]));
+    storage_[ROOT_INDEX] = std::move(storage_[size_--]);
+    if (size_ > 1)
+    {
+        HeapNode<T, Compare> root_node(*this, ROOT_INDEX);
+        root_node.heapify_down();
+    }
+    return taken;
+}
+
+template <typename T, typename Compare>
+void Heap<T, Compare>::replace_top(T num)
+{
+    storage_[ROOT_INDEX] = std::move(num);
+    if (size_ > 1)
+    {
+        HeapNode<T, Compare> root_node(*this, ROOT_INDEX);
+        root_node.heapify_down();
+    }
+}
+
+template <typename T, typename Compare>
+bool HeapNode<T, Compare>::exists() const
+{
+    return index_ != INVALID_INDEX;
+}
+
+template <typename T, typename Compare>
+T & HeapNode<T, Compare>::get_value() const
+{
+    return static_cast<Heap<T, Compare>&>(heap_)[index_];
+}
+
+template <typename T, typename Compare>
+void HeapNode<T, Compare>::heapify_down() const
+{
+    HeapNode<T, Compare> lft = left();
+    HeapNode<T, Compare> rght = right();
+    bool left_exists = lft.exists();
+    bool right_exists = rght.exists();
+    if (!left_exists && !right_exists)
+    {
+        return;
+    }
+
+    HeapNode<T, Compare> other = rght;
+    if (left_exists && right_exists)
+    {
+        /* Favor the smallest or largest child node as a swap partner
+         * depending on if one is working with a min or max heap.
+         * The comparer will return true if the first value meets this
+         * criteria. */
+        if (static_cast<Heap<T, Compare>&>(heap_).compare(
+            lft.get_value(), rght.get_value()))
+        {
+            other = lft;
+        }
+    }
+    else if (left_exists)
+    {
+        other = lft;
+    }
+    try_swap_value(other, HeapifyDirection::DOWN);
+}
+
+template <typename T, typename Compare>
+void HeapNode<T, Compare>::heapify_up() const
+{
+    HeapNode node = parent();
+    try_swap_value(node, HeapifyDirection::UP);
+}
+
+template <typename T, typename Compare>
+HeapNode<T, Compare> HeapNode<T, Compare>::left() const
+{
+    return from_index(2 * index_);
+}
+
+template <typename T, typename Compare>
+HeapNode<T, Compare> HeapNode<T, Compare>::right() const
+{
+    return from_index(2 * index_ + 1);
+}
+
+template <typename T, typename Compare>
+HeapNode<T, Compare> HeapNode<T, Compare>::parent() const
+{
+    int new_index = index_ == Heap<T, Compare>::ROOT_INDEX ? INVALID_INDEX : (index_ / 2);
+    return HeapNode<T, Compare>(heap_, new_index);
+}
+
+template <typename T, typename Compare>
+HeapNode<T, Compare> HeapNode<T, Compare>::from_index(int index) const
+{
+    int new_index = static_cast<Heap<T, Compare>&>(heap_).is_out_of_range(index) ? INVALID_INDEX : index;
+    return HeapNode<T, Compare>(heap_, new_index);
+}
+
+template <typename T, typename Compare>
+void HeapNode<T, Compare>::try_swap_value(const HeapNode<T, Compare> & other, HeapifyDirection direction) const
+{
+    if (!exists() || !other.exists()) return;
+
+    T & val = get_value();
+    T & other_val = other.get_value();
+    Heap<T, Compare> & heap = static_cast<Heap<T, Compare>&>(heap_);
+    if (direction == HeapifyDirection::DOWN && heap.compare(other_val, val))
+    {
+        std::swap(val, other_val);
+        other.heapify_down();
+    }
+    else if (direction == HeapifyDirection::UP && heap.compare(val, other_val))
+    {
+        std::swap(val, other_val);
+        other.heapify_up();
+    }
+}
+
+template <typename T, typename Compare>
+void HeapSorter<T, Compare>::sift_down(std::span<T> ary, int hole, int count, T value) const
+{
+    int top = hole;
+    int child;
+    // The array is 0-based, so the children of i are at 2i + 1 and 2i + 2.
+    while ((child = 2 * hole + 1) < count)
+    {
+        if (child + 1 < count && compare_(ary[child], ary[child + 1]))
+        {
+            ++child;
+        }
+        ary[hole] = std::move(ary[child]);
+        Instrumentation::count_moves(1);
+        hole = child;
+    }
+    while (hole > top)
+    {
+        int parent = (hole - 1) / 2;
+        if (!compare_(ary[parent], value))
+        {
+            break;
+        }
+        ary[hole] = std::move(ary[parent]);
+        Instrumentation::count_moves(1);
+        hole = parent;
+    }
+    ary[hole] = std::move(value);
+    Instrumentation::count_moves(1);
+}
+
+template <typename T, typename Compare>
+void HeapSorter<T, Compare>::sort(std::span<T> ary) const
+{
+    int count = ary.size();
+    if (count < 2)
+    {
+        return;
+    }
+
+    for (int i = count / 2 - 1; i >= 0; --i)
+    {
+        sift_down(ary, i, count, std::move(ary[i]));
+    }
+    /* The root is the last remaining value in Compare order, so it belongs just past the
+     * end of the shrinking heap. The value it displaces refills the root. */
+    for (int last = count - 1; last > 0; --last)
+    {
+        T value = std::move(ary[last]);
+        ary[last] = std::move(ary[0]);
+        Instrumentation::count_moves(2);
+        sift_down(ary, 0, last, std::move(value));
+    }
+}
@@ -1,13 +1,16 @@
+#include <functional>
 #include <span>
+#include <utility>
 #include "common.h"
 #pragma once
 
-template <typename T>
+template <typename T, typename Compare = std::less<T>>
 /**
  * @class InsertionSorter
  * @brief Implements the insertion sort algorithm for sorting arrays.
  * 
  * @tparam T The type of elements to sort.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
  *
  * InsertionSorter is a concrete subclass of the Sorter base class, providing
  * an implementation of the insertion sort algorithm. It overrides the sort()
@@ -17,14 +20,19 @@ template <typename T>
  */
 class InsertionSorter : public Sorter<T>
 {
+    /// Orders the elements.
+    [[no_unique_address]] InstrumentedCompare<Compare> compare_;
+
 public:
     /**
      * @brief Constructs an InsertionSorter object with the name "Insertion Sort".
      *
      * This constructor initializes the base Sorter class with the algorithm name,
      * allowing identification and usage of the insertion sort algorithm.
+     *
+     * @param compare The comparator used to order the elements.
      */
-    InsertionSorter() : Sorter<T>("Insertion Sort") {}
+    InsertionSorter(Compare compare = Compare()) : Sorter<T>("Insertion Sort"), compare_(compare) {}
 
     /**
      * @brief Sorts the given array in-place using the insertion sort algorithm.
@@ -35,3 +43,32 @@ public:
      */
     void sort(std::span<T> ary) const override;
 };
+
+template <typename T, typename Compare>
+void InsertionSorter<T, Compare>::sort(std::span<T> ary) const
+{
+    int count = ary.size();
+    if (count < 2)
+    {
+        return;
+    }
+    
+    for (int i = 1; i < count; ++i)
+    {
+        if (!compare_(ary[i], ary[i - 1]))
+        {
+            continue;
+        }
+        /* Lift the value out and shift the larger ones up one slot each, so
+         * every element moves once rather than being swapped along. */
+        T old = std::move(ary[i]);
+        int j = i;
+        do
+        {
+            ary[j] = std::move(ary[j - 1]);
+            --j;
+        } while (j > 0 && compare_(old, ary[j - 1]));
+        ary[j] = std::move(old);
+        Instrumentation::count_moves(i - j + 2);
+    }
+}
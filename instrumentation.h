@@ -0,0 +1,230 @@
+#include <atomic>
+#include <cstdint>
+#pragma once
+
+/**
+ * @struct SortStats
+ * @brief What the sorters did while Instrumentation was counting.
+ */
+struct SortStats
+{
+    /// Number of times two elements were compared.
+    std::int64_t comparisons = 0;
+
+    /// Number of times two elements traded places through Sorter::swap_values().
+    std::int64_t swaps = 0;
+
+    /// Number of elements moved one at a time, such as by a merge, a shift or a scatter.
+    std::int64_t moves = 0;
+
+    /// The deepest nesting of recursive calls.
+    int max_recursion_depth = 0;
+
+    /// Bytes of scratch space allocated through ManagedDynamicArray.
+    std::int64_t allocated_bytes = 0;
+};
+
+/**
+ * @class Instrumentation
+ * @brief Counts the work the sorters do, when the build enables it.
+ *
+ * The sorters report comparisons, swaps, element moves, recursion depth and
+ * scratch allocations through the static members of this class. Unless the build
+ * defines CPPSORT_INSTRUMENTATION, every member is an empty inline function and
+ * InstrumentedCompare is the comparator itself, so the sorters compile to the same
+ * code as if they had no hooks at all.
+ *
+ * With CPPSORT_INSTRUMENTATION the counts are shared by all threads, so the work
+ * of the parallel sorters' pools is included. Only one sort should be measured at
+ * a time.
+ *
+ * @section Example
+ * @code
+ * Instrumentation::reset();
+ * sorter.sort(values);
+ * SortStats stats = Instrumentation::read();
+ * @endcode
+ */
+class Instrumentation
+{
+#ifdef CPPSORT_INSTRUMENTATION
+    static inline std::atomic<std::int64_t> comparisons_{0};
+    static inline std::atomic<std::int64_t> swaps_{0};
+    static inline std::atomic<std::int64_t> moves_{0};
+    static inline std::atomic<int> max_recursion_depth_{0};
+    static inline std::atomic<std::int64_t> allocated_bytes_{0};
+
+    /// The recursion depth of the calling thread.
+    static inline thread_local int recursion_depth_ = 0;
+#endif
+
+public:
+#ifdef CPPSORT_INSTRUMENTATION
+    /// true if the build counts; false if every hook compiles to nothing.
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+
+    /**
+     * @brief Zeroes the counts.
+     */
+    static void reset()
+    {
+#ifdef CPPSORT_INSTRUMENTATION
+        comparisons_ = 0;
+        swaps_ = 0;
+        moves_ = 0;
+        max_recursion_depth_ = 0;
+        allocated_bytes_ = 0;
+#endif
+    }
+
+    /**
+     * @brief Returns the counts since the last reset().
+     *
+     * @return The counts, all zero unless ENABLED.
+     */
+    static SortStats read()
+    {
+        SortStats stats;
+#ifdef CPPSORT_INSTRUMENTATION
+        stats.comparisons = comparisons_;
+        stats.swaps = swaps_;
+        stats.moves = moves_;
+        stats.max_recursion_depth = max_recursion_depth_;
+        stats.allocated_bytes = allocated_bytes_;
+#endif
+        return stats;
+    }
+
+    /**
+     * @brief Counts one comparison.
+     */
+    static void count_comparison()
+    {
+#ifdef CPPSORT_INSTRUMENTATION
+        comparisons_.fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+
+    /**
+     * @brief Counts comparisons made outside a CountingCompare, such as several at once in SIMD registers.
+     *
+     * @param count Number of comparisons.
+     */
+    static void count_comparisons([[maybe_unused]] std::int64_t count)
+    {
+#ifdef CPPSORT_INSTRUMENTATION
+        comparisons_.fetch_add(count, std::memory_order_relaxed);
+#endif
+    }
+
+    /**
+     * @brief Counts one swap.
+     */
+    static void count_swap()
+    {
+#ifdef CPPSORT_INSTRUMENTATION
+        swaps_.fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+
+    /**
+     * @brief Counts elements moved one at a time.
+     *
+     * @param count Number of elements moved.
+     */
+    static void count_moves([[maybe_unused]] std::int64_t count)
+    {
+#ifdef CPPSORT_INSTRUMENTATION
+        moves_.fetch_add(count, std::memory_order_relaxed);
+#endif
+    }
+
+    /**
+     * @brief Counts an allocation of scratch space.
+     *
+     * @param num_bytes Number of bytes allocated.
+     */
+    static void count_allocation([[maybe_unused]] std::int64_t num_bytes)
+    {
+#ifdef CPPSORT_INSTRUMENTATION
+        allocated_bytes_.fetch_add(num_bytes, std::memory_order_relaxed);
+#endif
+    }
+
+    /**
+     * @class RecursionScope
+     * @brief Marks one level of recursion for as long as it lives.
+     *
+     * A recursive function declares one of these first thing, and the deepest
+     * nesting of them on any thread is recorded.
+     */
+    class RecursionScope
+    {
+    public:
+        RecursionScope()
+        {
+#ifdef CPPSORT_INSTRUMENTATION
+            int depth = ++recursion_depth_;
+            int deepest = max_recursion_depth_.load(std::memory_order_relaxed);
+            while (depth > deepest
+                && !max_recursion_depth_.compare_exchange_weak(deepest, depth, std::memory_order_relaxed));
+#endif
+        }
+
+        RecursionScope(const RecursionScope &) = delete;
+        RecursionScope & operator=(const RecursionScope &) = delete;
+
+        ~RecursionScope()
+        {
+#ifdef CPPSORT_INSTRUMENTATION
+            --recursion_depth_;
+#endif
+        }
+    };
+};
+
+template <typename Compare>
+/**
+ * @struct CountingCompare
+ * @brief A comparator that counts every comparison it makes with Instrumentation.
+ *
+ * @tparam Compare The comparator that decides the order.
+ */
+struct CountingCompare
+{
+    /// Orders the elements.
+    [[no_unique_address]] Compare compare;
+
+    /**
+     * @brief Wraps a comparator.
+     *
+     * @param compare The comparator that decides the order.
+     */
+    CountingCompare(Compare compare = Compare()) : compare(compare) {}
+
+    /**
+     * @brief Counts a comparison and makes it.
+     *
+     * @param x The first element.
+     * @param y The second element.
+     * @return true if @p x is ordered before @p y; false otherwise.
+     */
+    template <typename X, typename Y>
+    bool operator()(const X & x, const Y & y) const
+    {
+        Instrumentation::count_comparison();
+        return compare(x, y);
+    }
+};
+
+#ifdef CPPSORT_INSTRUMENTATION
+/// The comparator a sorter stores: a CountingCompare when instrumented, otherwise Compare itself.
+template <typename Compare>
+using InstrumentedCompare = CountingCompare<Compare>;
+#else
+template <typename Compare>
+using InstrumentedCompare = Compare;
+#endif
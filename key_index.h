@@ -0,0 +1,29 @@
+#include <compare>
+#include <cstdint>
+#pragma once
+
+template <typename K, typename Index = std::uint32_t>
+/**
+ * @struct KeyIndex
+ * @brief A key paired with the position it was read from, as sorted by argsort().
+ *
+ * @tparam K The type of the key.
+ * @tparam Index The unsigned integer type of the position, std::uint32_t or std::uint64_t.
+ *
+ * Pairs order by key and then by index, so pairs with equal keys keep the order
+ * they were read in whichever sorter is used, and the resulting permutation is
+ * stable and deterministic.
+ */
+struct KeyIndex
+{
+    /// The key being sorted.
+    K key;
+
+    /// The position of the key in the column it was read from.
+    Index index;
+
+    /**
+     * @brief Orders two pairs by key, then by index.
+     */
+    auto operator<=>(const KeyIndex & other) const = default;
+};
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "insertion.h"
+#include "key_index.h"
+#include "managed_dynamic_array.h"
+#include "merge.h"
+#include "pdq.h"
+#include "radix.h"
+#pragma once
+
+/**
+ * @brief Selects the algorithm sort_by_key() orders the keys with.
+ */
+enum class SortEngine
+{
+    /// Merge sort on key and index pairs, with insertion sort for the small ranges.
+    MERGE = 0,
+    /// Pattern-defeating quicksort on key and index pairs.
+    QUICK = 1,
+    /// LSD radix sort on the keys, carrying their indices along. Integral keys only.
+    RADIX = 2
+};
+
+template <typename P>
+/**
+ * @brief Reorders a column so that element i becomes the element at position permutation[i].
+ *
+ * The elements are gathered into scratch space and moved back. Unlike following
+ * the cycles of the permutation, every load is independent of the one before it, so
+ * the processor can have many cache misses in flight at once.
+ *
+ * @param permutation The source position of every element.
+ * @param column The column to reorder, the same size as @p permutation.
+ * @param scratch Raw space for at least as many elements as @p column, shared with the other columns.
+ */
+void gather_column(std::span<const std::uint32_t> permutation, std::span<P> column, std::span<std::byte> scratch)
+{
+    static_assert(alignof(P) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "Payloads cannot be over-aligned");
+    int count = column.size();
+    P * gathered = reinterpret_cast<P *>(scratch.data());
+    for (int i = 0; i < count; ++i)
+    {
+        std::construct_at(gathered + i, std::move(column[permutation[i]]));
+    }
+    std::move(gathered, gathered + count, column.begin());
+    std::destroy(gathered, gathered + count);
+}
+
+template <typename K, typename... Payloads>
+/**
+ * @brief Sorts a key column in-place and reorders any number of payload columns in lockstep.
+ *
+ * Only the keys are compared. The merge and quick engines sort each key next to its
+ * index and the radix engine carries the indices along with the keys, so either
+ * way the sorted keys come out together with a permutation of the positions. Only
+ * the payload columns are then reordered, one column at a time, with
+ * gather_column(), through one scratch buffer sized for the widest payload. This
+ * avoids zipping the columns into structs, sorting the structs and unzipping them
+ * again. Equal keys keep their payloads in the original order with every engine.
+ *
+ * @tparam K The type of the keys: int or std::int64_t.
+ * @tparam Payloads The element types of the payload columns.
+ * @param engine The algorithm used to order the keys.
+ * @param keys The keys to sort.
+ * @param payloads The payload columns, each the same size as @p keys.
+ * @throws std::runtime_error If a payload column is not the same size as @p keys,
+ * or if the radix engine is asked to sort keys that are not integral.
+ *
+ * @section Example
+ * @code
+ * sort_by_key(SortEngine::RADIX, keys.to_span(), prices.to_span(), quantities.to_span());
+ * @endcode
+ */
+void sort_by_key(SortEngine engine, std::span<K> keys, std::span<Payloads>... payloads)
+{
+    int count = keys.size();
+    if (((static_cast<int>(payloads.size()) != count) || ...))
+    {
+        throw std::runtime_error("Every payload column must hold " + std::to_string(count) + " elements to sort by key");
+    }
+
+    ManagedDynamicArray<std::uint32_t> permutation(count);
+    if (engine == SortEngine::RADIX)
+    {
+        if constexpr (std::is_integral_v<K>)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                permutation[i] = i;
+            }
+            RadixSorter<K>().sort_pairs(keys, permutation.to_span());
+        }
+        else
+        {
+            throw std::runtime_error("The radix engine only sorts integral keys");
+        }
+    }
+    else
+    {
+        // The same decoration as argsort(), except the sorted keys are written straight back.
+        ManagedDynamicArray<KeyIndex<K>> pairs(count);
+        for (int i = 0; i < count; ++i)
+        {
+            pairs[i] = KeyIndex<K>{keys[i], static_cast<std::uint32_t>(i)};
+        }
+        if (engine == SortEngine::MERGE)
+        {
+            // Merge sort is stable and the pairs start in index order, so comparing the keys alone is enough.
+            using ByKey = ProjectedCompare<decltype(&KeyIndex<K>::key)>;
+            ByKey by_key{&KeyIndex<K>::key};
+            InsertionSorter<KeyIndex<K>, ByKey> insertion_sorter(by_key);
+            MergeSorter<KeyIndex<K>, ByKey>(insertion_sorter, MergeSorter<KeyIndex<K>, ByKey>::DEFAULT_SMALL_SIZE, by_key)
+                .sort(pairs.to_span());
+        }
+        else
+        {
+            PdqSorter<KeyIndex<K>>().sort(pairs.to_span());
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            keys[i] = pairs[i].key;
+            permutation[i] = pairs[i].index;
+        }
+    }
+
+    if constexpr (sizeof...(Payloads) > 0)
+    {
+        std::size_t num_bytes = std::max({sizeof(Payloads)...}) * static_cast<std::size_t>(count);
+        std::unique_ptr<std::byte[]> scratch = std::make_unique_for_overwrite<std::byte[]>(num_bytes);
+        Instrumentation::count_allocation(num_bytes);
+        (gather_column<Payloads>(permutation.to_span(), payloads, std::span<std::byte>(scratch.get(), num_bytes)), ...);
+    }
+}
@@ -0,0 +1,659 @@
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "file_stream.h"
+#include "instrumentation.h"
+#include "managed_dynamic_array.h"
+#pragma once
+
+template <typename T>
+/**
+ * @class RunCursor
+ * @brief Hands out the elements of a sorted run a block at a time.
+ *
+ * @tparam T The type of elements.
+ *
+ * A merge only calls next_block() once it has used up the previous block, so the
+ * cost of the virtual call is shared by every element of a block.
+ */
+class RunCursor
+{
+public:
+    virtual ~RunCursor() = default;
+
+    /**
+     * @brief Returns the next elements of the run.
+     *
+     * @return The elements, which stay valid until the next call; an empty span at the end of the run.
+     */
+    virtual std::span<const T> next_block() = 0;
+};
+
+template <typename T>
+/**
+ * @class MergeSink
+ * @brief Receives the output of a merge a block at a time.
+ *
+ * @tparam T The type of elements.
+ *
+ * The merge writes straight into the space the sink hands out, so a sink over memory
+ * costs no extra copy and a sink over a file only copies when the block is written.
+ */
+class MergeSink
+{
+public:
+    virtual ~MergeSink() = default;
+
+    /**
+     * @brief Returns space for the next elements.
+     *
+     * @return A non-empty span, which stays valid until commit() is called.
+     * @throws std::runtime_error If the sink cannot take any more elements.
+     */
+    virtual std::span<T> next_block() = 0;
+
+    /**
+     * @brief Accepts the elements written to the start of the span last returned by next_block().
+     *
+     * @param count Number of elements written.
+     */
+    virtual void commit(int count) = 0;
+};
+
+template <typename T>
+/**
+ * @class SpanCursor
+ * @brief A run that is already in memory, handed out as a single block.
+ */
+class SpanCursor : public RunCursor<T>
+{
+    /// The elements not yet handed out.
+    std::span<const T> run_;
+
+public:
+    /**
+     * @brief Constructs a cursor over a sorted span.
+     *
+     * @param run The run, which must outlive the cursor.
+     */
+    explicit SpanCursor(std::span<const T> run);
+
+    std::span<const T> next_block() override;
+};
+
+template <typename T>
+/**
+ * @class SpanSink
+ * @brief Writes the output of a merge into a span.
+ */
+class SpanSink : public MergeSink<T>
+{
+    /// The part of the output not yet written.
+    std::span<T> output_;
+
+    /// Number of elements written.
+    int count_;
+
+public:
+    /**
+     * @brief Constructs a sink that fills a span from the start.
+     *
+     * @param output The span to fill, which must outlive the sink.
+     */
+    explicit SpanSink(std::span<T> output);
+
+    /**
+     * @brief Returns the number of elements written.
+     *
+     * @return The number of elements.
+     */
+    int size() const;
+
+    std::span<T> next_block() override;
+
+    void commit(int count) override;
+};
+
+template <typename T>
+/**
+ * @class FileCursor
+ * @brief Reads a sorted run of fixed-size elements from a file through a large buffer.
+ *
+ * @tparam T The trivially copyable type of the elements, stored in native byte order.
+ *
+ * After each read the operating system is told the next block will be needed, so it
+ * reads ahead into the page cache while the merge works through the current block.
+ * A merge of many file-backed runs then rarely waits on the disk.
+ */
+class FileCursor : public RunCursor<T>
+{
+    static_assert(std::is_trivially_copyable_v<T>, "FileCursor only reads trivially copyable types");
+
+    /// The run being read.
+    FilePtr file_;
+
+    /// The name of the run, for error messages.
+    std::filesystem::path path_;
+
+    /// Holds the block last read.
+    ManagedDynamicArray<T> buffer_;
+
+    /// Byte offset of the next block in the file.
+    std::int64_t offset_;
+
+public:
+    /**
+     * @brief Opens a run for reading.
+     *
+     * @param path The run to read.
+     * @param buffer_size Number of elements read at a time.
+     * @throws std::runtime_error If the file cannot be opened.
+     */
+    FileCursor(const std::filesystem::path & path, int buffer_size);
+
+    /**
+     * @throws std::runtime_error If the read fails or the file ends part way through an element.
+     */
+    std::span<const T> next_block() override;
+};
+
+template <typename T>
+/**
+ * @class FileSink
+ * @brief Writes the output of a merge to a file through a large buffer.
+ *
+ * @tparam T The trivially copyable type of the elements, stored in native byte order.
+ */
+class FileSink : public MergeSink<T>
+{
+    static_assert(std::is_trivially_copyable_v<T>, "FileSink only writes trivially copyable types");
+
+    /// The file being written.
+    FilePtr file_;
+
+    /// The name of the file, for error messages.
+    std::filesystem::path path_;
+
+    /// Holds the block being filled.
+    ManagedDynamicArray<T> buffer_;
+
+public:
+    /**
+     * @brief Creates or replaces a file for writing.
+     *
+     * @param path The file to write.
+     * @param buffer_size Number of elements written at a time.
+     * @throws std::runtime_error If the file cannot be opened.
+     */
+    FileSink(const std::filesystem::path & path, int buffer_size);
+
+    std::span<T> next_block() override;
+
+    /**
+     * @throws std::runtime_error If the write fails.
+     */
+    void commit(int count) override;
+};
+
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @class LoserTree
+ * @brief Merges k sorted runs with a tournament tree that keeps the loser of each match.
+ *
+ * @tparam T The type of elements.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
+ *
+ * Each leaf is the head of a run and each internal node holds the run that lost the
+ * match played there, while the overall winner is kept above the root. Once the
+ * winner is written, only the matches on the path from its leaf to the root are
+ * replayed, against the losers already stored there, so every element costs
+ * log2(k) comparisons. A binary heap pays about 2 log2(k), comparing both children
+ * at every level of a sift, and a d-ary heap pays d per level.
+ *
+ * Heads are compared in place in the blocks the cursors hand out, which are only
+ * refilled when used up. Elements from earlier runs win ties, so the merge is
+ * stable. For 32- and 64-bit integers ordered by std::less or std::greater, each
+ * node instead holds the key and the run packed into one word of twice the width
+ * that orders the same way, ties included, so a match is a min that compiles to
+ * conditional moves. The outcome of a match is as good as random, so a branch
+ * would be mispredicted half the time.
+ *
+ * @section Example
+ * @code
+ * SpanCursor<int> a(first), b(second);
+ * RunCursor<int> * runs[] = {&a, &b};
+ * SpanSink<int> sink(output);
+ * LoserTree<int>(runs).merge(sink);
+ * @endcode
+ */
+class LoserTree
+{
+    /// The unsigned integer a key is packed as, with the same width as the key.
+    using KeyBits = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+
+#ifdef __SIZEOF_INT128__
+    /// Holds a packed 64-bit key above a run index. __extension__ keeps -Wpedantic quiet about the type.
+    __extension__ typedef unsigned __int128 WideWord;
+#else
+    /// Never used to pack, since 64-bit keys are only packed where 128-bit integers exist.
+    using WideWord = std::uint64_t;
+#endif
+
+    /// Whether keys and runs are packed into words that are ordered without a branch.
+    static constexpr bool PACKED_KEYS = std::is_integral_v<T>
+        && (sizeof(T) == 4 || (sizeof(T) == 8 && sizeof(WideWord) == 16))
+        && (std::is_same_v<Compare, std::less<T>> || std::is_same_v<Compare, std::greater<T>>);
+
+    /**
+     * @brief A player in the tournament.
+     *
+     * The index of a run, plus k once the run is used up, which makes it lose every
+     * match. When PACKED_KEYS holds, the head of the run is packed above the index,
+     * so the word is twice the width of the key.
+     */
+    using Node = std::conditional_t<PACKED_KEYS, std::conditional_t<sizeof(T) == 4, std::uint64_t, WideWord>, int>;
+
+    /**
+     * @brief The unused part of the block a run last handed out.
+     */
+    struct Head
+    {
+        /// The head of the run.
+        const T * pos;
+
+        /// The end of the block.
+        const T * end;
+    };
+
+    /// The runs being merged.
+    std::vector<RunCursor<T> *> runs_;
+
+    /// The rest of each run's block.
+    std::vector<Head> heads_;
+
+    /// The overall winner at index 0 and the loser of each match at indexes 1 to k - 1.
+    std::vector<Node> tree_;
+
+    /// Number of runs.
+    int num_runs_;
+
+    /// Orders the elements.
+    [[no_unique_address]] InstrumentedCompare<Compare> compare_;
+
+    /**
+     * @brief Returns the player for a run, fetching its next block if the current one is used up.
+     *
+     * @param run Index of the run.
+     * @return The player, which is marked used up if the run has no more elements.
+     */
+    Node player(int run);
+
+    /**
+     * @brief Returns the run a player stands for.
+     *
+     * @param node The player.
+     * @return Index of the run, plus k if it is used up.
+     */
+    static int run_of(Node node);
+
+    /**
+     * @brief Returns whether one player is written before another.
+     *
+     * @param a The first player.
+     * @param b The second player.
+     * @return true if @p a wins: its head comes first, or the heads tie and @p a is the earlier run,
+     * or @p b is used up while @p a is not.
+     */
+    bool beats(Node a, Node b) const;
+
+public:
+    /**
+     * @brief Constructs a tree over sorted runs and plays the first tournament.
+     *
+     * @param runs The runs, each of which must outlive the tree. Ties go to the earlier of them.
+     * @param compare The comparator used to order the elements.
+     */
+    explicit LoserTree(std::span<RunCursor<T> * const> runs, Compare compare = Compare());
+
+    /**
+     * @brief Returns whether every run is used up.
+     *
+     * @return true if there are no elements left.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Returns the next element of the merge. The tree must not be empty.
+     *
+     * @return The element.
+     */
+    const T & top() const;
+
+    /**
+     * @brief Returns the run the next element of the merge comes from. The tree must not be empty.
+     *
+     * @return Index of the run.
+     */
+    int top_run() const;
+
+    /**
+     * @brief Moves past the next element of the merge. The tree must not be empty.
+     */
+    void pop();
+
+    /**
+     * @brief Writes every element left in the runs to a sink, in order.
+     *
+     * @param sink The sink to write to.
+     * @return The number of elements written.
+     */
+    std::int64_t merge(MergeSink<T> & sink);
+};
+
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @brief Merges sorted spans into one span with a LoserTree.
+ *
+ * @tparam T The type of elements.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
+ * @param runs The sorted spans. Ties go to the earlier of them.
+ * @param output The span to write to, which must not overlap any run.
+ * @param compare The comparator used to order the elements.
+ * @throws std::runtime_error If the size of @p output is not the total size of @p runs.
+ *
+ * @section Example
+ * @code
+ * std::span<const int> runs[] = {first, second, third};
+ * kway_merge<int>(runs, output);
+ * @endcode
+ */
+void kway_merge(std::span<const std::span<const T>> runs, std::span<T> output, Compare compare = Compare());
+
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @brief Merges sorted files of fixed-size elements into one file with a LoserTree.
+ *
+ * @tparam T The trivially copyable type of the elements, stored in native byte order.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
+ * @param runs The sorted files. Ties go to the earlier of them.
+ * @param output The file to write to. It is replaced if it exists.
+ * @param buffer_size Number of elements in the read buffer of each run and in the output buffer.
+ * @param compare The comparator used to order the elements.
+ * @return The number of elements written.
+ * @throws std::runtime_error If a file cannot be opened, read or written.
+ */
+std::int64_t kway_merge(const std::vector<std::filesystem::path> & runs, const std::filesystem::path & output,
+    int buffer_size, Compare compare = Compare());
+
+template <typename T>
+SpanCursor<T>::SpanCursor(std::span<const T> run) : run_(run) {}
+
+template <typename T>
+std::span<const T> SpanCursor<T>::next_block()
+{
+    return std::exchange(run_, std::span<const T>());
+}
+
+template <typename T>
+SpanSink<T>::SpanSink(std::span<T> output) : output_(output), count_(0) {}
+
+template <typename T>
+int SpanSink<T>::size() const
+{
+    return count_;
+}
+
+template <typename T>
+std::span<T> SpanSink<T>::next_block()
+{
+    if (output_.empty())
+    {
+        throw std::runtime_error("The output of the merge is full after " + std::to_string(count_) + " elements");
+    }
+    return output_;
+}
+
+template <typename T>
+void SpanSink<T>::commit(int count)
+{
+    output_ = output_.subspan(count);
+    count_ += count;
+}
+
+template <typename T>
+FileCursor<T>::FileCursor(const std::filesystem::path & path, int buffer_size)
+    : file_(open_file(path, "rb")), path_(path), buffer_(buffer_size), offset_(0)
+{
+    advise_sequential(file_.get());
+}
+
+template <typename T>
+std::span<const T> FileCursor<T>::next_block()
+{
+    int count = read_elements(file_.get(), buffer_.to_span(), path_);
+    offset_ += static_cast<std::int64_t>(count) * sizeof(T);
+    if (count > 0)
+    {
+        // Start reading the next block in the background while this one is merged.
+        advise_will_need(file_.get(), offset_, buffer_.num_bytes());
+    }
+    return buffer_.to_span(count);
+}
+
+template <typename T>
+FileSink<T>::FileSink(const std::filesystem::path & path, int buffer_size)
+    : file_(open_file(path, "wb")), path_(path), buffer_(buffer_size) {}
+
+template <typename T>
+std::span<T> FileSink<T>::next_block()
+{
+    return buffer_.to_span();
+}
+
+template <typename T>
+void FileSink<T>::commit(int count)
+{
+    write_elements<T>(file_.get(), buffer_.to_span(count), path_);
+}
+
+template <typename T, typename Compare>
+LoserTree<T, Compare>::LoserTree(std::span<RunCursor<T> * const> runs, Compare compare)
+    : runs_(runs.begin(), runs.end()), heads_(runs.size(), Head{nullptr, nullptr}),
+      tree_(std::max<std::size_t>(runs.size(), 1), 0), num_runs_(runs.size()), compare_(compare)
+{
+    // Leaves sit at indexes k to 2k - 1 of an implicit complete binary tree, so the
+    // node above index i is i / 2. Winners are only needed while the tree is built.
+    std::vector<Node> winners(2 * num_runs_);
+    for (int run = 0; run < num_runs_; ++run)
+    {
+        winners[num_runs_ + run] = player(run);
+    }
+    for (int node = num_runs_ - 1; node >= 1; --node)
+    {
+        Node left = winners[2 * node];
+        Node right = winners[2 * node + 1];
+        bool left_wins = beats(left, right);
+        winners[node] = left_wins ? left : right;
+        tree_[node] = left_wins ? right : left;
+    }
+    if (num_runs_ > 0)
+    {
+        tree_[0] = winners[1];
+    }
+}
+
+template <typename T, typename Compare>
+typename LoserTree<T, Compare>::Node LoserTree<T, Compare>::player(int run)
+{
+    Head & head = heads_[run];
+    if (head.pos == head.end)
+    {
+        std::span<const T> block = runs_[run]->next_block();
+        head = Head{block.data(), block.data() + block.size()};
+    }
+    bool used_up = head.pos == head.end;
+    if constexpr (PACKED_KEYS)
+    {
+        // Flipping the sign bit orders signed keys as unsigned, and flipping every bit reverses the order.
+        // A used-up run gets the largest key, and its index past every run breaks the tie with a real one.
+        const KeyBits SIGN_FLIP = std::is_signed_v<T> ? KeyBits(1) << (sizeof(T) * 8 - 1) : KeyBits(0);
+        const KeyBits ORDER_FLIP = std::is_same_v<Compare, std::greater<T>> ? ~KeyBits(0) : KeyBits(0);
+        KeyBits bits = used_up ? ~KeyBits(0) : (static_cast<KeyBits>(*head.pos) ^ SIGN_FLIP ^ ORDER_FLIP);
+        std::uint32_t index = used_up ? run + num_runs_ : run;
+        return static_cast<Node>(bits) << (sizeof(T) * 8) | index;
+    }
+    else
+    {
+        return used_up ? run + num_runs_ : run;
+    }
+}
+
+template <typename T, typename Compare>
+int LoserTree<T, Compare>::run_of(Node node)
+{
+    return static_cast<int>(static_cast<std::uint32_t>(node));
+}
+
+template <typename T, typename Compare>
+bool LoserTree<T, Compare>::beats(Node a, Node b) const
+{
+    if constexpr (PACKED_KEYS)
+    {
+        Instrumentation::count_comparison();
+        return a < b;
+    }
+    else
+    {
+        bool a_earlier = a < b;
+        if (std::max(a, b) >= num_runs_)
+        {
+            // A used-up run has the larger index, so it loses to any run that is not.
+            return a_earlier;
+        }
+        // The earlier run wins unless the later head is strictly before it.
+        const T & a_key = *heads_[a].pos;
+        const T & b_key = *heads_[b].pos;
+        return a_earlier ? !compare_(b_key, a_key) : compare_(a_key, b_key);
+    }
+}
+
+template <typename T, typename Compare>
+bool LoserTree<T, Compare>::empty() const
+{
+    return num_runs_ == 0 || run_of(tree_[0]) >= num_runs_;
+}
+
+template <typename T, typename Compare>
+const T & LoserTree<T, Compare>::top() const
+{
+    return *heads_[run_of(tree_[0])].pos;
+}
+
+template <typename T, typename Compare>
+int LoserTree<T, Compare>::top_run() const
+{
+    return run_of(tree_[0]);
+}
+
+template <typename T, typename Compare>
+void LoserTree<T, Compare>::pop()
+{
+    // Copied so the stores into the tree cannot make the compiler reload them on every level.
+    int num_runs = num_runs_;
+    Node * tree = tree_.data();
+    int run = run_of(tree[0]);
+    ++heads_[run].pos;
+    Node winner = player(run);
+
+    // Only the matches on the path from the winner's leaf to the root can change.
+    for (int node = (num_runs + run) / 2; node >= 1; node /= 2)
+    {
+        if constexpr (PACKED_KEYS)
+        {
+            Instrumentation::count_comparison();
+            // The loser is derived from the winner rather than taken with std::max, or the compiler
+            // notices the store is only needed when the other player loses and branches around it.
+            Node other = tree[node];
+            Node next_winner = std::min(winner, other);
+            tree[node] = winner ^ other ^ next_winner;
+            winner = next_winner;
+        }
+        else if (beats(tree[node], winner))
+        {
+            std::swap(tree[node], winner);
+        }
+    }
+    tree[0] = winner;
+}
+
+template <typename T, typename Compare>
+std::int64_t LoserTree<T, Compare>::merge(MergeSink<T> & sink)
+{
+    std::int64_t total = 0;
+    while (!empty())
+    {
+        std::span<T> block = sink.next_block();
+        int capacity = block.size();
+        int count = 0;
+        while (count < capacity && !empty())
+        {
+            block[count++] = top();
+            pop();
+        }
+        sink.commit(count);
+        total += count;
+    }
+    Instrumentation::count_moves(total);
+    return total;
+}
+
+template <typename T, typename Compare>
+void kway_merge(std::span<const std::span<const T>> runs, std::span<T> output, Compare compare)
+{
+    std::size_t total = 0;
+    std::vector<SpanCursor<T>> cursors;
+    cursors.reserve(runs.size());
+    for (std::span<const T> run : runs)
+    {
+        total += run.size();
+        cursors.emplace_back(run);
+    }
+    if (total != output.size())
+    {
+        throw std::runtime_error("Cannot merge " + std::to_string(total) + " elements into "
+            + std::to_string(output.size()));
+    }
+    std::vector<RunCursor<T> *> cursor_ptrs;
+    cursor_ptrs.reserve(cursors.size());
+    for (SpanCursor<T> & cursor : cursors)
+    {
+        cursor_ptrs.push_back(&cursor);
+    }
+    SpanSink<T> sink(output);
+    LoserTree<T, Compare>(cursor_ptrs, compare).merge(sink);
+}
+
+template <typename T, typename Compare>
+std::int64_t kway_merge(const std::vector<std::filesystem::path> & runs, const std::filesystem::path & output,
+    int buffer_size, Compare compare)
+{
+    std::vector<std::unique_ptr<FileCursor<T>>> cursors;
+    std::vector<RunCursor<T> *> cursor_ptrs;
+    cursors.reserve(runs.size());
+    cursor_ptrs.reserve(runs.size());
+    for (const std::filesystem::path & run : runs)
+    {
+        cursors.push_back(std::make_unique<FileCursor<T>>(run, buffer_size));
+        cursor_ptrs.push_back(cursors.back().get());
+    }
+    FileSink<T> sink(output, buffer_size);
+    return LoserTree<T, Compare>(cursor_ptrs, compare).merge(sink);
+}
@@ -1,17 +1,48 @@
+#include <algorithm>
 #include <cassert>
-#include <iostream>
+#include <climits>
+#include <cstdint>
 #include <cstdlib>
-#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 #include "main.h"
+#include "argsort.h"
+#include "autotune.h"
+#include "benchmark.h"
 #include "bubble.h"
+#include "dary_heap.h"
+#include "external_sort.h"
+#include "generator.h"
 #include "heap.h"
 #include "insertion.h"
+#include "key_index.h"
+#include "key_value.h"
+#include "loser_tree.h"
 #include "managed_dynamic_array.h"
+#include "mapped_file.h"
 #include "merge.h"
+#include "network.h"
+#include "parallel_merge.h"
+#include "pdq.h"
+#include "perf_counters.h"
+#include "power.h"
+#include "probing.h"
 #include "quick.h"
+#include "radix.h"
+#include "record.h"
+#include "select.h"
 #include "selection.h"
 #include "stopwatch.h"
+#include "streaming_top_k.h"
 #include <memory>
 
 bool are_identical(std::span<const int> x, std::span<const int> y, int count)
@@ -26,11 +57,12 @@ bool are_identical(std::span<const int> x, std::span<const int> y, int count)
     return true;
 }
 
-bool is_sorted(std::span<const int> ary, int count)
+template <typename Compare = std::less<int>>
+bool is_sorted(std::span<const int> ary, int count, Compare compare = Compare())
 {
     for (int i = 0; i < (count - 1); ++i)
     {
-        if (ary[i] > ary[i + 1])
+        if (compare(ary[i + 1], ary[i]))
         {
             return false;
         }
@@ -38,20 +70,855 @@ bool is_sorted(std::span<const int> ary, int count)
     return true;
 }
 
+/// Seeds every random input, so each run sorts the same data.
+const std::uint64_t RANDOM_SEED = 1;
+
 ManagedDynamicArray<int> get_randoms(int capacity, int max_exclusive)
 {
-    srand(time(NULL));
+    // Few-unique keys drawn from [0, max_exclusive), which is uniform over that range.
+    DistributionSpec spec;
+    spec.distribution = Distribution::FEW_UNIQUE;
+    spec.num_unique = max_exclusive;
+    spec.seed = RANDOM_SEED;
     ManagedDynamicArray<int> randoms(capacity);
-    int i = capacity;
-    while (i--)
+    InputGenerator<int>().generate(randoms.to_span(), spec);
+    return randoms;
+}
+
+template <typename T>
+ManagedDynamicArray<T> get_random_values(int capacity)
+{
+    DistributionSpec spec;
+    spec.seed = RANDOM_SEED;
+    ManagedDynamicArray<T> values(capacity);
+    InputGenerator<T>().generate(values.to_span(), spec);
+    return values;
+}
+
+template <typename T>
+void benchmark_sorters(const char * type_name, ManagedDynamicArray<T> & values)
+{
+    auto heap_sorter = HeapSorter<T>();
+    auto network_sorter = NetworkSorter<T>();
+    auto merge_sorter = MergeSorter<T>(network_sorter, NetworkSorter<T>::BLOCK_SIZE);
+    auto quick_sorter = QuickSorter<T>();
+    auto block_quick_sorter = QuickSorter<T>(PartitionScheme::BLOCK);
+    auto pdq_sorter = PdqSorter<T>();
+    auto parallel_merge_sorter = ParallelMergeSorter<T>(merge_sorter);
+    auto power_sorter = PowerSorter<T>();
+    Sorter<T> * sorters[] = {
+        &heap_sorter, &merge_sorter, &quick_sorter, &block_quick_sorter,
+        &pdq_sorter, &parallel_merge_sorter, &network_sorter, &power_sorter
+    };
+
+    ManagedDynamicArray<T> to_sort(values.size());
+    for (Sorter<T> * sorter : sorters)
     {
-        randoms[i] = rand() % max_exclusive;
+        to_sort.copy_from(values);
+        std::span<T> span_to_sort = to_sort.to_span();
+        Stopwatch stopwatch;
+        sorter->sort(span_to_sort);
+        int elapsed = stopwatch.elapsed_milliseconds();
+        bool srted = std::is_sorted(span_to_sort.begin(), span_to_sort.end());
+        std::cout << sorter->name() << " Sort of random " << type_name << " array finished "
+            << (srted ? "successfully" : "unsuccessfully") << " in " << elapsed << " milliseconds" << std::endl;
     }
-    return randoms;
+}
+
+void benchmark_presorted(std::span<const Sorter<int> * const> sorters)
+{
+    // Appended batches and data sorted by a nearby key look like these rather than like uniform noise.
+    const int PRESORTED_CAPACITY = 1000000;
+    const Distribution distributions[] = {
+        Distribution::SORTED, Distribution::REVERSED, Distribution::NEARLY_SORTED, Distribution::SAWTOOTH
+    };
+    InputGenerator<int> generator;
+    ManagedDynamicArray<int> values(PRESORTED_CAPACITY);
+    ManagedDynamicArray<int> to_sort(PRESORTED_CAPACITY);
+    for (Distribution distribution : distributions)
+    {
+        DistributionSpec spec;
+        spec.distribution = distribution;
+        spec.seed = RANDOM_SEED;
+        generator.generate(values.to_span(), spec);
+        for (const Sorter<int> * sorter : sorters)
+        {
+            to_sort.copy_from(values);
+            std::span<int> span_to_sort = to_sort.to_span();
+            Stopwatch stopwatch;
+            sorter->sort(span_to_sort);
+            int elapsed = stopwatch.elapsed_milliseconds();
+            bool srted = std::is_sorted(span_to_sort.begin(), span_to_sort.end());
+            std::cout << sorter->name() << " Sort of " << distribution_name(distribution) << " array finished "
+                << (srted ? "successfully" : "unsuccessfully") << " in " << elapsed << " milliseconds" << std::endl;
+        }
+    }
+}
+
+void log_probe_decisions(const ProbingSorter<int> & sorter)
+{
+    // Show what the probe sees in each shape of input and which engine it picks, and what the look costs.
+    const int PROBE_CAPACITY = 1000000;
+    InputGenerator<int> generator;
+    ManagedDynamicArray<int> values(PROBE_CAPACITY);
+    for (int i = 0; i < NUM_DISTRIBUTIONS; i++)
+    {
+        DistributionSpec spec;
+        spec.distribution = static_cast<Distribution>(i);
+        spec.seed = RANDOM_SEED;
+        generator.generate(values.to_span(), spec);
+        Stopwatch probe_stopwatch;
+        ProbeDecision decision = sorter.decide(values.to_span());
+        std::int64_t probe_elapsed = probe_stopwatch.elapsed_nanoseconds();
+        Stopwatch sort_stopwatch;
+        sorter.sort(values.to_span());
+        std::int64_t sort_elapsed = sort_stopwatch.elapsed_nanoseconds();
+        const Presortedness & seen = decision.presortedness;
+        std::cout << sorter.name() << " chose " << strategy_name(decision.strategy) << " for "
+            << distribution_name(spec.distribution) << " input with " << seen.runs << " runs in the first "
+            << seen.scanned << " elements, " << seen.inversion_fraction << " of sampled pairs inverted and "
+            << seen.sampled_distinct << " of " << seen.sample_size << " sampled keys distinct; probing took " << probe_elapsed / 1000
+            << " microseconds of the " << sort_elapsed / 1000 << " the sort took" << std::endl;
+    }
+}
+
+void check_small_probing(const ProbingSorter<int> & sorter, std::span<const int> randoms)
+{
+    // Small inputs are decided on a full scan, where a look at the first pair would call {1, 2, 0} sorted.
+    const int MAX_SIZE = 2 * ProbingSorter<int>::SMALL_SIZE;
+    ManagedDynamicArray<int> to_sort(MAX_SIZE);
+    bool srted = true;
+    for (int size = 0; size <= MAX_SIZE; ++size)
+    {
+        std::span<int> span_to_sort = to_sort.to_span(size);
+        std::copy(randoms.begin(), randoms.begin() + size, span_to_sort.begin());
+        sorter.sort(span_to_sort);
+        srted = srted && is_sorted(span_to_sort, size);
+    }
+    const int small_input[] = {5, 4, 9, 1, 2, 3, 7, 8, 6, 0};
+    std::copy(std::begin(small_input), std::end(small_input), to_sort.to_span().begin());
+    sorter.sort(to_sort.to_span(std::size(small_input)));
+    srted = srted && is_sorted(to_sort.to_span(), std::size(small_input));
+    std::cout << sorter.name() << " Sort of every size up to " << MAX_SIZE << " is correct: "
+        << (srted ? "true" : "false") << std::endl;
+
+    // Each change of direction goes through a plateau, which must still end the run before it.
+    const int plateaus[] = {1, 2, 2, 1, 1, 2, 2, 1};
+    int runs = sorter.probe(plateaus).runs;
+    std::cout << sorter.name() << " probe of a zig-zag that turns on plateaus counts its 4 runs: "
+        << (runs == 4 ? "true" : "false") << std::endl;
+
+    // Large inputs only measure the key range of a sample, which misses an extreme key between samples.
+    const int OUTLIER_CAPACITY = 100000;
+    ManagedDynamicArray<int> outlier(OUTLIER_CAPACITY);
+    for (int i = 0; i < OUTLIER_CAPACITY; ++i)
+    {
+        outlier[i] = randoms[i % randoms.size()] % 16;
+    }
+    outlier[1] = INT_MAX;
+    ProbeDecision decision = sorter.sort_and_decide(outlier.to_span());
+    srted = is_sorted(outlier.to_span(), OUTLIER_CAPACITY);
+    std::cout << sorter.name() << " Sort of few keys and one far outlier is correct: " << (srted ? "true" : "false")
+        << " after choosing " << strategy_name(decision.strategy) << std::endl;
+}
+
+/**
+ * @struct BoxedKey
+ * @brief An int key held through a std::unique_ptr, so it can be moved but not copied.
+ */
+struct BoxedKey
+{
+    /// The key the element is ordered by.
+    std::unique_ptr<int> key;
+
+    /**
+     * @brief Orders two elements by their keys.
+     *
+     * @param other The element to compare against.
+     * @return true if this key is less than the key of @p other; false otherwise.
+     */
+    bool operator<(const BoxedKey & other) const
+    {
+        return *key < *other.key;
+    }
+};
+
+void check_move_only(std::span<const int> randoms)
+{
+    // Every comparison sorter and its scratch space must get by on moves alone.
+    const int MOVE_ONLY_CAPACITY = 2000;
+    auto heap_sorter = HeapSorter<BoxedKey>();
+    auto bubble_sorter = BubbleSorter<BoxedKey>();
+    auto cocktail_sorter = CocktailShakerSorter<BoxedKey>();
+    auto insertion_sorter = InsertionSorter<BoxedKey>();
+    auto selection_sorter = SelectionSorter<BoxedKey>();
+    auto network_sorter = NetworkSorter<BoxedKey>();
+    auto merge_sorter = MergeSorter<BoxedKey>(network_sorter, NetworkSorter<BoxedKey>::BLOCK_SIZE);
+    auto quick_sorter = QuickSorter<BoxedKey>();
+    auto block_quick_sorter = QuickSorter<BoxedKey>(PartitionScheme::BLOCK);
+    auto pdq_sorter = PdqSorter<BoxedKey>();
+    auto parallel_merge_sorter = ParallelMergeSorter<BoxedKey>(merge_sorter);
+    auto power_sorter = PowerSorter<BoxedKey>();
+    auto probing_sorter = ProbingSorter<BoxedKey>();
+    Sorter<BoxedKey> * sorters[] = {
+        &heap_sorter, &bubble_sorter, &cocktail_sorter, &insertion_sorter, &selection_sorter,
+        &network_sorter, &merge_sorter, &quick_sorter, &block_quick_sorter, &pdq_sorter,
+        &parallel_merge_sorter, &power_sorter, &probing_sorter
+    };
+    ManagedDynamicArray<BoxedKey> to_sort(MOVE_ONLY_CAPACITY);
+    for (Sorter<BoxedKey> * sorter : sorters)
+    {
+        for (int i = 0; i < MOVE_ONLY_CAPACITY; ++i)
+        {
+            to_sort[i].key = std::make_unique<int>(randoms[i]);
+        }
+        std::span<BoxedKey> span_to_sort = to_sort.to_span();
+        sorter->sort(span_to_sort);
+        bool srted = std::is_sorted(span_to_sort.begin(), span_to_sort.end());
+        std::cout << sorter->name() << " Sort of a move-only type is correct: "
+            << (srted ? "true" : "false") << std::endl;
+    }
+}
+
+void check_streams()
+{
+    // Swapping the seed and the stream number must not give the same generator.
+    Xoshiro256 forward(1, 2);
+    Xoshiro256 swapped(2, 1);
+    bool distinct = true;
+    for (int i = 0; i < 4; ++i)
+    {
+        distinct = distinct && forward() != swapped();
+    }
+    std::cout << "Xoshiro256 streams with the seed and stream swapped are distinct: "
+        << (distinct ? "true" : "false") << std::endl;
+}
+
+void check_custom_compares(std::span<const int> randoms)
+{
+    // The sorters are defined in their headers, so a comparator the library never names still links.
+    const int RECORD_CAPACITY = 100000;
+    using ByKey = ProjectedCompare<decltype(&Record::key), std::greater<>>;
+    auto records = get_random_values<Record>(RECORD_CAPACITY);
+    auto record_sorter = PdqSorter<Record, ByKey>(ByKey{&Record::key});
+    record_sorter.sort(records.to_span());
+    bool srted = std::is_sorted(records.to_span().begin(), records.to_span().end(),
+        [](const Record & x, const Record & y) { return x.key > y.key; });
+    std::cout << record_sorter.name() << " Sort of records by a projected key is correct: "
+        << (srted ? "true" : "false") << std::endl;
+
+    // Merges two sorted halves of the records back together through a LoserTree with the same comparator.
+    auto halves = get_random_values<Record>(RECORD_CAPACITY);
+    std::span<Record> first = halves.to_span(RECORD_CAPACITY / 2);
+    std::span<Record> second = halves.to_span().subspan(RECORD_CAPACITY / 2);
+    record_sorter.sort(first);
+    record_sorter.sort(second);
+    std::span<const Record> runs[] = {first, second};
+    ManagedDynamicArray<Record> merged(RECORD_CAPACITY);
+    kway_merge<Record, ByKey>(runs, merged.to_span(), ByKey{&Record::key});
+    srted = std::is_sorted(merged.to_span().begin(), merged.to_span().end(),
+        [](const Record & x, const Record & y) { return x.key > y.key; });
+    std::cout << "LoserTree merge of records by a projected key is correct: "
+        << (srted ? "true" : "false") << std::endl;
+
+    // Keeps the records with the largest keys, which needs the scalar scan and a heap ordered by the projection.
+    const int TOP_RECORDS = 100;
+    auto best = top_k<Record, ByKey>(halves.to_span(), TOP_RECORDS, ByKey{&Record::key});
+    std::span<const Record> sorted_best = merged.to_span(TOP_RECORDS);
+    bool matches = std::equal(best.to_span().begin(), best.to_span().end(), sorted_best.begin(),
+        [](const Record & x, const Record & y) { return x.key == y.key; });
+    std::cout << "top_k of records by a projected key is correct: " << (matches ? "true" : "false") << std::endl;
+
+    // Orders by distance from a pivot only known at run time, so the comparator carries state.
+    int pivot = randoms[randoms.size() / 2];
+    auto by_distance = [pivot](int x, int y) { return std::abs(x - pivot) < std::abs(y - pivot); };
+    ManagedDynamicArray<int> to_sort(randoms.size());
+    to_sort.copy_from(randoms.data(), randoms.size());
+    using ByDistance = decltype(by_distance);
+    auto lambda_sorter = QuickSorter<int, ByDistance>(PartitionScheme::BLOCK,
+        QuickSorter<int, ByDistance>::DEFAULT_SMALL_SIZE, by_distance);
+    lambda_sorter.sort(to_sort.to_span());
+    srted = std::is_sorted(to_sort.to_span().begin(), to_sort.to_span().end(), by_distance);
+    std::cout << lambda_sorter.name() << " Sort by a stateful lambda is correct: "
+        << (srted ? "true" : "false") << std::endl;
+}
+
+void benchmark_argsort(ManagedDynamicArray<Record> & records, const Sorter<Record> & record_sorter,
+    const Sorter<KeyIndex<std::int64_t>> & key_sorter)
+{
+    int count = records.size();
+    ManagedDynamicArray<Record> direct(count);
+    direct.copy_from(records);
+    Stopwatch direct_stopwatch;
+    record_sorter.sort(direct.to_span());
+    int direct_elapsed = direct_stopwatch.elapsed_milliseconds();
+
+    /* Sort only the keys and their indices, then move every record once to
+     * where the permutation says it belongs. */
+    ManagedDynamicArray<Record> indirect(count);
+    indirect.copy_from(records);
+    Stopwatch indirect_stopwatch;
+    ManagedDynamicArray<std::int64_t> keys(count);
+    for (int i = 0; i < count; ++i)
+    {
+        keys[i] = indirect[i].key;
+    }
+    auto permutation = argsort(keys.to_span(), key_sorter);
+    apply_permutation(permutation.to_span(), indirect.to_span());
+    int indirect_elapsed = indirect_stopwatch.elapsed_milliseconds();
+
+    std::span<Record> sorted = indirect.to_span();
+    bool srted = std::is_sorted(sorted.begin(), sorted.end());
+    std::cout << record_sorter.name() << " Sort of 128-byte Record array took " << direct_elapsed
+        << " milliseconds directly and " << indirect_elapsed << " milliseconds through argsort, which finished "
+        << (srted ? "successfully" : "unsuccessfully") << std::endl;
+}
+
+/**
+ * @brief Checks that every price and quantity still belongs to the key beside it.
+ */
+bool columns_match(std::span<const std::int64_t> keys, std::span<const double> prices, std::span<const int> quantities)
+{
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        if (prices[i] != keys[i] * 0.5 || quantities[i] != static_cast<int>(keys[i] % 1000))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void benchmark_sort_by_key(std::span<const std::int64_t> random_keys)
+{
+    int count = random_keys.size();
+    ManagedDynamicArray<std::int64_t> keys(count);
+    ManagedDynamicArray<double> prices(count);
+    ManagedDynamicArray<int> quantities(count);
+    auto fill_columns = [&]
+    {
+        keys.copy_from(random_keys.data(), count);
+        for (int i = 0; i < count; ++i)
+        {
+            prices[i] = keys[i] * 0.5;
+            quantities[i] = static_cast<int>(keys[i] % 1000);
+        }
+    };
+    auto report = [&](const char * approach, int elapsed)
+    {
+        std::span<std::int64_t> key_span = keys.to_span();
+        bool srted = std::is_sorted(key_span.begin(), key_span.end())
+            && columns_match(key_span, prices.to_span(), quantities.to_span());
+        std::cout << approach << " of " << count << " keys and 2 payload columns finished "
+            << (srted ? "successfully" : "unsuccessfully") << " in " << elapsed << " milliseconds" << std::endl;
+    };
+
+    // The approach sort_by_key replaces: zip the columns into rows, sort the rows and unzip them.
+    struct Row
+    {
+        std::int64_t key;
+        double price;
+        int quantity;
+    };
+    fill_columns();
+    Stopwatch zip_stopwatch;
+    std::vector<Row> rows(count);
+    for (int i = 0; i < count; ++i)
+    {
+        rows[i] = Row{keys[i], prices[i], quantities[i]};
+    }
+    std::stable_sort(rows.begin(), rows.end(), [](const Row & x, const Row & y) { return x.key < y.key; });
+    for (int i = 0; i < count; ++i)
+    {
+        keys[i] = rows[i].key;
+        prices[i] = rows[i].price;
+        quantities[i] = rows[i].quantity;
+    }
+    report("Zip, std::stable_sort and unzip", zip_stopwatch.elapsed_milliseconds());
+
+    const SortEngine engines[] = {SortEngine::MERGE, SortEngine::QUICK, SortEngine::RADIX};
+    const char * engine_names[] = {"Merge sort_by_key", "Quick sort_by_key", "Radix sort_by_key"};
+    for (int i = 0; i < 3; ++i)
+    {
+        fill_columns();
+        Stopwatch stopwatch;
+        sort_by_key(engines[i], keys.to_span(), prices.to_span(), quantities.to_span());
+        report(engine_names[i], stopwatch.elapsed_milliseconds());
+    }
+}
+
+int benchmark_heap(std::span<const int> values)
+{
+    Heap<int> heap(values.size());
+    Stopwatch stopwatch;
+    for (int value : values)
+    {
+        heap.store(value);
+    }
+    while (heap.take().has_value());
+    return stopwatch.elapsed_milliseconds();
+}
+
+template <int D>
+int benchmark_dary_heap(std::span<const int> values)
+{
+    DAryHeap<int, D> heap(values.size());
+    Stopwatch stopwatch;
+    for (int value : values)
+    {
+        heap.store(value);
+    }
+    while (!heap.empty())
+    {
+        heap.take();
+    }
+    return stopwatch.elapsed_milliseconds();
+}
+
+template <int D>
+int benchmark_dary_heap_replace_top(std::span<const int> values)
+{
+    // Mimics rescheduling timers: the heap stays full while the earliest entry is replaced.
+    int half = values.size() / 2;
+    DAryHeap<int, D> heap(half);
+    heap.store(values.first(half));
+    Stopwatch stopwatch;
+    for (int value : values.subspan(half))
+    {
+        heap.replace_top(value);
+    }
+    return stopwatch.elapsed_milliseconds();
+}
+
+void benchmark_selection()
+{
+    // A median or the best hundred scores should not cost a full sort.
+    const int SELECT_CAPACITY = 5000000;
+    const int TOP_COUNT = 100;
+    auto values = get_random_values<int>(SELECT_CAPACITY);
+    ManagedDynamicArray<int> sorted(SELECT_CAPACITY);
+    sorted.copy_from(values);
+    Stopwatch sort_stopwatch;
+    PdqSorter<int>().sort(sorted.to_span());
+    std::cout << "Pattern-Defeating Quick Sort of " << SELECT_CAPACITY << " ints for comparison finished in "
+        << sort_stopwatch.elapsed_milliseconds() << " milliseconds" << std::endl;
+
+    ManagedDynamicArray<int> to_select(SELECT_CAPACITY);
+    to_select.copy_from(values);
+    int middle = SELECT_CAPACITY / 2;
+    Stopwatch select_stopwatch;
+    select_nth(to_select.to_span(), middle);
+    int select_elapsed = select_stopwatch.elapsed_milliseconds();
+    std::cout << "select_nth of the median of " << SELECT_CAPACITY << " ints is correct: "
+        << (to_select[middle] == sorted[middle] ? "true" : "false") << " in " << select_elapsed << " milliseconds"
+        << std::endl;
+
+    to_select.copy_from(values);
+    Stopwatch partial_stopwatch;
+    partial_sort(to_select.to_span(), TOP_COUNT);
+    int partial_elapsed = partial_stopwatch.elapsed_milliseconds();
+    bool partial_correct = std::equal(sorted.data(), sorted.data() + TOP_COUNT, to_select.data());
+    std::cout << "partial_sort of the smallest " << TOP_COUNT << " of " << SELECT_CAPACITY << " ints is correct: "
+        << (partial_correct ? "true" : "false") << " in " << partial_elapsed << " milliseconds" << std::endl;
+
+    Stopwatch top_stopwatch;
+    auto top = top_k<int, std::greater<int>>(values.to_span(), TOP_COUNT);
+    int top_elapsed = top_stopwatch.elapsed_milliseconds();
+    std::span<const int> sorted_span = sorted.to_span();
+    bool top_correct = std::equal(sorted_span.rbegin(), sorted_span.rbegin() + TOP_COUNT, top.data());
+    std::cout << "top_k of the largest " << TOP_COUNT << " of " << SELECT_CAPACITY << " ints is correct: "
+        << (top_correct ? "true" : "false") << " in " << top_elapsed << " milliseconds" << std::endl;
+
+    // The same values arriving in batches, with a look at the leaders halfway through.
+    const int BATCH_SIZE = 4096;
+    StreamingTopK<int, std::greater<int>> stream(TOP_COUNT);
+    ManagedDynamicArray<int> halfway(0);
+    int halfway_seen = 0;
+    Stopwatch stream_stopwatch;
+    for (int begin = 0; begin < SELECT_CAPACITY; begin += BATCH_SIZE)
+    {
+        stream.add(values.to_span().subspan(begin, std::min(BATCH_SIZE, SELECT_CAPACITY - begin)));
+        if (halfway_seen == 0 && stream.seen() >= middle)
+        {
+            halfway = stream.snapshot();
+            halfway_seen = stream.seen();
+        }
+    }
+    auto streamed = stream.snapshot();
+    int stream_elapsed = stream_stopwatch.elapsed_milliseconds();
+    auto expected_halfway = top_k<int, std::greater<int>>(values.to_span(halfway_seen), TOP_COUNT);
+    bool stream_correct = std::equal(streamed.data(), streamed.data() + TOP_COUNT, top.data())
+        && std::equal(halfway.data(), halfway.data() + TOP_COUNT, expected_halfway.data());
+    std::cout << "StreamingTopK of the largest " << TOP_COUNT << " of " << SELECT_CAPACITY << " ints in batches of "
+        << BATCH_SIZE << " is correct: " << (stream_correct ? "true" : "false") << " in " << stream_elapsed
+        << " milliseconds" << std::endl;
+}
+
+template <int D>
+int benchmark_dary_heap_merge(std::span<const std::span<const int>> runs, std::span<int> output)
+{
+    // Each entry is a head and the run it came from, so ties go to the earlier run as in LoserTree.
+    DAryHeap<std::pair<int, int>, D> heap(runs.size());
+    std::vector<int> positions(runs.size(), 0);
+    Stopwatch stopwatch;
+    for (int run = 0; run < static_cast<int>(runs.size()); ++run)
+    {
+        heap.store({runs[run][0], run});
+    }
+    for (int & value : output)
+    {
+        int run = heap.peek().second;
+        value = heap.peek().first;
+        if (++positions[run] < static_cast<int>(runs[run].size()))
+        {
+            heap.replace_top({runs[run][positions[run]], run});
+        }
+        else
+        {
+            heap.take();
+        }
+    }
+    return stopwatch.elapsed_milliseconds();
+}
+
+void benchmark_kway_merge()
+{
+    // Sorted shards arrive in the dozens to the thousands; a loser tree pays one comparison per level.
+    const int MERGE_CAPACITY = 4000000;
+    const int FAN_INS[] = {64, 1024};
+    auto values = get_random_values<int>(MERGE_CAPACITY);
+    ManagedDynamicArray<int> sorted(MERGE_CAPACITY);
+    sorted.copy_from(values);
+    PdqSorter<int>().sort(sorted.to_span());
+    ManagedDynamicArray<int> merged(MERGE_CAPACITY);
+    for (int fan_in : FAN_INS)
+    {
+        ManagedDynamicArray<int> shards(MERGE_CAPACITY);
+        shards.copy_from(values);
+        std::vector<std::span<const int>> runs;
+        for (int run = 0; run < fan_in; ++run)
+        {
+            int begin = static_cast<std::int64_t>(MERGE_CAPACITY) * run / fan_in;
+            int end = static_cast<std::int64_t>(MERGE_CAPACITY) * (run + 1) / fan_in;
+            std::span<int> shard = shards.to_span().subspan(begin, end - begin);
+            PdqSorter<int>().sort(shard);
+            runs.push_back(shard);
+        }
+
+        Stopwatch stopwatch;
+        kway_merge<int>(runs, merged.to_span());
+        int elapsed = stopwatch.elapsed_milliseconds();
+        bool correct = std::equal(sorted.data(), sorted.data() + MERGE_CAPACITY, merged.data());
+        std::cout << "Loser tree merge of " << fan_in << " runs of " << MERGE_CAPACITY << " ints is correct: "
+            << (correct ? "true" : "false") << " in " << elapsed << " milliseconds" << std::endl;
+        std::cout << "4-ary DAryHeap merge of " << fan_in << " runs of " << MERGE_CAPACITY << " ints finished in "
+            << benchmark_dary_heap_merge<4>(runs, merged.to_span()) << " milliseconds" << std::endl;
+    }
+}
+
+void generate_file(const std::filesystem::path & path, std::uintmax_t count,
+    const DistributionSpec & spec = DistributionSpec())
+{
+    const int BLOCK_SIZE = 256 * InputGenerator<int>::BLOCK_SIZE;
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    InputGenerator<int> generator;
+    ManagedDynamicArray<int> block(BLOCK_SIZE);
+    for (std::uintmax_t first = 0; first < count && out; first += BLOCK_SIZE)
+    {
+        int num_values = std::min<std::uintmax_t>(count - first, BLOCK_SIZE);
+        generator.generate(block.to_span(num_values), spec, first, count);
+        out.write(reinterpret_cast<const char *>(block.data()), num_values * sizeof(int));
+    }
+    if (!out)
+    {
+        throw std::runtime_error("Could not write " + path.string());
+    }
+}
+
+bool is_sorted_file(const std::filesystem::path & path)
+{
+    const int BLOCK_SIZE = 1 << 20;
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        throw std::runtime_error("Could not open " + path.string());
+    }
+    ManagedDynamicArray<int> block(BLOCK_SIZE);
+    bool has_previous = false;
+    int previous = 0;
+    while (in)
+    {
+        in.read(reinterpret_cast<char *>(block.to_span().data()), BLOCK_SIZE * sizeof(int));
+        int num_values = in.gcount() / sizeof(int);
+        if (num_values == 0)
+        {
+            break;
+        }
+        if ((has_previous && block[0] < previous) || !is_sorted(block.to_span(), num_values))
+        {
+            return false;
+        }
+        previous = block[num_values - 1];
+        has_previous = true;
+    }
+    return true;
+}
+
+int external_sort_file(const std::filesystem::path & input, const std::filesystem::path & output,
+    std::size_t memory_budget, const std::filesystem::path & temp_dir)
+{
+    // Pdq sorts each chunk in place, so the chunks really do stay within the budget.
+    PdqSorter<int> chunk_sorter;
+    ExternalSorter<int> sorter(chunk_sorter, memory_budget, temp_dir);
+    Stopwatch stopwatch;
+    sorter.sort(input, output);
+    return stopwatch.elapsed_milliseconds();
+}
+
+int buffered_sort_file(const std::filesystem::path & path, const Sorter<int> & sorter)
+{
+    Stopwatch stopwatch;
+    int count = std::filesystem::file_size(path) / sizeof(int);
+    ManagedDynamicArray<int> values(count);
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.read(reinterpret_cast<char *>(values.to_span().data()), count * sizeof(int));
+    sorter.sort(values.to_span());
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(values.data()), count * sizeof(int));
+    file.flush();
+    if (!file)
+    {
+        throw std::runtime_error("Could not sort " + path.string());
+    }
+    return stopwatch.elapsed_milliseconds();
+}
+
+int mapped_sort_file(const std::filesystem::path & path, const Sorter<int> & sorter)
+{
+    Stopwatch stopwatch;
+    sort_mapped_file(path, sorter);
+    return stopwatch.elapsed_milliseconds();
+}
+
+void check_external_sort()
+{
+    // Small enough to run every time, yet the budget still forces an intermediate merge pass.
+    const std::uintmax_t FILE_CAPACITY = 4 << 20;
+    const std::size_t MEMORY_BUDGET = 4 << 20;
+    std::filesystem::path temp_dir = std::filesystem::temp_directory_path();
+    std::filesystem::path input = temp_dir / "cppsort-external-input.bin";
+    std::filesystem::path output = temp_dir / "cppsort-external-output.bin";
+    generate_file(input, FILE_CAPACITY);
+    int elapsed = external_sort_file(input, output, MEMORY_BUDGET, temp_dir);
+    bool srted = std::filesystem::file_size(output) == FILE_CAPACITY * sizeof(int) && is_sorted_file(output);
+    std::cout << "External Sort of " << FILE_CAPACITY << " ints with a " << (MEMORY_BUDGET >> 20)
+        << " MiB budget finished " << (srted ? "successfully" : "unsuccessfully") << " in " << elapsed
+        << " milliseconds" << std::endl;
+    std::filesystem::remove(input);
+
+    // Records in descending key order, a type and comparator the library never names.
+    const int RECORD_CAPACITY = 50000;
+    using ByKey = ProjectedCompare<decltype(&Record::key), std::greater<>>;
+    auto records = get_random_values<Record>(RECORD_CAPACITY);
+    {
+        FilePtr file = open_file(input, "wb");
+        write_elements<Record>(file.get(), records.to_span(), input);
+    }
+    PdqSorter<Record, ByKey> record_sorter(ByKey{&Record::key});
+    ExternalSorter<Record, ByKey>(record_sorter, MEMORY_BUDGET, temp_dir, ByKey{&Record::key}).sort(input, output);
+    ManagedDynamicArray<Record> sorted_records(RECORD_CAPACITY);
+    {
+        FilePtr file = open_file(output, "rb");
+        srted = read_elements(file.get(), sorted_records.to_span(), output) == RECORD_CAPACITY
+            && std::is_sorted(sorted_records.to_span().begin(), sorted_records.to_span().end(),
+                [](const Record & x, const Record & y) { return x.key > y.key; });
+    }
+    std::cout << "External Sort of " << RECORD_CAPACITY << " records by a projected key is correct: "
+        << (srted ? "true" : "false") << std::endl;
+    std::filesystem::remove(input);
+    std::filesystem::remove(output);
+}
+
+void benchmark_mapped_sort(const Sorter<int> & sorter)
+{
+    const std::uintmax_t FILE_CAPACITY = 16 << 20;
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "cppsort-mapped.bin";
+    generate_file(path, FILE_CAPACITY);
+    int buffered_elapsed = buffered_sort_file(path, sorter);
+    bool buffered_srted = is_sorted_file(path);
+    generate_file(path, FILE_CAPACITY);
+    int mapped_elapsed = mapped_sort_file(path, sorter);
+    bool mapped_srted = is_sorted_file(path);
+    std::cout << sorter.name() << " Sort of a file of " << FILE_CAPACITY << " ints finished "
+        << (buffered_srted && mapped_srted ? "successfully" : "unsuccessfully") << " in " << buffered_elapsed
+        << " milliseconds reading it into memory and " << mapped_elapsed << " milliseconds through a mapping" << std::endl;
+    std::filesystem::remove(path);
+}
+
+void check_mapped_limit()
+{
+    // A sparse file one byte past the limit, so nothing is written or read.
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "cppsort-mapped-limit.bin";
+    open_file(path, "wb").reset();
+    std::filesystem::resize_file(path, static_cast<std::uintmax_t>(INT_MAX) + 1);
+    InsertionSorter<char> sorter;
+    bool rejected = false;
+    try
+    {
+        sort_mapped_file<char>(path, sorter);
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected = true;
+    }
+    std::cout << "Mapped Sort of a file of more than INT_MAX elements is rejected: "
+        << (rejected ? "true" : "false") << std::endl;
+    std::filesystem::remove(path);
+}
+
+void check_profile_files()
+{
+    // The profile is renamed into place, so only the profile itself should be left beside it.
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "cppsort-profile-check";
+    std::filesystem::create_directories(dir);
+    TuningProfile profile{"int", {{32, "insertion", 0}, {INT_MAX, "pdq", 0}}};
+    save_profile(profile, dir / "int.profile");
+    save_profile(profile, dir / "int.profile");
+    std::stringstream saved, loaded;
+    write_profile(saved, profile);
+    write_profile(loaded, load_profile(dir / "int.profile"));
+    auto num_files = std::distance(std::filesystem::directory_iterator(dir), std::filesystem::directory_iterator());
+    bool round_trip = saved.str() == loaded.str() && num_files == 1;
+    std::filesystem::remove_all(dir);
+
+    CalibrationOptions options;
+    options.sizes = {16, 128, 16};
+    bool rejected = false;
+    try
+    {
+        calibrate<int>(options);
+    }
+    catch (const std::runtime_error &)
+    {
+        rejected = true;
+    }
+    std::cout << "Saved profile reads back with no temporary file left: " << (round_trip ? "true" : "false")
+        << ", calibration with a repeated size is rejected: " << (rejected ? "true" : "false") << std::endl;
+}
+
+int run_command(int argc, char * argv[])
+{
+    std::string command = argv[1];
+    if (command == "bench")
+    {
+        BenchmarkOptions options = parse_benchmark_options(std::span<char * const>(argv + 2, argc - 2));
+        if (options.help)
+        {
+            std::cout << "Usage: " << argv[0] << " bench [options]" << std::endl << std::endl
+                << "Options for bench:" << std::endl << benchmark_usage();
+            return 0;
+        }
+        if (options.counters && !PerfCounters().available())
+        {
+            std::cerr << "Hardware counters are not available here, so only timings are reported" << std::endl;
+        }
+        std::vector<BenchmarkResult> results = run_benchmarks(options);
+        if (options.output.empty())
+        {
+            write_report(std::cout, results, options.format);
+            return 0;
+        }
+        std::ofstream out(options.output);
+        write_report(out, results, options.format);
+        if (!out)
+        {
+            throw std::runtime_error("Could not write " + options.output);
+        }
+        return 0;
+    }
+    if (command == "generate" && argc >= 4 && argc <= 6)
+    {
+        DistributionSpec spec;
+        spec.distribution = argc >= 5 ? parse_distribution(argv[4]) : Distribution::UNIFORM;
+        spec.seed = argc == 6 ? std::stoull(argv[5]) : RANDOM_SEED;
+        generate_file(argv[2], std::stoull(argv[3]), spec);
+        return 0;
+    }
+    if (command == "external-sort" && argc >= 4 && argc <= 6)
+    {
+        std::size_t memory_budget = argc >= 5 ? std::stoull(argv[4]) << 20 : ExternalSorter<int>::DEFAULT_MEMORY_BUDGET;
+        std::filesystem::path temp_dir = argc == 6 ? argv[5] : std::filesystem::temp_directory_path();
+        int elapsed = external_sort_file(argv[2], argv[3], memory_budget, temp_dir);
+        std::cout << "External Sort of " << argv[2] << " finished in " << elapsed << " milliseconds" << std::endl;
+        return 0;
+    }
+    if (command == "sort-mapped" && argc == 3)
+    {
+        PdqSorter<int> sorter;
+        int elapsed = mapped_sort_file(argv[2], sorter);
+        std::cout << "Mapped Sort of " << argv[2] << " finished in " << elapsed << " milliseconds" << std::endl;
+        return 0;
+    }
+    if (command == "tune" && argc >= 3 && argc <= 4)
+    {
+        std::string type = argc == 4 ? argv[3] : "int";
+        TuningProfile profile;
+        if (type == "int")
+        {
+            profile = calibrate<int>();
+        }
+        else if (type == "int64")
+        {
+            profile = calibrate<std::int64_t>();
+        }
+        else if (type == "double")
+        {
+            profile = calibrate<double>();
+        }
+        else if (type == "string")
+        {
+            profile = calibrate<std::string>();
+        }
+        else
+        {
+            throw std::runtime_error("Cannot tune for type " + type);
+        }
+        save_profile(profile, argv[2]);
+        write_profile(std::cout, profile);
+        return 0;
+    }
+    if (command == "verify" && argc == 3)
+    {
+        bool srted = is_sorted_file(argv[2]);
+        std::cout << argv[2] << " is " << (srted ? "sorted" : "not sorted") << std::endl;
+        return srted ? 0 : 1;
+    }
+    std::cerr << "Usage: " << argv[0] << std::endl
+        << "       " << argv[0] << " bench [options]" << std::endl
+        << "       " << argv[0] << " generate <file> <number of ints> [distribution] [seed]" << std::endl
+        << "       " << argv[0] << " external-sort <input> <output> [memory budget in MiB] [temp directory]" << std::endl
+        << "       " << argv[0] << " sort-mapped <file>" << std::endl
+        << "       " << argv[0] << " tune <profile> [int|int64|double|string]" << std::endl
+        << "       " << argv[0] << " verify <file>" << std::endl
+        << std::endl << "Options for bench:" << std::endl << benchmark_usage();
+    return 2;
 }
 
 int main(int argc, char * argv[])
 {
+    if (argc > 1)
+    {
+        try
+        {
+            return run_command(argc, argv);
+        }
+        catch (const std::exception & e)
+        {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+
     const int PREDEF_CAPACITY = 200;
     const int RAND_CAPACITY = 20000;
     const int MAX_EXCLUSIVE = 100000;
@@ -66,10 +933,24 @@ int main(int argc, char * argv[])
     auto insertion_sorter = InsertionSorter<int>();
     auto selection_sorter = SelectionSorter<int>();
     auto heap_sorter = HeapSorter<int>();
-    auto merge_sorter = MergeSorter<int>(insertion_sorter);
+    auto network_sorter = NetworkSorter<int>();
+    auto merge_sorter = MergeSorter<int>(network_sorter, NetworkSorter<int>::BLOCK_SIZE);
     auto quick_sorter = QuickSorter<int>();
+    auto parallel_merge_sorter = ParallelMergeSorter<int>(merge_sorter);
+    auto pdq_sorter = PdqSorter<int>();
+    auto block_quick_sorter = QuickSorter<int>(PartitionScheme::BLOCK);
+    auto radix_sorter = RadixSorter<int>();
+    auto parallel_radix_sorter = ParallelRadixSorter<int>();
+    auto power_sorter = PowerSorter<int>();
+
+    // A profile that reaches a different tuned sorter at each size checked below, read back from its text form.
+    TuningProfile profile{"int", {{32, "insertion", 0}, {1024, "merge", 16}, {INT_MAX, "block-quick", 32}}};
+    std::stringstream profile_text;
+    write_profile(profile_text, profile);
+    auto auto_sorter = AutoSorter<int>(read_profile(profile_text));
+    auto probing_sorter = ProbingSorter<int>();
 
-    const int num_sorters = 7;
+    const int num_sorters = 16;
     Sorter<int> * sorters[num_sorters];
     sorters[0] = &bubble_sorter;
     sorters[1] = &cocktail_sorter;
@@ -79,6 +960,15 @@ int main(int argc, char * argv[])
     sorters[4] = &heap_sorter;
     sorters[5] = &merge_sorter;
     sorters[6] = &quick_sorter;
+    sorters[7] = &parallel_merge_sorter;
+    sorters[8] = &pdq_sorter;
+    sorters[9] = &block_quick_sorter;
+    sorters[10] = &radix_sorter;
+    sorters[11] = &parallel_radix_sorter;
+    sorters[12] = &network_sorter;
+    sorters[13] = &power_sorter;
+    sorters[14] = &auto_sorter;
+    sorters[15] = &probing_sorter;
     for (int i = 0; i < num_sorters; ++i)
     {
         Sorter<int> * sorter = sorters[i];
@@ -101,4 +991,101 @@ int main(int argc, char * argv[])
         std::cout << sorter->name() << " Sort of random array finished "
              << (srted ? "successfully" : "unsuccessfully") << " in " << elapsed << " milliseconds" << std::endl;
     }
-}
\ No newline at end of file
+
+    // Every sorter takes its order as a template parameter, so check the descending instantiations too.
+    using Descending = std::greater<int>;
+    auto desc_bubble_sorter = BubbleSorter<int, Descending>();
+    auto desc_cocktail_sorter = CocktailShakerSorter<int, Descending>();
+    auto desc_insertion_sorter = InsertionSorter<int, Descending>();
+    auto desc_selection_sorter = SelectionSorter<int, Descending>();
+    auto desc_heap_sorter = HeapSorter<int, Descending>();
+    auto desc_network_sorter = NetworkSorter<int, Descending>();
+    auto desc_merge_sorter = MergeSorter<int, Descending>(desc_network_sorter, NetworkSorter<int>::BLOCK_SIZE);
+    auto desc_quick_sorter = QuickSorter<int, Descending>();
+    auto desc_parallel_merge_sorter = ParallelMergeSorter<int, Descending>(desc_merge_sorter);
+    auto desc_pdq_sorter = PdqSorter<int, Descending>();
+    auto desc_block_quick_sorter = QuickSorter<int, Descending>(PartitionScheme::BLOCK);
+    auto desc_radix_sorter = RadixSorter<int, Descending>();
+    auto desc_parallel_radix_sorter = ParallelRadixSorter<int, Descending>();
+    auto desc_power_sorter = PowerSorter<int, Descending>();
+    auto desc_probing_sorter = ProbingSorter<int, Descending>();
+    Sorter<int> * desc_sorters[] = {
+        &desc_bubble_sorter, &desc_cocktail_sorter, &desc_insertion_sorter, &desc_selection_sorter,
+        &desc_heap_sorter, &desc_merge_sorter, &desc_quick_sorter, &desc_parallel_merge_sorter,
+        &desc_pdq_sorter, &desc_block_quick_sorter, &desc_radix_sorter, &desc_parallel_radix_sorter,
+        &desc_network_sorter, &desc_power_sorter, &desc_probing_sorter
+    };
+    ManagedDynamicArray<int> reversed(PREDEF_CAPACITY);
+    std::reverse_copy(sorted, sorted + PREDEF_CAPACITY, reversed.to_span().begin());
+    for (Sorter<int> * sorter : desc_sorters)
+    {
+        to_sort.copy_from(unsorted, PREDEF_CAPACITY);
+        std::span<int> span_to_sort(to_sort.to_span(PREDEF_CAPACITY));
+        sorter->sort(span_to_sort);
+        bool identical = are_identical(span_to_sort, reversed.to_span(), PREDEF_CAPACITY);
+        std::cout << sorter->name() << " Descending sort of predefined array is correct: "
+            << (identical ? "true" : "false") << std::endl;
+
+        to_sort.copy_from(randoms);
+        span_to_sort = to_sort.to_span();
+        sorter->sort(span_to_sort);
+        bool srted = is_sorted(span_to_sort, RAND_CAPACITY, Descending());
+        std::cout << sorter->name() << " Descending sort of random array is correct: "
+            << (srted ? "true" : "false") << std::endl;
+    }
+
+    const Sorter<int> * presorted_sorters[] = {&merge_sorter, &pdq_sorter, &power_sorter, &probing_sorter};
+    benchmark_presorted(presorted_sorters);
+    log_probe_decisions(probing_sorter);
+    check_small_probing(probing_sorter, randoms.to_span());
+    check_custom_compares(randoms.to_span());
+    check_streams();
+    check_move_only(randoms.to_span());
+
+    const int PQ_CAPACITY = 1000000;
+    auto pq_values = get_randoms(PQ_CAPACITY, MAX_EXCLUSIVE);
+    std::span<const int> pq_span = pq_values.to_span();
+    std::cout << "Heap stored and took " << PQ_CAPACITY << " values in "
+        << benchmark_heap(pq_span) << " milliseconds" << std::endl;
+    std::cout << "2-ary DAryHeap stored and took " << PQ_CAPACITY << " values in "
+        << benchmark_dary_heap<2>(pq_span) << " milliseconds" << std::endl;
+    std::cout << "4-ary DAryHeap stored and took " << PQ_CAPACITY << " values in "
+        << benchmark_dary_heap<4>(pq_span) << " milliseconds" << std::endl;
+    std::cout << "8-ary DAryHeap stored and took " << PQ_CAPACITY << " values in "
+        << benchmark_dary_heap<8>(pq_span) << " milliseconds" << std::endl;
+    std::cout << "4-ary DAryHeap replaced the top " << PQ_CAPACITY - PQ_CAPACITY / 2 << " times in "
+        << benchmark_dary_heap_replace_top<4>(pq_span) << " milliseconds" << std::endl;
+    benchmark_selection();
+    benchmark_kway_merge();
+
+    // Real payloads are rarely ints, so time the sorters on types that are costlier to compare and move.
+    const int TYPE_CAPACITY = 200000;
+    auto int64_values = get_random_values<std::int64_t>(TYPE_CAPACITY);
+    benchmark_sorters("int64_t", int64_values);
+    auto double_values = get_random_values<double>(TYPE_CAPACITY);
+    benchmark_sorters("double", double_values);
+    auto string_values = get_random_values<std::string>(TYPE_CAPACITY);
+    benchmark_sorters("std::string", string_values);
+    auto record_values = get_random_values<Record>(TYPE_CAPACITY);
+    benchmark_sorters("128-byte Record", record_values);
+
+    auto record_pdq_sorter = PdqSorter<Record>();
+    auto key_pdq_sorter = PdqSorter<KeyIndex<std::int64_t>>();
+    benchmark_argsort(record_values, record_pdq_sorter, key_pdq_sorter);
+    auto record_network_sorter = NetworkSorter<Record>();
+    auto record_merge_sorter = MergeSorter<Record>(record_network_sorter, NetworkSorter<Record>::BLOCK_SIZE);
+    auto key_network_sorter = NetworkSorter<KeyIndex<std::int64_t>>();
+    auto key_merge_sorter = MergeSorter<KeyIndex<std::int64_t>>(key_network_sorter, NetworkSorter<int>::BLOCK_SIZE);
+    benchmark_argsort(record_values, record_merge_sorter, key_merge_sorter);
+
+    const int COLUMN_CAPACITY = 1000000;
+    auto column_keys = get_random_values<std::int64_t>(COLUMN_CAPACITY);
+    benchmark_sort_by_key(column_keys.to_span());
+
+    check_external_sort();
+    benchmark_mapped_sort(pdq_sorter);
+    benchmark_mapped_sort(merge_sorter);
+    benchmark_mapped_sort(radix_sorter);
+    check_mapped_limit();
+    check_profile_files();
+}
@@ -1,12 +1,18 @@
+#include <algorithm>
+#include <concepts>
 #include <memory>
 #include <span>
+#include <stdexcept>
+#include <string>
+#include "instrumentation.h"
 #pragma once
 
 template <typename T>
 /**
  * @brief A managed dynamic array that handles memory allocation and provides utility functions.
  * 
- * @tparam T The type of elements stored in the array.
+ * @tparam T The type of elements stored in the array. Any default-constructible, movable
+ * type works; the members that copy elements also need T to be copyable.
  */
 class ManagedDynamicArray
 {
@@ -40,7 +46,8 @@ public:
      * @param end_idx Ending index of the slice (exclusive).
      * @return ManagedDynamicArray<T> containing the sliced elements.
      */
-    static ManagedDynamicArray<T> as_slice_from(std::span<T> &src, int start_idx, int end_idx);
+    static ManagedDynamicArray<T> as_slice_from(std::span<T> &src, int start_idx, int end_idx)
+        requires std::copyable<T>;
 
     /**
      * @brief Returns a pointer to the underlying array data.
@@ -77,14 +84,14 @@ public:
      * @brief Copies data from another ManagedDynamicArray.
      * @param src Source ManagedDynamicArray to copy from.
      */
-    void copy_from(ManagedDynamicArray<T> & src);
+    void copy_from(ManagedDynamicArray<T> & src) requires std::copyable<T>;
 
     /**
      * @brief Copies data from a raw pointer.
      * @param src Pointer to the source data.
      * @param num_elements Number of elements to copy.
      */
-    void copy_from(const T * src, int num_elements);
+    void copy_from(const T * src, int num_elements) requires std::copyable<T>;
 
     /**
      * @brief Accesses the element at the specified index.
@@ -100,3 +107,81 @@ public:
      */
     const T & operator[](size_t idx) const;
 };
+
+template <typename T>
+ManagedDynamicArray<T>::ManagedDynamicArray(int size)
+    : num_bytes_(sizeof(T) * size), size_(size)
+{
+    // Callers always write before reading, so skip value-initializing the elements.
+    data_ = std::make_unique_for_overwrite<T[]>(size);
+    Instrumentation::count_allocation(num_bytes_);
+}
+
+template <typename T>
+ManagedDynamicArray<T> ManagedDynamicArray<T>::as_slice_from(std::span<T> & src, int start_idx, int end_idx)
+    requires std::copyable<T>
+{
+    ManagedDynamicArray<T> obj(end_idx - start_idx + 1);
+    obj.copy_from(src.data() + start_idx, obj.size());
+    return obj;
+}
+
+template <typename T>
+const T * ManagedDynamicArray<T>::data() const
+{
+    return data_.get();
+}
+
+template <typename T>
+size_t ManagedDynamicArray<T>::num_bytes() const
+{
+    return num_bytes_;
+}
+
+template <typename T>
+int ManagedDynamicArray<T>::size() const
+{
+    return size_;
+}
+
+template <typename T>
+void ManagedDynamicArray<T>::copy_from(ManagedDynamicArray<T> & src) requires std::copyable<T>
+{
+    copy_from(src.data(), src.size());
+}
+
+template <typename T>
+void ManagedDynamicArray<T>::copy_from(const T * src, int num_elements) requires std::copyable<T>
+{
+    if (num_elements > size_)
+    {
+        throw std::runtime_error("Number of elements from source exceeds ManagedDynamicArray size of " + std::to_string(size_));
+    }
+
+    // std::copy becomes a memmove for trivially copyable types and calls the assignment operator otherwise.
+    std::copy(src, src + num_elements, data_.get());
+}
+
+template <typename T>
+std::span<T> ManagedDynamicArray<T>::to_span() const
+{
+    return std::span<T>(data_.get(), size_);
+}
+
+template <typename T>
+std::span<T> ManagedDynamicArray<T>::to_span(int size) const
+{
+    return std::span<T>(data_.get(), size);
+}
+
+template <typename T>
+T & ManagedDynamicArray<T>::operator[](size_t idx)
+{
+    return data_[idx];
+}
+
+template <typename T>
+const T & ManagedDynamicArray<T>::operator[](size_t idx) const
+{
+    return data_[idx];
+}
@@ -0,0 +1,110 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "mapped_file.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CPPSORT_HAVE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef CPPSORT_HAVE_MMAP
+
+/**
+ * @brief Builds an error naming a file and the reason the last system call on it failed.
+ *
+ * @param action What was being done, such as "map".
+ * @param path The file involved.
+ * @return The error to throw.
+ */
+static std::runtime_error file_error(const char * action, const std::filesystem::path & path)
+{
+    return std::runtime_error(std::string("Could not ") + action + " " + path.string() + ": " + std::strerror(errno));
+}
+
+MappedFile::MappedFile(const std::filesystem::path & path) : path_(path), fd_(-1), data_(nullptr), size_(0)
+{
+    fd_ = ::open(path.c_str(), O_RDWR);
+    if (fd_ < 0)
+    {
+        throw file_error("open", path);
+    }
+    struct stat status;
+    if (::fstat(fd_, &status) != 0)
+    {
+        std::runtime_error error = file_error("stat", path);
+        ::close(fd_);
+        throw error;
+    }
+    size_ = status.st_size;
+    // mmap rejects a length of zero, and there is nothing to map anyway.
+    if (size_ > 0)
+    {
+        void * data = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        if (data == MAP_FAILED)
+        {
+            std::runtime_error error = file_error("map", path);
+            ::close(fd_);
+            throw error;
+        }
+        data_ = data;
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (data_ != nullptr)
+    {
+        ::munmap(data_, size_);
+    }
+    ::close(fd_);
+}
+
+void MappedFile::advise(AccessPattern pattern) const
+{
+    if (data_ == nullptr)
+    {
+        return;
+    }
+    int advice = MADV_NORMAL;
+    if (pattern == AccessPattern::SEQUENTIAL)
+    {
+        advice = MADV_SEQUENTIAL;
+    }
+    else if (pattern == AccessPattern::RANDOM)
+    {
+        advice = MADV_RANDOM;
+    }
+    ::madvise(data_, size_, advice);
+#ifdef MADV_HUGEPAGE
+    ::madvise(data_, size_, MADV_HUGEPAGE);
+#endif
+    ::madvise(data_, size_, MADV_WILLNEED);
+}
+
+void MappedFile::sync() const
+{
+    if (data_ != nullptr && ::msync(data_, size_, MS_SYNC) != 0)
+    {
+        throw file_error("sync", path_);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path & path) : path_(path), fd_(-1), data_(nullptr), size_(0)
+{
+    throw std::runtime_error("Could not map " + path.string() + ": memory mapping needs a POSIX system");
+}
+
+MappedFile::~MappedFile() {}
+
+void MappedFile::advise(AccessPattern pattern) const {}
+
+void MappedFile::sync() const {}
+
+#endif
@@ -0,0 +1,137 @@
+#include <climits>
+#include <cstddef>
+#include <filesystem>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include "common.h"
+#pragma once
+
+/**
+ * @class MappedFile
+ * @brief Maps a whole file into memory for reading and writing, and unmaps it when destroyed.
+ *
+ * Writes through the mapping go straight to the page cache, so a file can be sorted
+ * in place without reading it into a buffer and writing it back. Mapping needs a
+ * POSIX system; elsewhere the constructor throws.
+ *
+ * @section Example
+ * @code
+ * MappedFile file("values.bin");
+ * file.advise(AccessPattern::SEQUENTIAL);
+ * std::span<int> values = file.as_span<int>();
+ * values[0] = 42;
+ * file.sync();
+ * @endcode
+ */
+class MappedFile
+{
+    /// The name of the file, for error messages.
+    std::filesystem::path path_;
+
+    /// The descriptor of the open file, or -1 once closed.
+    int fd_;
+
+    /// The first byte of the mapping, or nullptr for an empty file.
+    void * data_;
+
+    /// Number of bytes in the file and the mapping.
+    std::size_t size_;
+
+public:
+    /**
+     * @brief Opens a file and maps all of it for reading and writing.
+     *
+     * @param path The file to map.
+     * @throws std::runtime_error If the file cannot be opened or mapped, or if the
+     * system does not support memory mapping.
+     */
+    MappedFile(const std::filesystem::path & path);
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+
+    /**
+     * @brief Unmaps and closes the file. Changes not yet synced are still written back by the kernel.
+     */
+    ~MappedFile();
+
+    /**
+     * @brief Returns the number of bytes in the file.
+     *
+     * @return The size of the mapping.
+     */
+    std::size_t size() const
+    {
+        return size_;
+    }
+
+    /**
+     * @brief Views the mapping as an array of elements.
+     *
+     * @tparam T The trivially copyable type of the elements stored in the file.
+     * @return A span over every element in the file.
+     * @throws std::runtime_error If the size of the file is not a multiple of sizeof(T).
+     */
+    template <typename T>
+    std::span<T> as_span() const
+    {
+        if (size_ % sizeof(T) != 0)
+        {
+            throw std::runtime_error("A mapping of " + std::to_string(size_) + " bytes does not hold a whole number of "
+                + std::to_string(sizeof(T)) + "-byte elements");
+        }
+        return std::span<T>(static_cast<T *>(data_), size_ / sizeof(T));
+    }
+
+    /**
+     * @brief Tells the kernel how the mapping is about to be used.
+     *
+     * Starts reading the whole file in, since a sort touches every element, and sets
+     * the readahead policy to match @p pattern. Huge pages are requested too, which
+     * the kernel only honours for file mappings on some file systems. These are only
+     * hints, so failures are ignored.
+     *
+     * @param pattern The order in which the elements are about to be touched.
+     */
+    void advise(AccessPattern pattern) const;
+
+    /**
+     * @brief Writes every change made through the mapping back to the file and waits for it.
+     *
+     * @throws std::runtime_error If the changes could not be written.
+     */
+    void sync() const;
+};
+
+template <typename T>
+/**
+ * @brief Sorts a binary file in place through a memory mapping.
+ *
+ * The file is mapped, advised with the sorter's access pattern, handed to the sorter
+ * as a span and synced. Nothing is copied into or out of a separate buffer, although
+ * the sorter may still allocate scratch space of its own. The sorters index with
+ * int, so the file may hold at most INT_MAX elements.
+ *
+ * @tparam T The trivially copyable type of the elements, stored in the file in native byte order.
+ * @param path The file to sort.
+ * @param sorter The sorter to sort the mapped elements with.
+ * @throws std::runtime_error If the file cannot be mapped or synced, its size is not
+ * a multiple of sizeof(T), or it holds more than INT_MAX elements.
+ */
+void sort_mapped_file(const std::filesystem::path & path, const Sorter<T> & sorter);
+
+template <typename T>
+void sort_mapped_file(const std::filesystem::path & path, const Sorter<T> & sorter)
+{
+    MappedFile file(path);
+    std::span<T> elements = file.as_span<T>();
+    if (elements.size() > static_cast<std::size_t>(INT_MAX))
+    {
+        throw std::runtime_error(path.string() + " holds " + std::to_string(elements.size())
+            + " elements, more than the " + std::to_string(INT_MAX) + " a sorter can index");
+    }
+    file.advise(sorter.access_pattern());
+    sorter.sort(elements);
+    file.sync();
+}
@@ -1,26 +1,59 @@
+#include <algorithm>
+#include <functional>
 #include <span>
+#include <stdexcept>
+#include <string>
 #include "common.h"
+#include "merge_kernels.h"
+#include "managed_dynamic_array.h"
 #pragma once
 
-template <typename T>
+template <typename T, typename Compare = std::less<T>>
 /**
  * @class MergeSorter
  * @brief Implements the merge sort algorithm using a helper sorter for small subarrays.
  * 
  * @tparam T The type of elements to sort.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
  *
  * The MergeSorter class inherits from the Sorter base class and provides an implementation
  * of the merge sort algorithm. For small subarrays, it delegates the sorting to another
  * sorter (small_sorter), which can be optimized for small data sets (e.g., insertion sort).
  *
- * @note The small_sorter reference must remain valid for the lifetime of the MergeSorter instance.
+ * @note The small_sorter reference must remain valid for the lifetime of the MergeSorter instance,
+ * and it must sort in the same order as Compare.
  */
 class MergeSorter : public Sorter<T>
 {
     /// Reference to a sorter used for handling small subarrays during the merge sort process.
     std::reference_wrapper<const Sorter<T>> small_sorter_;
 
+    /// Ranges with at most this many elements are handed to small_sorter_.
+    int small_size_;
+
+    /// The fastest merge kernel for T and Compare on the running processor.
+    MergeKernel<T, InstrumentedCompare<Compare>> merge_kernel_;
+
+    /// Orders the elements.
+    [[no_unique_address]] InstrumentedCompare<Compare> compare_;
+
+    /**
+     * @brief Sorts the elements of @p src, leaving the result in @p src or @p dst.
+     *
+     * The halves of each range are sorted into the opposite buffer to the one the
+     * range is merged into, so the array and the scratch buffer swap roles at every
+     * level and nothing is allocated or copied beyond the merges themselves.
+     *
+     * @param src The span holding the elements to sort.
+     * @param dst A scratch span of the same size as @p src.
+     * @param into_dst true if the sorted result must end up in @p dst rather than @p src.
+     */
+    void sort_range(std::span<T> src, std::span<T> dst, bool into_dst) const;
+
 public:
+    /// Default number of elements at or below which ranges are handed to the small sorter.
+    static constexpr int DEFAULT_SMALL_SIZE = 9;
+
     /**
      * @brief Constructs a MergeSorter with a specified small sorter.
      * 
@@ -29,16 +62,94 @@ public:
      * within the merge sort algorithm, allowing for hybrid sorting strategies.
      * 
      * @param small_sorter Constant reference to a Sorter object used for sorting small subarrays.
+     * @param small_size Ranges with at most this many elements are handed to @p small_sorter.
+     * @param compare The comparator used to order the elements.
      */
-    MergeSorter(const Sorter<T> & small_sorter) : Sorter<T>("Merge Sort"), small_sorter_(small_sorter) {}
+    MergeSorter(const Sorter<T> & small_sorter, int small_size = DEFAULT_SMALL_SIZE, Compare compare = Compare())
+        : Sorter<T>("Merge Sort"), small_sorter_(small_sorter), small_size_(small_size),
+          merge_kernel_(select_merge_kernel<T, InstrumentedCompare<Compare>>()), compare_(compare) {}
 
     /**
      * @brief Sorts the given array in place.
      *
      * This function overrides the base class sort method and sorts the elements
-     * of the provided std::span<T> in ascending order.
+     * of the provided std::span<T> in the order given by Compare.
+     *
+     * A single scratch buffer the size of the array is allocated for the whole sort.
      *
      * @param ary A std::span<T> representing the array to be sorted.
      */
     void sort(std::span<T> ary) const override;
+
+    /**
+     * @brief Returns the order in which sort() touches the elements of the array.
+     *
+     * @return AccessPattern::SEQUENTIAL, since each merge streams through its runs from front to back.
+     */
+    AccessPattern access_pattern() const override
+    {
+        return AccessPattern::SEQUENTIAL;
+    }
+
+    /**
+     * @brief Sorts the given array in place using caller-provided scratch space.
+     *
+     * Nothing is allocated, which makes this the cheaper choice when many arrays
+     * are sorted one after another with the same buffer.
+     *
+     * @param ary A std::span<T> representing the array to be sorted.
+     * @param scratch A std::span<T> with at least as many elements as @p ary whose contents are overwritten.
+     * @throws std::runtime_error If @p scratch is smaller than @p ary.
+     */
+    void sort(std::span<T> ary, std::span<T> scratch) const;
 };
+
+template <typename T, typename Compare>
+void MergeSorter<T, Compare>::sort_range(std::span<T> src, std::span<T> dst, bool into_dst) const
+{
+    Instrumentation::RecursionScope recursion;
+    int count = src.size();
+    if (count <= small_size_)
+    {
+        static_cast<const Sorter<T>&>(small_sorter_).sort(src);
+        if (into_dst)
+        {
+            std::move(src.begin(), src.end(), dst.begin());
+            Instrumentation::count_moves(count);
+        }
+        return;
+    }
+
+    int mid_idx = count / 2;
+    sort_range(src.first(mid_idx), dst.first(mid_idx), !into_dst);
+    sort_range(src.subspan(mid_idx), dst.subspan(mid_idx), !into_dst);
+
+    // The halves were sorted into whichever buffer this level is not merging into.
+    std::span<T> from = into_dst ? src : dst;
+    std::span<T> to = into_dst ? dst : src;
+    merge_kernel_(from.data(), mid_idx, from.data() + mid_idx, count - mid_idx, to.data(), compare_);
+}
+
+template <typename T, typename Compare>
+void MergeSorter<T, Compare>::sort(std::span<T> ary) const
+{
+    int count = ary.size();
+    if (count <= small_size_)
+    {
+        static_cast<const Sorter<T>&>(small_sorter_).sort(ary);
+        return;
+    }
+
+    ManagedDynamicArray<T> scratch(count);
+    sort_range(ary, scratch.to_span(), false);
+}
+
+template <typename T, typename Compare>
+void MergeSorter<T, Compare>::sort(std::span<T> ary, std::span<T> scratch) const
+{
+    if (scratch.size() < ary.size())
+    {
+        throw std::runtime_error("Scratch space must hold at least " + std::to_string(ary.size()) + " elements");
+    }
+    sort_range(ary, scratch.first(ary.size()), false);
+}
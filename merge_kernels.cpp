@@ -0,0 +1,96 @@
+#include <functional>
+#include "merge_kernels.h"
+#include "cpu_features.h"
+#include "simd_bitonic.h"
+
+#ifdef CPPSORT_HAVE_AVX2_KERNELS
+// Number of 8-lane registers loaded from a run at each step of the AVX2 merge.
+static const int MERGE_REGS = 2;
+static const int MERGE_BLOCK = 8 * MERGE_REGS;
+
+/**
+ * @brief Merges two sorted runs of ints MERGE_BLOCK elements at a time.
+ *
+ * The registers hold the smallest unwritten block of one run next to the largest
+ * values left over from the previous step. A bitonic merge of the two leaves the
+ * smallest MERGE_BLOCK values, which can be written out, in the lower registers.
+ * The next block comes from whichever run has the smaller next element, which
+ * guarantees nothing smaller than the carried-over values is still unread.
+ */
+CPPSORT_TARGET_AVX2 static void avx2_merge(int * x, int x_cnt, int * y, int y_cnt, int * out,
+    std::less<int> compare)
+{
+    if (x_cnt < MERGE_BLOCK || y_cnt < MERGE_BLOCK)
+    {
+        scalar_merge(x, x_cnt, y, y_cnt, out, compare);
+        return;
+    }
+
+    __m256i regs[2 * MERGE_REGS];
+    for (int r = 0; r < MERGE_REGS; ++r)
+    {
+        regs[r] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(x + 8 * r));
+        regs[MERGE_REGS + r] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(y + 8 * r));
+    }
+    int x_idx = MERGE_BLOCK, y_idx = MERGE_BLOCK;
+    while (true)
+    {
+        avx2_merge_registers(regs, 2 * MERGE_REGS);
+        for (int r = 0; r < MERGE_REGS; ++r)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 8 * r), regs[r]);
+        }
+        out += MERGE_BLOCK;
+
+        bool can_take_x = x_idx + MERGE_BLOCK <= x_cnt;
+        bool can_take_y = y_idx + MERGE_BLOCK <= y_cnt;
+        if (!can_take_x || !can_take_y)
+        {
+            break;
+        }
+        int * next;
+        if (x[x_idx] <= y[y_idx])
+        {
+            next = x + x_idx;
+            x_idx += MERGE_BLOCK;
+        }
+        else
+        {
+            next = y + y_idx;
+            y_idx += MERGE_BLOCK;
+        }
+        for (int r = 0; r < MERGE_REGS; ++r)
+        {
+            regs[r] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(next + 8 * r));
+        }
+    }
+
+    /* What remains is the carried-over block plus the tails of both runs, one
+     * of which is shorter than a block. Fold the carried block into the short
+     * tail first so the final merge is an ordinary two-way merge. */
+    alignas(32) int carried[MERGE_BLOCK];
+    for (int r = 0; r < MERGE_REGS; ++r)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i *>(carried + 8 * r), regs[MERGE_REGS + r]);
+    }
+    int combined[2 * MERGE_BLOCK];
+    bool x_is_short = x_cnt - x_idx < MERGE_BLOCK;
+    int * short_tail = x_is_short ? x + x_idx : y + y_idx;
+    int short_cnt = x_is_short ? x_cnt - x_idx : y_cnt - y_idx;
+    int * long_tail = x_is_short ? y + y_idx : x + x_idx;
+    int long_cnt = x_is_short ? y_cnt - y_idx : x_cnt - x_idx;
+    scalar_merge(carried, MERGE_BLOCK, short_tail, short_cnt, combined, compare);
+    scalar_merge(combined, MERGE_BLOCK + short_cnt, long_tail, long_cnt, out, compare);
+}
+#endif
+
+MergeKernel<int> avx2_merge_kernel()
+{
+#ifdef CPPSORT_HAVE_AVX2_KERNELS
+    if (cpu_supports_avx2())
+    {
+        return avx2_merge;
+    }
+#endif
+    return nullptr;
+}
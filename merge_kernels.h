@@ -0,0 +1,89 @@
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include "instrumentation.h"
+#pragma once
+
+/**
+ * @brief A function that merges two sorted runs into an output array.
+ *
+ * @tparam T The type of elements being merged.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
+ *
+ * The runs are read from @p x and @p y and the @p x_cnt + @p y_cnt merged
+ * elements are moved to @p out, which must not overlap either run. Both runs
+ * must already be sorted by @p compare, and are left holding moved-from values.
+ */
+template <typename T, typename Compare = std::less<T>>
+using MergeKernel = void (*)(T * x, int x_cnt, T * y, int y_cnt, T * out, Compare compare);
+
+template <typename T, typename Compare>
+/**
+ * @brief Merges two sorted runs one element at a time without branching on the data.
+ *
+ * The comparison result picks the element to write and advances exactly one of
+ * the two run indexes, so the compiler can use conditional moves in place of a
+ * branch that mispredicts about half the time on random data. Equal elements are
+ * taken from @p x first, so the merge is stable.
+ *
+ * @param x The first sorted run.
+ * @param x_cnt The number of elements in @p x.
+ * @param y The second sorted run.
+ * @param y_cnt The number of elements in @p y.
+ * @param out Receives the merged elements, which are moved rather than copied.
+ * @param compare The order both runs are sorted in.
+ */
+void scalar_merge(T * x, int x_cnt, T * y, int y_cnt, T * out, Compare compare);
+
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @brief Returns the fastest merge kernel the running processor supports for T and Compare.
+ *
+ * For ints in ascending order on processors with AVX2 this is a kernel that merges
+ * 16 elements per step with bitonic merge networks across two pairs of 8-lane
+ * registers. It is not stable, which makes no difference for ints. Everything else
+ * gets scalar_merge().
+ *
+ * @return The selected kernel.
+ */
+MergeKernel<T, Compare> select_merge_kernel();
+
+/**
+ * @brief Returns the AVX2 merge kernel for ints in ascending order.
+ *
+ * It is kept out of the header so the AVX2 code and the processor check are only
+ * compiled once, in merge_kernels.cpp.
+ *
+ * @return The kernel, or nullptr if the build or the running processor lacks AVX2.
+ */
+MergeKernel<int> avx2_merge_kernel();
+
+template <typename T, typename Compare>
+void scalar_merge(T * x, int x_cnt, T * y, int y_cnt, T * out, Compare compare)
+{
+    Instrumentation::count_moves(x_cnt + y_cnt);
+    int x_idx = 0, y_idx = 0;
+    while (x_idx < x_cnt && y_idx < y_cnt)
+    {
+        bool take_y = compare(y[y_idx], x[x_idx]);
+        *out++ = std::move(take_y ? y[y_idx] : x[x_idx]);
+        y_idx += take_y;
+        x_idx += !take_y;
+    }
+    out = std::move(x + x_idx, x + x_cnt, out);
+    std::move(y + y_idx, y + y_cnt, out);
+}
+
+template <typename T, typename Compare>
+MergeKernel<T, Compare> select_merge_kernel()
+{
+    // The registers are merged with min and max, so only ascending order can use them.
+    if constexpr (std::is_same_v<T, int> && std::is_same_v<Compare, std::less<int>>)
+    {
+        if (MergeKernel<int> kernel = avx2_merge_kernel())
+        {
+            return kernel;
+        }
+    }
+    return scalar_merge<T, Compare>;
+}
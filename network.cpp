@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include "network.h"
+#include "cpu_features.h"
+#include "simd_bitonic.h"
+
+#ifdef CPPSORT_HAVE_AVX2_KERNELS
+/**
+ * @brief Sorts a padded block held in NUM_REGS registers' worth of aligned memory.
+ *
+ * @tparam NUM_REGS The number of 8-lane registers the block occupies: 1, 2, 4 or 8.
+ * @param buffer The block, aligned to 32 bytes.
+ */
+template <int NUM_REGS>
+CPPSORT_TARGET_AVX2 static void avx2_sort_registers(int * buffer)
+{
+    __m256i regs[NUM_REGS];
+    for (int r = 0; r < NUM_REGS; ++r)
+    {
+        regs[r] = avx2_sort8(_mm256_load_si256(reinterpret_cast<const __m256i *>(buffer + 8 * r)));
+    }
+    for (int width = 2; width <= NUM_REGS; width *= 2)
+    {
+        for (int r = 0; r < NUM_REGS; r += width)
+        {
+            avx2_merge_registers(regs + r, width);
+        }
+    }
+    for (int r = 0; r < NUM_REGS; ++r)
+    {
+        _mm256_store_si256(reinterpret_cast<__m256i *>(buffer + 8 * r), regs[r]);
+    }
+}
+
+/**
+ * @brief Sorts up to 64 ints in AVX2 registers.
+ *
+ * @param data The elements to sort.
+ * @param count The number of elements, at most 64.
+ */
+CPPSORT_TARGET_AVX2 static void avx2_network_sort(int * data, int count)
+{
+    int padded = std::max(8, static_cast<int>(std::bit_ceil(static_cast<unsigned>(count))));
+    alignas(32) int buffer[NetworkSorter<int>::BLOCK_SIZE];
+    std::copy(data, data + count, buffer);
+    std::fill(buffer + count, buffer + padded, std::numeric_limits<int>::max());
+    switch (padded / 8)
+    {
+    case 1:
+        avx2_sort_registers<1>(buffer);
+        break;
+    case 2:
+        avx2_sort_registers<2>(buffer);
+        break;
+    case 4:
+        avx2_sort_registers<4>(buffer);
+        break;
+    default:
+        avx2_sort_registers<8>(buffer);
+        break;
+    }
+    std::copy(buffer, buffer + count, data);
+}
+#endif
+
+bool avx2_sort_block(int * data, int count)
+{
+#ifdef CPPSORT_HAVE_AVX2_KERNELS
+    if (cpu_supports_avx2())
+    {
+        avx2_network_sort(data, count);
+        return true;
+    }
+#endif
+    return false;
+}
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include "common.h"
+#include "managed_dynamic_array.h"
+#include "merge_kernels.h"
+#pragma once
+
+/**
+ * @brief Sorts up to 64 ints in ascending order in AVX2 registers.
+ *
+ * It is kept out of the header so the AVX2 code and the processor check are only
+ * compiled once, in network.cpp.
+ *
+ * @param data The elements to sort.
+ * @param count The number of elements, at most 64.
+ * @return true if the elements were sorted; false, leaving them untouched, if the build or
+ * the running processor lacks AVX2.
+ */
+bool avx2_sort_block(int * data, int count);
+
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @class NetworkSorter
+ * @brief Sorts small blocks with bitonic sorting networks, using AVX2 registers for ints.
+ *
+ * @tparam T The type of elements to sort.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
+ *
+ * For ints in ascending order on processors with AVX2, a block of up to BLOCK_SIZE
+ * elements is padded with the largest int to 8, 16, 32 or 64 elements and loaded
+ * into 1 to 8 registers. Each register is sorted with an in-register network and
+ * the registers are then merged pairwise with bitonic merge networks, all without
+ * a single branch on the data. Other types, orders and processors run the same
+ * network one compare-exchange at a time, skipping the compare-exchanges that
+ * would only have touched padding, so no sentinel value is needed.
+ *
+ * The sorter is meant to be the small_sorter of a MergeSorter, with a small size of
+ * up to BLOCK_SIZE. Larger arrays are sorted block by block and the blocks are then
+ * merged bottom-up through a scratch buffer, so it can also be used on its own.
+ */
+class NetworkSorter : public Sorter<T>
+{
+    /**
+     * @brief Sorts an array with a bitonic sorting network, one compare-exchange at a time.
+     *
+     * The network is the one for the next power of two, arranged so that every
+     * compare-exchange moves the element that belongs first to the lower index. The
+     * missing elements can then be treated as padding that belongs after everything
+     * else: it never moves, so the compare-exchanges that reach past the end of the
+     * array are skipped instead of being fed a sentinel value.
+     *
+     * @param data The elements to sort.
+     * @param count The number of elements.
+     * @param compare The order to sort the elements in.
+     */
+    static void scalar_bitonic_sort(T * data, int count, const InstrumentedCompare<Compare> & compare);
+
+    /**
+     * @brief Sorts a block of at most BLOCK_SIZE elements in place.
+     *
+     * @param block A std::span<T> representing the block to be sorted.
+     */
+    void sort_block(std::span<T> block) const;
+
+    /// Orders the elements.
+    [[no_unique_address]] InstrumentedCompare<Compare> compare_;
+
+public:
+    /// The largest number of elements sorted by a single network.
+    static constexpr int BLOCK_SIZE = 64;
+
+    /**
+     * @brief Constructs a NetworkSorter object with the name "Sorting Network".
+     *
+     * @param compare The comparator used to order the elements.
+     */
+    NetworkSorter(Compare compare = Compare()) : Sorter<T>("Sorting Network"), compare_(compare) {}
+
+    /**
+     * @brief Sorts the given array in-place.
+     *
+     * This function overrides the base class sort method and sorts the elements
+     * of the provided std::span<T> in the order given by Compare.
+     *
+     * @param ary A std::span<T> representing the array to be sorted.
+     */
+    void sort(std::span<T> ary) const override;
+};
+
+template <typename T, typename Compare>
+void NetworkSorter<T, Compare>::scalar_bitonic_sort(T * data, int count, const InstrumentedCompare<Compare> & compare)
+{
+    auto compare_exchange = [&](int i, int partner)
+    {
+        if (partner < count && compare(data[partner], data[i]))
+        {
+            Instrumentation::count_swap();
+            std::swap(data[i], data[partner]);
+        }
+    };
+    int size = std::bit_ceil(static_cast<unsigned>(count));
+    for (int k = 2; k <= size; k *= 2)
+    {
+        /* Pairing each element with its mirror image in the block of k merges
+         * the two sorted halves without first reversing one of them. */
+        for (int i = 0; i < count; ++i)
+        {
+            int partner = i ^ (k - 1);
+            if (partner > i)
+            {
+                compare_exchange(i, partner);
+            }
+        }
+        for (int j = k / 4; j > 0; j /= 2)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                int partner = i ^ j;
+                if (partner > i)
+                {
+                    compare_exchange(i, partner);
+                }
+            }
+        }
+    }
+}
+
+template <typename T, typename Compare>
+void NetworkSorter<T, Compare>::sort_block(std::span<T> block) const
+{
+    int count = block.size();
+    if (count < 2)
+    {
+        return;
+    }
+
+    // The registers are sorted with min and max, so only ascending order can use them.
+    if constexpr (std::is_same_v<T, int> && std::is_same_v<Compare, std::less<int>>)
+    {
+        if (avx2_sort_block(block.data(), count))
+        {
+            return;
+        }
+    }
+
+    scalar_bitonic_sort(block.data(), count, compare_);
+}
+
+template <typename T, typename Compare>
+void NetworkSorter<T, Compare>::sort(std::span<T> ary) const
+{
+    int count = ary.size();
+    for (int start = 0; start < count; start += BLOCK_SIZE)
+    {
+        sort_block(ary.subspan(start, std::min(BLOCK_SIZE, count - start)));
+    }
+    if (count <= BLOCK_SIZE)
+    {
+        return;
+    }
+
+    // Merge the sorted blocks bottom-up, trading places with the scratch buffer each pass.
+    MergeKernel<T, InstrumentedCompare<Compare>> merge = select_merge_kernel<T, InstrumentedCompare<Compare>>();
+    ManagedDynamicArray<T> scratch(count);
+    std::span<T> src = ary;
+    std::span<T> dst = scratch.to_span();
+    for (int width = BLOCK_SIZE; width < count; width *= 2)
+    {
+        for (int start = 0; start < count; start += 2 * width)
+        {
+            int mid = std::min(start + width, count);
+            int end = std::min(start + 2 * width, count);
+            merge(src.data() + start, mid - start, src.data() + mid, end - mid, dst.data() + start, compare_);
+        }
+        std::swap(src, dst);
+    }
+    if (src.data() != ary.data())
+    {
+        std::move(src.begin(), src.end(), ary.begin());
+        Instrumentation::count_moves(count);
+    }
+}
@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <span>
+#include <thread>
+#include <utility>
+#include "common.h"
+#include "merge_kernels.h"
+#include "thread_pool.h"
+#include "managed_dynamic_array.h"
+#pragma once
+
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @class ParallelMergeSorter
+ * @brief Implements a task-parallel merge sort on top of a work-stealing ThreadPool.
+ *
+ * @tparam T The type of elements to sort.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
+ *
+ * The two halves of every range are sorted as forked tasks and the merges are split
+ * into independent pieces by binary searching for the median of the larger run in
+ * the smaller one, so both phases keep every core busy. Ranges at or below the grain
+ * size are handed to a serial sorter (normally a MergeSorter) and merges at or below
+ * it run as a plain sequential merge. Elements are merged back and forth between the
+ * array and a single scratch buffer allocated once per sort.
+ *
+ * @note The serial_sorter reference must remain valid for the lifetime of the ParallelMergeSorter instance,
+ * and it must sort in the same order as Compare.
+ */
+class ParallelMergeSorter : public Sorter<T>
+{
+    /// Reference to a sorter used for ranges no larger than the grain size.
+    std::reference_wrapper<const Sorter<T>> serial_sorter_;
+
+    /// Ranges and merges with at most this many elements are processed serially.
+    int grain_size_;
+
+    /// The pool the recursive halves and merge pieces are forked onto.
+    std::unique_ptr<ThreadPool> pool_;
+
+    /// The fastest merge kernel for T and Compare on the running processor, used for merges within the grain size.
+    MergeKernel<T, InstrumentedCompare<Compare>> merge_kernel_;
+
+    /// Orders the elements.
+    [[no_unique_address]] InstrumentedCompare<Compare> compare_;
+
+    /**
+     * @brief Sorts the elements of @p src, leaving the result in @p src or @p dst.
+     *
+     * @param src The span holding the elements to sort.
+     * @param dst A scratch span of the same size as @p src.
+     * @param into_dst true if the sorted result must end up in @p dst rather than @p src.
+     */
+    void sort_range(std::span<T> src, std::span<T> dst, bool into_dst) const;
+
+    /**
+     * @brief Merges two sorted runs into @p out, splitting large merges into parallel tasks.
+     *
+     * Equal elements from @p x are placed before those from @p y so the merge is stable.
+     * The elements are moved, leaving both runs holding moved-from values.
+     *
+     * @param x The first sorted run.
+     * @param y The second sorted run.
+     * @param out The destination whose size is the combined size of both runs.
+     */
+    void merge(std::span<T> x, std::span<T> y, std::span<T> out) const;
+
+public:
+    /// Default number of elements below which work is no longer split into tasks.
+    static constexpr int DEFAULT_GRAIN_SIZE = 16384;
+
+    /**
+     * @brief Constructs a ParallelMergeSorter with the name "Parallel Merge Sort".
+     *
+     * @param serial_sorter Constant reference to a Sorter used for ranges no larger than the grain size.
+     * @param num_threads Number of threads to sort with, including the calling thread.
+     * Zero or less uses the number of hardware threads.
+     * @param grain_size Number of elements at or below which ranges and merges are processed serially.
+     * @param compare The comparator used to order the elements.
+     */
+    ParallelMergeSorter(const Sorter<T> & serial_sorter, int num_threads = 0, int grain_size = DEFAULT_GRAIN_SIZE,
+        Compare compare = Compare());
+
+    /**
+     * @brief Returns the number of threads used to sort, including the calling thread.
+     *
+     * @return The number of threads.
+     */
+    int num_threads() const;
+
+    /**
+     * @brief Sorts the given array in place.
+     *
+     * This function overrides the base class sort method and sorts the elements
+     * of the provided std::span<T> in the order given by Compare.
+     *
+     * @param ary A std::span<T> representing the array to be sorted.
+     */
+    void sort(std::span<T> ary) const override;
+
+    /**
+     * @brief Returns the order in which sort() touches the elements of the array.
+     *
+     * @return AccessPattern::SEQUENTIAL, since each merge streams through its runs from front to back.
+     */
+    AccessPattern access_pattern() const override
+    {
+        return AccessPattern::SEQUENTIAL;
+    }
+};
+
+template <typename T, typename Compare>
+ParallelMergeSorter<T, Compare>::ParallelMergeSorter(const Sorter<T> & serial_sorter, int num_threads, int grain_size,
+    Compare compare)
+    : Sorter<T>("Parallel Merge Sort"), serial_sorter_(serial_sorter), grain_size_(std::max(grain_size, 1)),
+      merge_kernel_(select_merge_kernel<T, InstrumentedCompare<Compare>>()), compare_(compare)
+{
+    if (num_threads <= 0)
+    {
+        num_threads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    }
+    // The thread calling sort() helps while it waits, so it counts as one of the threads.
+    pool_ = std::make_unique<ThreadPool>(num_threads - 1);
+}
+
+template <typename T, typename Compare>
+int ParallelMergeSorter<T, Compare>::num_threads() const
+{
+    return pool_->num_threads() + 1;
+}
+
+template <typename T, typename Compare>
+void ParallelMergeSorter<T, Compare>::sort_range(std::span<T> src, std::span<T> dst, bool into_dst) const
+{
+    Instrumentation::RecursionScope recursion;
+    int count = src.size();
+    if (count <= grain_size_)
+    {
+        static_cast<const Sorter<T>&>(serial_sorter_).sort(src);
+        if (into_dst)
+        {
+            std::move(src.begin(), src.end(), dst.begin());
+            Instrumentation::count_moves(count);
+        }
+        return;
+    }
+
+    /* Each half leaves its result in the opposite buffer to the one this
+     * level merges into, so the two buffers trade places at every level. */
+    int mid_idx = count / 2;
+    TaskGroup group(*pool_);
+    group.run([&] { sort_range(src.first(mid_idx), dst.first(mid_idx), !into_dst); });
+    sort_range(src.subspan(mid_idx), dst.subspan(mid_idx), !into_dst);
+    group.wait();
+
+    std::span<T> from = into_dst ? src : dst;
+    std::span<T> to = into_dst ? dst : src;
+    merge(from.first(mid_idx), from.subspan(mid_idx), to);
+}
+
+template <typename T, typename Compare>
+void ParallelMergeSorter<T, Compare>::merge(std::span<T> x, std::span<T> y, std::span<T> out) const
+{
+    Instrumentation::RecursionScope recursion;
+    int x_cnt = x.size();
+    int y_cnt = y.size();
+    if (x_cnt + y_cnt <= grain_size_)
+    {
+        merge_kernel_(x.data(), x_cnt, y.data(), y_cnt, out.data(), compare_);
+        return;
+    }
+
+    /* Split the larger run at its midpoint and find where that value falls in
+     * the smaller run. The midpoint goes straight to its final position and
+     * the pieces on either side of it are merged independently. Ties are sent
+     * the same way a sequential merge would send them. */
+    int x_mid, y_mid;
+    bool split_x = x_cnt >= y_cnt;
+    if (split_x)
+    {
+        x_mid = x_cnt / 2;
+        y_mid = std::lower_bound(y.begin(), y.end(), x[x_mid], compare_) - y.begin();
+    }
+    else
+    {
+        y_mid = y_cnt / 2;
+        x_mid = std::upper_bound(x.begin(), x.end(), y[y_mid], compare_) - x.begin();
+    }
+
+    int out_mid = x_mid + y_mid;
+    out[out_mid] = std::move(split_x ? x[x_mid] : y[y_mid]);
+    Instrumentation::count_moves(1);
+    TaskGroup group(*pool_);
+    group.run([&] { merge(x.first(x_mid), y.first(y_mid), out.first(out_mid)); });
+    merge(x.subspan(x_mid + (split_x ? 1 : 0)), y.subspan(y_mid + (split_x ? 0 : 1)), out.subspan(out_mid + 1));
+    group.wait();
+}
+
+template <typename T, typename Compare>
+void ParallelMergeSorter<T, Compare>::sort(std::span<T> ary) const
+{
+    int count = ary.size();
+    if (count <= grain_size_)
+    {
+        static_cast<const Sorter<T>&>(serial_sorter_).sort(ary);
+        return;
+    }
+
+    ManagedDynamicArray<T> scratch(count);
+    sort_range(ary, scratch.to_span(), false);
+}
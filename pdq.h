@@ -0,0 +1,546 @@
+#include <bit>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "common.h"
+#include "heap.h"
+#pragma once
+
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @class PdqSorter
+ * @brief Implements pattern-defeating quicksort, a hybrid introsort with guaranteed O(n log n) time.
+ *
+ * @tparam T The type of elements to sort.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
+ *
+ * Pivots are the median of three elements, or the median of three medians (ninther)
+ * for larger ranges. Only the smaller side of each partition is recursed into while
+ * the larger side is handled by looping, so the stack depth is O(log n). Small ranges
+ * are finished with insertion sort. Partitions that come out badly unbalanced shuffle
+ * a few elements to break up adversarial patterns, and once too many of them have
+ * happened the range is handed to heap sort. A pivot equal to the element just before
+ * its range sends every equal element to the left and skips them, so inputs with many
+ * duplicates are split three ways and finish in linear time. A partition that needed
+ * no swaps is checked with a bounded insertion sort, so already sorted runs finish
+ * in linear time as well.
+ */
+class PdqSorter : public Sorter<T>
+{
+    /// Ranges smaller than this are finished with insertion sort.
+    static constexpr int INSERTION_SORT_THRESHOLD = 24;
+
+    /// Ranges larger than this use the median of three medians as the pivot.
+    static constexpr int NINTHER_THRESHOLD = 128;
+
+    /// Number of element moves after which a partial insertion sort gives up.
+    static constexpr int PARTIAL_INSERTION_SORT_LIMIT = 8;
+
+    /// Used when too many bad partitions show the input is defeating the pivot selection.
+    HeapSorter<T, Compare> heap_sorter_;
+
+    /// Orders the elements.
+    [[no_unique_address]] InstrumentedCompare<Compare> compare_;
+
+    /**
+     * @brief Sorts the elements between two indexes with insertion sort.
+     *
+     * @param ary A std::span<T> representing the array.
+     * @param begin The first index of the range.
+     * @param end One past the last index of the range.
+     * @param guarded false if the element before @p begin is known not to be ordered after
+     * any element in the range, which lets the inner loop skip its bounds check.
+     */
+    void insertion_sort(std::span<T> ary, int begin, int end, bool guarded) const;
+
+    /**
+     * @brief Attempts to sort the elements between two indexes with insertion sort,
+     * giving up once a fixed number of elements have been moved.
+     *
+     * @param ary A std::span<T> representing the array.
+     * @param begin The first index of the range.
+     * @param end One past the last index of the range.
+     * @return true if the range is now sorted; false if the attempt was abandoned.
+     */
+    bool partial_insertion_sort(std::span<T> ary, int begin, int end) const;
+
+    /**
+     * @brief Orders the values at three indexes so that ary[a], ary[b] and ary[c] are in Compare order.
+     *
+     * @param ary A std::span<T> representing the array.
+     * @param a The index that receives the first value.
+     * @param b The index that receives the median value.
+     * @param c The index that receives the last value.
+     */
+    void sort3(std::span<T> ary, int a, int b, int c) const;
+
+    /**
+     * @brief Partitions a range around the pivot at its first index, sending elements
+     * equal to the pivot to the right.
+     *
+     * @param ary A std::span<T> representing the array.
+     * @param begin The index of the pivot and the first index of the range.
+     * @param end One past the last index of the range.
+     * @return The final index of the pivot and whether the range was already partitioned.
+     */
+    std::pair<int, bool> partition_right(std::span<T> ary, int begin, int end) const;
+
+    /**
+     * @brief Partitions a range around the pivot at its first index, sending elements
+     * equal to the pivot to the left.
+     *
+     * @param ary A std::span<T> representing the array.
+     * @param begin The index of the pivot and the first index of the range.
+     * @param end One past the last index of the range.
+     * @return The final index of the pivot.
+     */
+    int partition_left(std::span<T> ary, int begin, int end) const;
+
+    /**
+     * @brief Sorts the elements between two indexes.
+     *
+     * @param ary A std::span<T> representing the array.
+     * @param begin The first index of the range.
+     * @param end One past the last index of the range.
+     * @param bad_allowed Number of unbalanced partitions tolerated before switching to heap sort.
+     * @param leftmost true if the range starts at the beginning of the array.
+     */
+    void sort_between_indexes(std::span<T> ary, int begin, int end, int bad_allowed, bool leftmost) const;
+
+    /**
+     * @brief Moves a pivot chosen by the median of medians of five to the start of a range.
+     *
+     * The pivot is guaranteed to have at least about 3/10 of the range on either side
+     * of it, which bounds the selection that uses it to linear time. An element not
+     * ordered before the pivot is left at the end of the range, as partition_right() needs.
+     *
+     * @param ary A std::span<T> representing the array.
+     * @param begin The first index of the range, which holds at least INSERTION_SORT_THRESHOLD elements.
+     * @param end One past the last index of the range.
+     */
+    void move_median_of_medians(std::span<T> ary, int begin, int end) const;
+
+    /**
+     * @brief Partitions the elements between two indexes until the one at index k is in its sorted place.
+     *
+     * Pivots are chosen as for sorting until two partitions in a row fail to halve
+     * the range, after which the median of medians is used, so the time is linear
+     * even for inputs that defeat the cheap pivots.
+     *
+     * @param ary A std::span<T> representing the array.
+     * @param begin The first index of the range.
+     * @param end One past the last index of the range.
+     * @param k The index to settle, within the range.
+     * @param leftmost true if no element before the range is known to bound it.
+     */
+    void select_between_indexes(std::span<T> ary, int begin, int end, int k, bool leftmost) const;
+
+public:
+    /**
+     * @brief Constructs a PdqSorter object with the name "Pattern-Defeating Quick".
+     *
+     * @param compare The comparator used to order the elements.
+     */
+    PdqSorter(Compare compare = Compare())
+        : Sorter<T>("Pattern-Defeating Quick"), heap_sorter_(compare), compare_(compare) {}
+
+    /**
+     * @brief Sorts the given array in-place.
+     *
+     * This function overrides the base class sort method and sorts the elements
+     * of the provided std::span<T> in the order given by Compare.
+     *
+     * @param ary A std::span<T> representing the array to be sorted.
+     */
+    void sort(std::span<T> ary) const override;
+
+    /**
+     * @brief Rearranges the array so that the element at index k is the one a sort would put there.
+     *
+     * Every element before index k is then not ordered after it and every element
+     * after it is not ordered before it. This is introselect: quickselect with the
+     * sorter's pivots and partitions, falling back to median of medians pivots, so
+     * it takes O(n) time even in the worst case.
+     *
+     * @param ary A std::span<T> representing the array.
+     * @param k The index to settle.
+     * @throws std::runtime_error If @p k is not an index of @p ary.
+     */
+    void select_nth(std::span<T> ary, int k) const;
+
+    /**
+     * @brief Moves the first k elements in Compare order to the front of the array, in order.
+     *
+     * The k elements are selected with select_nth() and then sorted, which takes
+     * O(n + k log k) time. The order of the rest of the array is unspecified.
+     *
+     * @param ary A std::span<T> representing the array.
+     * @param k The number of elements to sort, from 0 to the size of @p ary.
+     * @throws std::runtime_error If @p k is out of range.
+     */
+    void partial_sort(std::span<T> ary, int k) const;
+};
+
+template <typename T, typename Compare>
+void PdqSorter<T, Compare>::insertion_sort(std::span<T> ary, int begin, int end, bool guarded) const
+{
+    for (int i = begin + 1; i < end; ++i)
+    {
+        if (compare_(ary[i], ary[i - 1]))
+        {
+            T old = std::move(ary[i]);
+            int j = i;
+            do
+            {
+                ary[j] = std::move(ary[j - 1]);
+                --j;
+            } while ((!guarded || j > begin) && compare_(old, ary[j - 1]));
+            ary[j] = std::move(old);
+            Instrumentation::count_moves(i - j + 2);
+        }
+    }
+}
+
+template <typename T, typename Compare>
+bool PdqSorter<T, Compare>::partial_insertion_sort(std::span<T> ary, int begin, int end) const
+{
+    int moved = 0;
+    for (int i = begin + 1; i < end; ++i)
+    {
+        if (compare_(ary[i], ary[i - 1]))
+        {
+            T old = std::move(ary[i]);
+            int j = i;
+            do
+            {
+                ary[j] = std::move(ary[j - 1]);
+                --j;
+            } while (j > begin && compare_(old, ary[j - 1]));
+            ary[j] = std::move(old);
+            Instrumentation::count_moves(i - j + 2);
+            moved += i - j;
+        }
+        if (moved > PARTIAL_INSERTION_SORT_LIMIT)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T, typename Compare>
+void PdqSorter<T, Compare>::sort3(std::span<T> ary, int a, int b, int c) const
+{
+    if (compare_(ary[b], ary[a])) this->swap_values(ary, a, b);
+    if (compare_(ary[c], ary[b])) this->swap_values(ary, b, c);
+    if (compare_(ary[b], ary[a])) this->swap_values(ary, a, b);
+}
+
+template <typename T, typename Compare>
+std::pair<int, bool> PdqSorter<T, Compare>::partition_right(std::span<T> ary, int begin, int end) const
+{
+    // The pivot is moved out and its slot is never compared, so it is not copied.
+    T pivot = std::move(ary[begin]);
+    int first = begin;
+    int last = end;
+
+    /* Pivot selection left an element not ordered before the pivot at the end
+     * of the range, so the first scan needs no bounds check. */
+    while (compare_(ary[++first], pivot));
+    /* If the first scan moved past anything, an element ordered before the
+     * pivot stops the second scan. Otherwise it has to check the bounds. */
+    if (first - 1 == begin)
+    {
+        while (first < last && !compare_(ary[--last], pivot));
+    }
+    else
+    {
+        while (!compare_(ary[--last], pivot));
+    }
+
+    bool already_partitioned = first >= last;
+    while (first < last)
+    {
+        this->swap_values(ary, first, last);
+        while (compare_(ary[++first], pivot));
+        while (!compare_(ary[--last], pivot));
+    }
+
+    int pivot_pos = first - 1;
+    ary[begin] = std::move(ary[pivot_pos]);
+    ary[pivot_pos] = std::move(pivot);
+    Instrumentation::count_moves(3);
+    return std::make_pair(pivot_pos, already_partitioned);
+}
+
+template <typename T, typename Compare>
+int PdqSorter<T, Compare>::partition_left(std::span<T> ary, int begin, int end) const
+{
+    T pivot = std::move(ary[begin]);
+    int first = begin;
+    int last = end;
+
+    while (compare_(pivot, ary[--last]));
+    if (last + 1 == end)
+    {
+        while (first < last && !compare_(pivot, ary[++first]));
+    }
+    else
+    {
+        while (!compare_(pivot, ary[++first]));
+    }
+
+    while (first < last)
+    {
+        this->swap_values(ary, first, last);
+        while (compare_(pivot, ary[--last]));
+        while (!compare_(pivot, ary[++first]));
+    }
+
+    int pivot_pos = last;
+    ary[begin] = std::move(ary[pivot_pos]);
+    ary[pivot_pos] = std::move(pivot);
+    Instrumentation::count_moves(3);
+    return pivot_pos;
+}
+
+template <typename T, typename Compare>
+void PdqSorter<T, Compare>::sort_between_indexes(std::span<T> ary, int begin, int end, int bad_allowed, bool leftmost) const
+{
+    Instrumentation::RecursionScope recursion;
+    while (true)
+    {
+        int size = end - begin;
+        if (size < INSERTION_SORT_THRESHOLD)
+        {
+            insertion_sort(ary, begin, end, leftmost);
+            return;
+        }
+
+        // Move the chosen pivot to the start of the range.
+        int half = size / 2;
+        if (size > NINTHER_THRESHOLD)
+        {
+            sort3(ary, begin, begin + half, end - 1);
+            sort3(ary, begin + 1, begin + (half - 1), end - 2);
+            sort3(ary, begin + 2, begin + (half + 1), end - 3);
+            sort3(ary, begin + (half - 1), begin + half, begin + (half + 1));
+            this->swap_values(ary, begin, begin + half);
+        }
+        else
+        {
+            sort3(ary, begin + half, begin, end - 1);
+        }
+
+        /* The element before the range is a previous pivot, so nothing in the
+         * range is ordered before it. If the new pivot equals it then the range
+         * holds a run of duplicates: gather all of them on the left, where
+         * they are already in their final place, and carry on to the right. */
+        if (!leftmost && !compare_(ary[begin - 1], ary[begin]))
+        {
+            begin = partition_left(ary, begin, end) + 1;
+            continue;
+        }
+
+        auto [pivot_pos, already_partitioned] = partition_right(ary, begin, end);
+        int left_size = pivot_pos - begin;
+        int right_size = end - (pivot_pos + 1);
+        bool highly_unbalanced = left_size < size / 8 || right_size < size / 8;
+        if (highly_unbalanced)
+        {
+            if (--bad_allowed == 0)
+            {
+                heap_sorter_.sort(ary.subspan(begin, size));
+                return;
+            }
+
+            // Swap a few elements around to break up whatever pattern caused the imbalance.
+            if (left_size >= INSERTION_SORT_THRESHOLD)
+            {
+                int quarter = left_size / 4;
+                this->swap_values(ary, begin, begin + quarter);
+                this->swap_values(ary, pivot_pos - 1, pivot_pos - quarter);
+                if (left_size > NINTHER_THRESHOLD)
+                {
+                    this->swap_values(ary, begin + 1, begin + (quarter + 1));
+                    this->swap_values(ary, begin + 2, begin + (quarter + 2));
+                    this->swap_values(ary, pivot_pos - 2, pivot_pos - (quarter + 1));
+                    this->swap_values(ary, pivot_pos - 3, pivot_pos - (quarter + 2));
+                }
+            }
+            if (right_size >= INSERTION_SORT_THRESHOLD)
+            {
+                int quarter = right_size / 4;
+                this->swap_values(ary, pivot_pos + 1, pivot_pos + (1 + quarter));
+                this->swap_values(ary, end - 1, end - quarter);
+                if (right_size > NINTHER_THRESHOLD)
+                {
+                    this->swap_values(ary, pivot_pos + 2, pivot_pos + (2 + quarter));
+                    this->swap_values(ary, pivot_pos + 3, pivot_pos + (3 + quarter));
+                    this->swap_values(ary, end - 2, end - (1 + quarter));
+                    this->swap_values(ary, end - 3, end - (2 + quarter));
+                }
+            }
+        }
+        else if (already_partitioned
+            && partial_insertion_sort(ary, begin, pivot_pos)
+            && partial_insertion_sort(ary, pivot_pos + 1, end))
+        {
+            // No swaps were needed and both sides turned out to be nearly sorted.
+            return;
+        }
+
+        /* Recurse into the smaller side and loop on the larger one so the
+         * stack never grows beyond O(log n) frames. */
+        if (left_size < right_size)
+        {
+            sort_between_indexes(ary, begin, pivot_pos, bad_allowed, leftmost);
+            begin = pivot_pos + 1;
+            leftmost = false;
+        }
+        else
+        {
+            sort_between_indexes(ary, pivot_pos + 1, end, bad_allowed, false);
+            end = pivot_pos;
+        }
+    }
+}
+
+template <typename T, typename Compare>
+void PdqSorter<T, Compare>::sort(std::span<T> ary) const
+{
+    int count = ary.size();
+    if (count < 2)
+    {
+        return;
+    }
+    // Allow about log2(n) bad partitions before falling back to heap sort.
+    int bad_allowed = std::bit_width(static_cast<unsigned>(count));
+    sort_between_indexes(ary, 0, count, bad_allowed, true);
+}
+
+template <typename T, typename Compare>
+void PdqSorter<T, Compare>::move_median_of_medians(std::span<T> ary, int begin, int end) const
+{
+    // Sort each group of five and gather the medians at the start of the range, where
+    // they only overwrite groups that are already done.
+    int num_groups = (end - begin) / 5;
+    for (int group = 0; group < num_groups; ++group)
+    {
+        int first = begin + 5 * group;
+        insertion_sort(ary, first, first + 5, true);
+        this->swap_values(ary, begin + group, first + 2);
+    }
+    int median = begin + num_groups / 2;
+    select_between_indexes(ary, begin, begin + num_groups, median, true);
+    this->swap_values(ary, begin, median);
+
+    // Half the medians and two elements in each of their groups are not ordered before the pivot.
+    int last = end - 1;
+    while (compare_(ary[last], ary[begin]))
+    {
+        --last;
+    }
+    this->swap_values(ary, last, end - 1);
+}
+
+template <typename T, typename Compare>
+void PdqSorter<T, Compare>::select_between_indexes(std::span<T> ary, int begin, int end, int k, bool leftmost) const
+{
+    Instrumentation::RecursionScope recursion;
+    bool guaranteed = false;
+    int rounds = 0;
+    int budget = end - begin;
+    while (true)
+    {
+        int size = end - begin;
+        if (size < INSERTION_SORT_THRESHOLD)
+        {
+            insertion_sort(ary, begin, end, leftmost);
+            return;
+        }
+
+        if (guaranteed)
+        {
+            move_median_of_medians(ary, begin, end);
+        }
+        else if (size > NINTHER_THRESHOLD)
+        {
+            int half = size / 2;
+            sort3(ary, begin, begin + half, end - 1);
+            sort3(ary, begin + 1, begin + (half - 1), end - 2);
+            sort3(ary, begin + 2, begin + (half + 1), end - 3);
+            sort3(ary, begin + (half - 1), begin + half, begin + (half + 1));
+            this->swap_values(ary, begin, begin + half);
+        }
+        else
+        {
+            sort3(ary, begin + size / 2, begin, end - 1);
+        }
+
+        // As in sorting, a pivot equal to the previous one gathers all its duplicates on the left, in place.
+        if (!leftmost && !compare_(ary[begin - 1], ary[begin]))
+        {
+            int pivot_pos = partition_left(ary, begin, end);
+            if (k <= pivot_pos)
+            {
+                return;
+            }
+            begin = pivot_pos + 1;
+        }
+        else
+        {
+            int pivot_pos = partition_right(ary, begin, end).first;
+            if (k == pivot_pos)
+            {
+                return;
+            }
+            if (k < pivot_pos)
+            {
+                end = pivot_pos;
+            }
+            else
+            {
+                begin = pivot_pos + 1;
+                leftmost = false;
+            }
+        }
+
+        // Quickselect is linear as long as the range keeps shrinking geometrically, so check that it halves
+        // every two rounds and switch to the guaranteed pivots the first time it does not.
+        if (!guaranteed && ++rounds == 2)
+        {
+            guaranteed = end - begin > budget / 2;
+            budget = end - begin;
+            rounds = 0;
+        }
+    }
+}
+
+template <typename T, typename Compare>
+void PdqSorter<T, Compare>::select_nth(std::span<T> ary, int k) const
+{
+    int count = ary.size();
+    if (k < 0 || k >= count)
+    {
+        throw std::runtime_error("Cannot select index " + std::to_string(k) + " of " + std::to_string(count) + " elements");
+    }
+    select_between_indexes(ary, 0, count, k, true);
+}
+
+template <typename T, typename Compare>
+void PdqSorter<T, Compare>::partial_sort(std::span<T> ary, int k) const
+{
+    int count = ary.size();
+    if (k < 0 || k > count)
+    {
+        throw std::runtime_error("Cannot sort the first " + std::to_string(k) + " of " + std::to_string(count) + " elements");
+    }
+    if (k < count)
+    {
+        select_between_indexes(ary, 0, count, k, true);
+    }
+    sort(ary.first(k));
+}
@@ -0,0 +1,155 @@
+#include <cstdint>
+#include <cstring>
+#include "perf_counters.h"
+
+#if defined(__linux__)
+#define CPPSORT_HAVE_PERF_EVENTS 1
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/// The names of the events, in the order of HardwareEvent.
+static const char * const EVENT_NAMES[NUM_HARDWARE_EVENTS] = {
+    "cycles", "instructions", "branch-misses", "l1d-misses", "llc-misses", "dtlb-misses"
+};
+
+const char * PerfCounters::event_name(HardwareEvent event)
+{
+    return EVENT_NAMES[static_cast<int>(event)];
+}
+
+bool PerfCounters::available() const
+{
+    for (int fd : fds_)
+    {
+        if (fd >= 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef CPPSORT_HAVE_PERF_EVENTS
+
+/**
+ * @brief Builds the config of a cache event that counts read misses.
+ *
+ * @param cache The cache, such as PERF_COUNT_HW_CACHE_L1D.
+ * @return The config for a PERF_TYPE_HW_CACHE event.
+ */
+static std::uint64_t cache_read_misses(std::uint64_t cache)
+{
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+/**
+ * @brief The layout read() fills for a counter opened with the time fields.
+ */
+struct CounterValue
+{
+    /// The raw count.
+    std::uint64_t value;
+
+    /// Nanoseconds the counter was enabled.
+    std::uint64_t time_enabled;
+
+    /// Nanoseconds the counter was actually on the hardware, less than time_enabled when multiplexed.
+    std::uint64_t time_running;
+};
+
+PerfCounters::PerfCounters()
+{
+    static const std::uint32_t TYPES[NUM_HARDWARE_EVENTS] = {
+        PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+        PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE
+    };
+    const std::uint64_t CONFIGS[NUM_HARDWARE_EVENTS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES,
+        cache_read_misses(PERF_COUNT_HW_CACHE_L1D), cache_read_misses(PERF_COUNT_HW_CACHE_LL),
+        cache_read_misses(PERF_COUNT_HW_CACHE_DTLB)
+    };
+    for (int i = 0; i < NUM_HARDWARE_EVENTS; ++i)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = TYPES[i];
+        attr.config = CONFIGS[i];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // The calling thread on any CPU. A failure, such as ENOSYS or EACCES, just leaves the event out.
+        fds_[i] = ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    for (int fd : fds_)
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+}
+
+void PerfCounters::start()
+{
+    for (int fd : fds_)
+    {
+        if (fd >= 0)
+        {
+            ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+}
+
+CounterReading PerfCounters::stop()
+{
+    for (int fd : fds_)
+    {
+        if (fd >= 0)
+        {
+            ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    CounterReading reading;
+    for (int i = 0; i < NUM_HARDWARE_EVENTS; ++i)
+    {
+        CounterValue counter;
+        if (fds_[i] < 0 || ::read(fds_[i], &counter, sizeof(counter)) != sizeof(counter) || counter.time_running == 0)
+        {
+            continue;
+        }
+        double scale = static_cast<double>(counter.time_enabled) / counter.time_running;
+        reading.counts[i] = static_cast<std::uint64_t>(counter.value * scale + 0.5);
+    }
+    return reading;
+}
+
+#else
+
+PerfCounters::PerfCounters()
+{
+    for (int & fd : fds_)
+    {
+        fd = -1;
+    }
+}
+
+PerfCounters::~PerfCounters() {}
+
+void PerfCounters::start() {}
+
+CounterReading PerfCounters::stop()
+{
+    return CounterReading();
+}
+
+#endif
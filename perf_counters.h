@@ -0,0 +1,118 @@
+#include <cstdint>
+#include <optional>
+#pragma once
+
+/**
+ * @brief Selects a hardware event PerfCounters counts.
+ */
+enum class HardwareEvent
+{
+    /// Processor cycles.
+    CYCLES = 0,
+    /// Instructions retired.
+    INSTRUCTIONS = 1,
+    /// Branches the processor predicted wrongly.
+    BRANCH_MISSES = 2,
+    /// Reads that missed the level 1 data cache.
+    L1D_MISSES = 3,
+    /// Reads that missed the last-level cache and went to memory.
+    LLC_MISSES = 4,
+    /// Reads whose address was not in the data TLB.
+    DTLB_MISSES = 5
+};
+
+/// Number of values in HardwareEvent.
+static constexpr int NUM_HARDWARE_EVENTS = 6;
+
+/**
+ * @struct CounterReading
+ * @brief The counts of every hardware event over one measured interval.
+ */
+struct CounterReading
+{
+    /// The count of each event, indexed by HardwareEvent, or std::nullopt if it could not be counted.
+    std::optional<std::uint64_t> counts[NUM_HARDWARE_EVENTS];
+
+    /**
+     * @brief Returns the count of one event.
+     *
+     * @param event The event.
+     * @return The count, or std::nullopt if it could not be counted.
+     */
+    std::optional<std::uint64_t> operator[](HardwareEvent event) const
+    {
+        return counts[static_cast<int>(event)];
+    }
+};
+
+/**
+ * @class PerfCounters
+ * @brief Counts hardware events on the calling thread with the Linux perf_event_open interface.
+ *
+ * Every event gets its own counter, so events the processor or the kernel cannot
+ * count are left out while the others still work. Containers and virtual machines
+ * often allow no counters at all, and other systems have no perf_event_open, in
+ * which case available() is false and every reading is empty. Construction never
+ * fails, so callers can always fall back to timing alone.
+ *
+ * Only user-space events on the thread that opened the counters are counted, which
+ * the default kernel.perf_event_paranoid setting allows without privileges. Work
+ * the parallel sorters hand to their thread pools is therefore not included. When
+ * there are more events than hardware counters, the kernel takes turns between
+ * them and the counts are scaled up to the whole interval.
+ *
+ * @section Example
+ * @code
+ * PerfCounters counters;
+ * counters.start();
+ * sorter.sort(values);
+ * CounterReading reading = counters.stop();
+ * if (reading[HardwareEvent::CYCLES]) { ... }
+ * @endcode
+ */
+class PerfCounters
+{
+    /// The file descriptor of each event's counter, or -1 if it could not be opened.
+    int fds_[NUM_HARDWARE_EVENTS];
+
+public:
+    /**
+     * @brief Opens a counter for every event the system allows, without starting them.
+     */
+    PerfCounters();
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters & operator=(const PerfCounters &) = delete;
+
+    /**
+     * @brief Closes the counters.
+     */
+    ~PerfCounters();
+
+    /**
+     * @brief Reports whether any event can be counted.
+     *
+     * @return true if at least one counter is open; false otherwise.
+     */
+    bool available() const;
+
+    /**
+     * @brief Returns the name of an event, for reports.
+     *
+     * @param event The event.
+     * @return A lower-case name such as "branch-misses".
+     */
+    static const char * event_name(HardwareEvent event);
+
+    /**
+     * @brief Zeroes the counters and starts counting.
+     */
+    void start();
+
+    /**
+     * @brief Stops counting and reads the counters.
+     *
+     * @return The counts since start(), with std::nullopt for every event that could not be counted.
+     */
+    CounterReading stop();
+};
@@ -0,0 +1,708 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include "common.h"
+#include "managed_dynamic_array.h"
+#pragma once
+
+template <typename T, typename Compare>
+/**
+ * @class RunMerger
+ * @brief Merges neighbouring runs with galloping, using one scratch buffer for every merge.
+ *
+ * @tparam T The type of elements to merge.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
+ *
+ * Ties always go to the run on the left, so merges are stable. How many wins in a
+ * row start galloping adapts to the data: it drops while galloping pays off and
+ * rises when it does not.
+ */
+class RunMerger
+{
+    /// Number of wins in a row after which a merge starts galloping.
+    static constexpr int MIN_GALLOP = 7;
+
+    /// Orders the elements.
+    [[no_unique_address]] Compare compare_;
+
+    /// Holds a copy of the shorter run of each merge.
+    T * scratch_;
+
+    /// Number of wins in a row after which the current merge starts galloping.
+    int min_gallop_;
+
+    /**
+     * @brief Finds where a key goes in a sorted range, before any elements equal to it.
+     *
+     * Searches outwards from a hint with steps of 1, 3, 7, 15 and so on, then
+     * binary searches the last step, so a key that goes near the hint is found in
+     * a few comparisons.
+     *
+     * @param key The key to place.
+     * @param data The sorted range.
+     * @param count Number of elements in the range, at least 1.
+     * @param hint The index to start searching from.
+     * @return The number of elements in the range ordered before @p key.
+     */
+    int gallop_left(const T & key, const T * data, int count, int hint) const
+    {
+        int last_offset = 0;
+        int offset = 1;
+        if (compare_(data[hint], key))
+        {
+            // Gallop right until data[hint + last_offset] < key <= data[hint + offset].
+            int max_offset = count - hint;
+            while (offset < max_offset && compare_(data[hint + offset], key))
+            {
+                last_offset = offset;
+                offset = offset > (max_offset - 1) / 2 ? max_offset : 2 * offset + 1;
+            }
+            offset = std::min(offset, max_offset);
+            last_offset += hint;
+            offset += hint;
+        }
+        else
+        {
+            // Gallop left until data[hint - offset] < key <= data[hint - last_offset].
+            int max_offset = hint + 1;
+            while (offset < max_offset && !compare_(data[hint - offset], key))
+            {
+                last_offset = offset;
+                offset = offset > (max_offset - 1) / 2 ? max_offset : 2 * offset + 1;
+            }
+            offset = std::min(offset, max_offset);
+            int previous = last_offset;
+            last_offset = hint - offset;
+            offset = hint - previous;
+        }
+        // data[last_offset] < key <= data[offset], where last_offset may be -1 and offset may be count.
+        return std::lower_bound(data + last_offset + 1, data + offset, key, compare_) - data;
+    }
+
+    /**
+     * @brief Finds where a key goes in a sorted range, after any elements equal to it.
+     *
+     * @param key The key to place.
+     * @param data The sorted range.
+     * @param count Number of elements in the range, at least 1.
+     * @param hint The index to start searching from.
+     * @return The number of elements in the range not ordered after @p key.
+     */
+    int gallop_right(const T & key, const T * data, int count, int hint) const
+    {
+        int last_offset = 0;
+        int offset = 1;
+        if (compare_(key, data[hint]))
+        {
+            // Gallop left until data[hint - offset] <= key < data[hint - last_offset].
+            int max_offset = hint + 1;
+            while (offset < max_offset && compare_(key, data[hint - offset]))
+            {
+                last_offset = offset;
+                offset = offset > (max_offset - 1) / 2 ? max_offset : 2 * offset + 1;
+            }
+            offset = std::min(offset, max_offset);
+            int previous = last_offset;
+            last_offset = hint - offset;
+            offset = hint - previous;
+        }
+        else
+        {
+            // Gallop right until data[hint + last_offset] <= key < data[hint + offset].
+            int max_offset = count - hint;
+            while (offset < max_offset && !compare_(key, data[hint + offset]))
+            {
+                last_offset = offset;
+                offset = offset > (max_offset - 1) / 2 ? max_offset : 2 * offset + 1;
+            }
+            offset = std::min(offset, max_offset);
+            last_offset += hint;
+            offset += hint;
+        }
+        return std::upper_bound(data + last_offset + 1, data + offset, key, compare_) - data;
+    }
+
+    /**
+     * @brief Ends merge_low() once the first run has one element left or the second has none.
+     *
+     * @param a The unmerged elements of the first run, in scratch space.
+     * @param a_count Number of unmerged elements in the first run.
+     * @param b The unmerged elements of the second run, in place.
+     * @param b_count Number of unmerged elements in the second run.
+     * @param dest The first slot that has not been filled.
+     */
+    static void finish_low(T * a, int a_count, T * b, int b_count, T * dest)
+    {
+        if (b_count == 0)
+        {
+            std::move(a, a + a_count, dest);
+        }
+        else if (a_count == 1)
+        {
+            dest = std::move(b, b + b_count, dest);
+            *dest = std::move(*a);
+        }
+        // With the first run empty, the rest of the second is already in place.
+    }
+
+    /**
+     * @brief Ends merge_high() once the first run is empty or the second has one element left.
+     *
+     * @param a_base The unmerged elements of the first run, in place.
+     * @param a_count Number of unmerged elements in the first run.
+     * @param b_base The unmerged elements of the second run, in scratch space.
+     * @param b_count Number of unmerged elements in the second run.
+     * @param dest The last slot that has not been filled.
+     */
+    static void finish_high(T * a_base, int a_count, T * b_base, int b_count, T * dest)
+    {
+        if (a_count == 0)
+        {
+            std::move(b_base, b_base + b_count, a_base);
+        }
+        else if (b_count == 1)
+        {
+            std::move_backward(a_base, a_base + a_count, dest + 1);
+            *a_base = std::move(*b_base);
+        }
+        // With the second run empty, the rest of the first is already in place.
+    }
+
+    /**
+     * @brief Merges two runs by copying the first to scratch space and filling from the left.
+     *
+     * @param a The first run, directly followed by the second.
+     * @param a_count Number of elements in the first run, no more than the second.
+     * @param b The second run.
+     * @param b_count Number of elements in the second run.
+     * @note b[0] must belong before a[0], and a[a_count - 1] after b[b_count - 1].
+     */
+    void merge_low(T * a, int a_count, T * b, int b_count)
+    {
+        std::move(a, a + a_count, scratch_);
+        T * dest = a;
+        a = scratch_;
+
+        *dest++ = std::move(*b++);
+        if (--b_count == 0 || a_count == 1)
+        {
+            finish_low(a, a_count, b, b_count, dest);
+            return;
+        }
+        while (true)
+        {
+            // Take one element at a time until one run wins min_gallop_ times in a row.
+            int a_wins = 0;
+            int b_wins = 0;
+            do
+            {
+                // Branch-free, like scalar_merge(), since on random data the winner is a coin toss.
+                bool take_b = compare_(*b, *a);
+                *dest++ = std::move(take_b ? *b : *a);
+                b += take_b;
+                a += !take_b;
+                b_count -= take_b;
+                a_count -= !take_b;
+                b_wins = take_b ? b_wins + 1 : 0;
+                a_wins = take_b ? 0 : a_wins + 1;
+                if (b_count == 0 || a_count == 1)
+                {
+                    finish_low(a, a_count, b, b_count, dest);
+                    return;
+                }
+            } while ((a_wins | b_wins) < min_gallop_);
+
+            // Gallop until neither run wins a long stretch, making galloping easier to start next time.
+            ++min_gallop_;
+            do
+            {
+                min_gallop_ -= min_gallop_ > 1;
+                a_wins = gallop_right(*b, a, a_count, 0);
+                if (a_wins > 0)
+                {
+                    dest = std::move(a, a + a_wins, dest);
+                    a += a_wins;
+                    a_count -= a_wins;
+                    if (a_count <= 1)
+                    {
+                        finish_low(a, a_count, b, b_count, dest);
+                        return;
+                    }
+                }
+                *dest++ = std::move(*b++);
+                if (--b_count == 0)
+                {
+                    finish_low(a, a_count, b, b_count, dest);
+                    return;
+                }
+
+                b_wins = gallop_left(*a, b, b_count, 0);
+                if (b_wins > 0)
+                {
+                    dest = std::move(b, b + b_wins, dest);
+                    b += b_wins;
+                    b_count -= b_wins;
+                    if (b_count == 0)
+                    {
+                        finish_low(a, a_count, b, b_count, dest);
+                        return;
+                    }
+                }
+                *dest++ = std::move(*a++);
+                if (--a_count == 1)
+                {
+                    finish_low(a, a_count, b, b_count, dest);
+                    return;
+                }
+            } while (a_wins >= MIN_GALLOP || b_wins >= MIN_GALLOP);
+            ++min_gallop_;
+        }
+    }
+
+    /**
+     * @brief Merges two runs by copying the second to scratch space and filling from the right.
+     *
+     * @param a The first run, directly followed by the second.
+     * @param a_count Number of elements in the first run.
+     * @param b The second run.
+     * @param b_count Number of elements in the second run, no more than the first.
+     * @note b[0] must belong before a[0], and a[a_count - 1] after b[b_count - 1].
+     */
+    void merge_high(T * a, int a_count, T * b, int b_count)
+    {
+        std::move(b, b + b_count, scratch_);
+        T * a_base = a;
+        T * b_base = scratch_;
+        // The last unmerged element of each run, and the slot the next largest element goes in.
+        T * dest = b + b_count - 1;
+        a = a_base + a_count - 1;
+        b = b_base + b_count - 1;
+
+        *dest-- = std::move(*a--);
+        if (--a_count == 0 || b_count == 1)
+        {
+            finish_high(a_base, a_count, b_base, b_count, dest);
+            return;
+        }
+        while (true)
+        {
+            int a_wins = 0;
+            int b_wins = 0;
+            do
+            {
+                bool take_a = compare_(*b, *a);
+                *dest-- = std::move(take_a ? *a : *b);
+                a -= take_a;
+                b -= !take_a;
+                a_count -= take_a;
+                b_count -= !take_a;
+                a_wins = take_a ? a_wins + 1 : 0;
+                b_wins = take_a ? 0 : b_wins + 1;
+                if (a_count == 0 || b_count == 1)
+                {
+                    finish_high(a_base, a_count, b_base, b_count, dest);
+                    return;
+                }
+            } while ((a_wins | b_wins) < min_gallop_);
+
+            ++min_gallop_;
+            do
+            {
+                min_gallop_ -= min_gallop_ > 1;
+                // Elements of the first run ordered after *b go last, as a block.
+                a_wins = a_count - gallop_right(*b, a_base, a_count, a_count - 1);
+                if (a_wins > 0)
+                {
+                    dest -= a_wins;
+                    a -= a_wins;
+                    a_count -= a_wins;
+                    std::move_backward(a + 1, a + 1 + a_wins, dest + 1 + a_wins);
+                    if (a_count == 0)
+                    {
+                        finish_high(a_base, a_count, b_base, b_count, dest);
+                        return;
+                    }
+                }
+                *dest-- = std::move(*b--);
+                if (--b_count == 1)
+                {
+                    finish_high(a_base, a_count, b_base, b_count, dest);
+                    return;
+                }
+
+                // Elements of the second run not ordered before *a go last, after it.
+                b_wins = b_count - gallop_left(*a, b_base, b_count, b_count - 1);
+                if (b_wins > 0)
+                {
+                    dest -= b_wins;
+                    b -= b_wins;
+                    b_count -= b_wins;
+                    std::move(b + 1, b + 1 + b_wins, dest + 1);
+                    if (b_count <= 1)
+                    {
+                        finish_high(a_base, a_count, b_base, b_count, dest);
+                        return;
+                    }
+                }
+                *dest-- = std::move(*a--);
+                if (--a_count == 0)
+                {
+                    finish_high(a_base, a_count, b_base, b_count, dest);
+                    return;
+                }
+            } while (a_wins >= MIN_GALLOP || b_wins >= MIN_GALLOP);
+            ++min_gallop_;
+        }
+    }
+
+public:
+    /**
+     * @brief Prepares to merge runs.
+     *
+     * @param compare The order the runs are sorted in.
+     * @param scratch Space for half the elements of the array, rounded down.
+     */
+    RunMerger(Compare compare, T * scratch) : compare_(compare), scratch_(scratch), min_gallop_(MIN_GALLOP) {}
+
+    /**
+     * @brief Merges two neighbouring runs into one.
+     *
+     * @param a The first run, directly followed by the second.
+     * @param a_count Number of elements in the first run.
+     * @param b_count Number of elements in the second run.
+     */
+    void merge(T * a, int a_count, int b_count)
+    {
+        T * b = a + a_count;
+        // Elements of the first run ordered before b[0] are already in place.
+        int skip = gallop_right(b[0], a, a_count, 0);
+        a += skip;
+        a_count -= skip;
+        if (a_count == 0)
+        {
+            return;
+        }
+        // So are elements of the second run ordered after the last element of the first.
+        b_count = gallop_left(a[a_count - 1], b, b_count, b_count - 1);
+        if (b_count == 0)
+        {
+            return;
+        }
+
+        Instrumentation::count_moves(std::min(a_count, b_count) + a_count + b_count);
+        if (a_count <= b_count)
+        {
+            merge_low(a, a_count, b, b_count);
+        }
+        else
+        {
+            merge_high(a, a_count, b, b_count);
+        }
+    }
+};
+
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @class PowerSorter
+ * @brief Implements Powersort, a stable merge sort that takes advantage of runs already in the input.
+ *
+ * @tparam T The type of elements to sort.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
+ *
+ * The array is scanned from left to right for runs: maximal stretches that are
+ * ascending, or strictly descending and then reversed, which keeps equal elements
+ * in order. A run shorter than the minimum run length is extended with binary
+ * insertion sort. Each run is pushed on a stack, and the order in which runs are
+ * merged follows the Powersort rule of Munro and Wild: the power of the boundary
+ * between two neighbouring runs is the depth at which their midpoints fall into
+ * different halves of the array, and a run is merged with the one before it
+ * whenever the stack holds a boundary of greater power. This gives merge costs
+ * within a few percent of optimal for the runs that are present, and the stack
+ * never holds more than about log2(n) runs.
+ *
+ * Each merge first skips the elements already in their final place at either end,
+ * then copies the shorter run to scratch space and merges towards the other end.
+ * When one run keeps winning, the merge switches to galloping: an exponential
+ * search finds how many elements in a row come from that run, and they are moved
+ * as a block. A sorted input is a single run and takes n - 1 comparisons. Random
+ * input takes about n log2 n comparisons, like MergeSorter.
+ */
+class PowerSorter : public Sorter<T>
+{
+    /// Runs shorter than this are extended with binary insertion sort.
+    int min_run_;
+
+    /// Orders the elements.
+    [[no_unique_address]] InstrumentedCompare<Compare> compare_;
+
+    /// The run stack holds boundaries of strictly increasing power, and a power is at most 32 for int sizes.
+    static constexpr int MAX_RUNS = 40;
+
+    /**
+     * @struct Run
+     * @brief A run on the Powersort stack.
+     */
+    struct Run
+    {
+        /// The index the run starts at.
+        int start;
+
+        /// Number of elements in the run.
+        int count;
+
+        /// The power of the boundary between this run and the next one.
+        int power;
+    };
+
+    /**
+     * @brief Finds the run that starts at an index, reversing it if it is strictly descending.
+     *
+     * Only strictly descending runs are reversed, so equal elements never change order.
+     *
+     * @param data The elements.
+     * @param start The index the run starts at.
+     * @param end One past the last index that may be part of the run.
+     * @param compare The order to sort the elements in.
+     * @return The length of the run, which is now ascending.
+     */
+    static int find_run(T * data, int start, int end, const InstrumentedCompare<Compare> & compare);
+
+    /**
+     * @brief Extends a sorted prefix of a range to the whole range with binary insertion sort.
+     *
+     * Each element is placed after any equal elements before it, which keeps the sort stable.
+     *
+     * @param data The first element of the range.
+     * @param sorted Number of elements at the start of the range that are already sorted, at least 1.
+     * @param count Number of elements in the range.
+     * @param compare The order to sort the elements in.
+     */
+    static void binary_insertion_sort(T * data, int sorted, int count, const InstrumentedCompare<Compare> & compare);
+
+    /**
+     * @brief Returns the power of the boundary between two neighbouring runs.
+     *
+     * The power is the number of leading bits the positions of the runs' midpoints,
+     * as fractions of the array, have in common, plus one. Computing it bit by bit
+     * with integers avoids both division and rounding.
+     *
+     * @param start The index the first run starts at.
+     * @param first Number of elements in the first run.
+     * @param second Number of elements in the second run, which starts where the first one ends.
+     * @param count Number of elements in the array.
+     * @return The power, from 1 upwards.
+     */
+    static int boundary_power(int start, int first, int second, int count);
+
+    /**
+     * @brief Finds the remaining runs and merges them all.
+     *
+     * @param ary A std::span<T> representing the array to be sorted.
+     * @param scratch A std::span<T> with at least half as many elements as @p ary.
+     * @param first_run The length of the run at the start of @p ary, which is already ascending.
+     */
+    void sort_runs(std::span<T> ary, std::span<T> scratch, int first_run) const;
+
+public:
+    /// Default minimum length of a run.
+    static constexpr int DEFAULT_MIN_RUN = 32;
+
+    /**
+     * @brief Constructs a PowerSorter object with the name "Powersort".
+     *
+     * @param min_run Runs shorter than this are extended with binary insertion sort. Values below 2 use 2.
+     * @param compare The comparator used to order the elements.
+     */
+    PowerSorter(int min_run = DEFAULT_MIN_RUN, Compare compare = Compare())
+        : Sorter<T>("Powersort"), min_run_(min_run < 2 ? 2 : min_run), compare_(compare) {}
+
+    /**
+     * @brief Sorts the given array in place.
+     *
+     * A single scratch buffer of half the size of the array is allocated for the
+     * whole sort, and only if the array is not already one run.
+     *
+     * @param ary A std::span<T> representing the array to be sorted.
+     */
+    void sort(std::span<T> ary) const override;
+
+    /**
+     * @brief Sorts the given array in place using caller-provided scratch space.
+     *
+     * @param ary A std::span<T> representing the array to be sorted.
+     * @param scratch A std::span<T> with at least half as many elements as @p ary, rounded down,
+     * whose contents are overwritten.
+     * @throws std::runtime_error If @p scratch is too small.
+     */
+    void sort(std::span<T> ary, std::span<T> scratch) const;
+
+    /**
+     * @brief Returns the order in which sort() touches the elements of the array.
+     *
+     * @return AccessPattern::SEQUENTIAL, since runs are found and merged from front to back.
+     */
+    AccessPattern access_pattern() const override
+    {
+        return AccessPattern::SEQUENTIAL;
+    }
+};
+
+template <typename T, typename Compare>
+int PowerSorter<T, Compare>::find_run(T * data, int start, int end, const InstrumentedCompare<Compare> & compare)
+{
+    int run_end = start + 1;
+    if (run_end == end)
+    {
+        return 1;
+    }
+    if (compare(data[run_end], data[start]))
+    {
+        while (++run_end < end && compare(data[run_end], data[run_end - 1]));
+        std::reverse(data + start, data + run_end);
+    }
+    else
+    {
+        while (++run_end < end && !compare(data[run_end], data[run_end - 1]));
+    }
+    return run_end - start;
+}
+
+template <typename T, typename Compare>
+void PowerSorter<T, Compare>::binary_insertion_sort(T * data, int sorted, int count,
+    const InstrumentedCompare<Compare> & compare)
+{
+    for (int i = sorted; i < count; ++i)
+    {
+        T value = std::move(data[i]);
+        /* An upper bound search that halves the range with a conditional move, since
+         * on random data the direction of each step cannot be predicted. */
+        T * position = data;
+        for (int remaining = i; remaining > 1; remaining -= remaining / 2)
+        {
+            position += compare(value, position[remaining / 2]) ? 0 : remaining / 2;
+        }
+        position += !compare(value, *position);
+        std::move_backward(position, data + i, data + i + 1);
+        *position = std::move(value);
+        Instrumentation::count_moves(data + i - position + 2);
+    }
+}
+
+template <typename T, typename Compare>
+int PowerSorter<T, Compare>::boundary_power(int start, int first, int second, int count)
+{
+    // Twice the midpoints, so they stay integers.
+    std::int64_t a = 2 * static_cast<std::int64_t>(start) + first;
+    std::int64_t b = a + first + second;
+    int power = 0;
+    while (true)
+    {
+        ++power;
+        if (a >= count)
+        {
+            a -= count;
+            b -= count;
+        }
+        else if (b >= count)
+        {
+            return power;
+        }
+        a <<= 1;
+        b <<= 1;
+    }
+}
+
+template <typename T, typename Compare>
+void PowerSorter<T, Compare>::sort_runs(std::span<T> ary, std::span<T> scratch, int first_run) const
+{
+    T * data = ary.data();
+    int count = ary.size();
+    RunMerger<T, InstrumentedCompare<Compare>> merger(compare_, scratch.data());
+    Run runs[MAX_RUNS];
+    int num_runs = 0;
+    // Merges the top two runs on the stack.
+    auto merge_top = [&]
+    {
+        Run & left = runs[num_runs - 2];
+        Run & right = runs[num_runs - 1];
+        merger.merge(data + left.start, left.count, right.count);
+        left.count += right.count;
+        --num_runs;
+    };
+
+    int start = 0;
+    int run = first_run;
+    while (start < count)
+    {
+        if (start > 0)
+        {
+            run = find_run(data, start, count, compare_);
+        }
+        if (run < min_run_)
+        {
+            int extended = std::min(min_run_, count - start);
+            binary_insertion_sort(data + start, run, extended, compare_);
+            run = extended;
+        }
+
+        if (num_runs > 0)
+        {
+            // Merge every run whose boundary with the run after it has a greater power than the new boundary.
+            const Run & previous = runs[num_runs - 1];
+            int power = boundary_power(previous.start, previous.count, run, count);
+            while (num_runs > 1 && runs[num_runs - 2].power > power)
+            {
+                merge_top();
+            }
+            runs[num_runs - 1].power = power;
+        }
+        runs[num_runs++] = Run{start, run, 0};
+        start += run;
+    }
+    while (num_runs > 1)
+    {
+        merge_top();
+    }
+}
+
+template <typename T, typename Compare>
+void PowerSorter<T, Compare>::sort(std::span<T> ary) const
+{
+    int count = ary.size();
+    if (count < 2)
+    {
+        return;
+    }
+    // An array that is already one run needs no scratch space at all.
+    int first_run = find_run(ary.data(), 0, count, compare_);
+    if (first_run == count)
+    {
+        return;
+    }
+
+    ManagedDynamicArray<T> scratch(count / 2);
+    sort_runs(ary, scratch.to_span(), first_run);
+}
+
+template <typename T, typename Compare>
+void PowerSorter<T, Compare>::sort(std::span<T> ary, std::span<T> scratch) const
+{
+    int count = ary.size();
+    if (static_cast<int>(scratch.size()) < count / 2)
+    {
+        throw std::runtime_error("Scratch space must hold at least " + std::to_string(count / 2) + " elements");
+    }
+    if (count < 2)
+    {
+        return;
+    }
+    int first_run = find_run(ary.data(), 0, count, compare_);
+    if (first_run < count)
+    {
+        sort_runs(ary, scratch, first_run);
+    }
+}
@@ -0,0 +1,22 @@
+#include "probing.h"
+
+const char * strategy_name(SortStrategy strategy)
+{
+    switch (strategy)
+    {
+    case SortStrategy::ALREADY_SORTED:
+        return "already-sorted";
+    case SortStrategy::REVERSE:
+        return "reverse";
+    case SortStrategy::INSERTION:
+        return "insertion";
+    case SortStrategy::RUN_MERGE:
+        return "run-merge";
+    case SortStrategy::COUNTING:
+        return "counting";
+    case SortStrategy::RADIX:
+        return "radix";
+    default:
+        return "quick";
+    }
+}
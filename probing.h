@@ -0,0 +1,549 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "common.h"
+#include "generator.h"
+#include "insertion.h"
+#include "managed_dynamic_array.h"
+#include "pdq.h"
+#include "power.h"
+#include "radix.h"
+#pragma once
+
+/**
+ * @enum SortStrategy
+ * @brief The way a ProbingSorter decided to sort an input.
+ */
+enum class SortStrategy
+{
+    /// The input was already in order, so nothing was done.
+    ALREADY_SORTED = 0,
+    /// The input was in reverse order, so it was reversed.
+    REVERSE = 1,
+    /// The input was small enough for insertion sort.
+    INSERTION = 2,
+    /// The input was made of long runs or only locally out of order, so Powersort merged it.
+    RUN_MERGE = 3,
+    /// The integer keys spanned fewer values than there were elements, so they were counted.
+    COUNTING = 4,
+    /// The integer keys were many and varied, so radix sort distributed them.
+    RADIX = 5,
+    /// Nothing special was found, or the keys were few, so pdqsort partitioned them.
+    QUICK = 6
+};
+
+/**
+ * @brief Returns the name a strategy is logged by.
+ *
+ * @param strategy The strategy.
+ * @return A lower-case name such as "run-merge".
+ */
+const char * strategy_name(SortStrategy strategy);
+
+/**
+ * @struct Presortedness
+ * @brief What a ProbingSorter learned about an input before sorting it.
+ */
+struct Presortedness
+{
+    /// Number of elements.
+    int size = 0;
+
+    /**
+     * Number of leading elements that descents, ascents and runs were counted over. The scan stops
+     * early once there are too many runs for ProbingSorter to hand the input to Powersort.
+     */
+    int scanned = 0;
+
+    /// Number of neighbouring pairs in order with the second strictly before the first.
+    int descents = 0;
+
+    /// Number of neighbouring pairs with the first strictly before the second.
+    int ascents = 0;
+
+    /// Number of ascending or descending runs, counted as one more than the changes of direction.
+    int runs = 0;
+
+    /**
+     * Fraction of randomly sampled pairs that are out of order, from 0 when sorted to 1 when reversed.
+     * Only sampled when the input has at least ProbingSorter::MIN_SAMPLED_SIZE elements and is neither
+     * sorted nor reversed.
+     */
+    double inversion_fraction = 0.0;
+
+    /// Number of random pairs compared to estimate the fraction of inversions, or 0 if none were.
+    int sampled_pairs = 0;
+
+    /// Number of elements sampled to count distinct keys, or 0 if the input was too small to bother.
+    int sample_size = 0;
+
+    /// Number of distinct keys among the sampled elements.
+    int sampled_distinct = 0;
+
+    /**
+     * For integer keys, the largest key minus the smallest, or a part of it no smaller than the size.
+     * Inputs of ProbingSorter::MIN_SAMPLED_SIZE elements or more only have their distinct-key sample
+     * measured, so the range may be larger, and inputs found sorted or reversed are not measured.
+     */
+    std::optional<std::uint64_t> key_range;
+};
+
+/**
+ * @struct ProbeDecision
+ * @brief What a ProbingSorter found out about an input and how it sorted it.
+ */
+struct ProbeDecision
+{
+    /// The measurements.
+    Presortedness presortedness;
+
+    /// The strategy chosen from them.
+    SortStrategy strategy = SortStrategy::QUICK;
+};
+
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @class ProbingSorter
+ * @brief Scans each input before sorting it and routes it to the sorter that suits its shape.
+ *
+ * @tparam T The type of elements to sort.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
+ *
+ * The probe makes one pass over the input, comparing each element with the next
+ * to count ascents, descents and monotone runs, and, for integers, a second pass
+ * for the smallest and largest key. Both passes go a block at a time and stop as
+ * soon as their answer can no longer change the decision, so random input is
+ * barely scanned at all. Inputs of MIN_SAMPLED_SIZE elements or more also have
+ * random pairs compared to estimate the fraction of inversions, and an evenly
+ * spaced sample sorted to estimate the number of distinct keys. Both samples take
+ * one element in SAMPLE_SPACING, up to a cap, so they stay a small fraction of
+ * the sort at every size. A full scan is about 2n sequential comparisons against
+ * the n log2 n scattered ones of a sort.
+ *
+ * The decision is made in this order:
+ * - no descents: already sorted; no ascents: reverse it;
+ * - small inputs: insertion sort;
+ * - an average run of RUN_LENGTH or more, or pairs were sampled and none was inverted: Powersort, which
+ *   merges the runs;
+ * - integer keys with a range smaller than the size: counting sort;
+ * - few distinct keys in a sample: pdqsort, which partitions equal keys away in linear time;
+ * - otherwise integer keys are radix sorted when there are enough of them, and others go to pdqsort.
+ *
+ * Counting and radix sort are only used for integral T ordered by std::less or std::greater.
+ * The sorter is not stable.
+ *
+ * @section Example
+ * @code
+ * ProbingSorter<int> sorter;
+ * ProbeDecision decision = sorter.sort_and_decide(values);
+ * std::cout << strategy_name(decision.strategy) << std::endl;
+ * @endcode
+ */
+class ProbingSorter : public Sorter<T>
+{
+    /// true if counting and radix sort can stand in for comparisons.
+    static constexpr bool INTEGER_KEYS = std::is_integral_v<T>
+        && (std::is_same_v<Compare, std::less<T>> || std::is_same_v<Compare, std::greater<T>>);
+
+    /// Number of elements the probe scans before checking whether it has seen enough.
+    static constexpr int SCAN_BLOCK = 256;
+
+    /// The most random pairs compared to estimate the fraction of inversions.
+    static constexpr int MAX_PAIR_SAMPLES = 256;
+
+    /// The most evenly spaced elements sorted to estimate the number of distinct keys.
+    static constexpr int MAX_DISTINCT_SAMPLES = 256;
+
+    /// Each sample takes one element in this many, so it costs a small fraction of the sort at every size.
+    static constexpr int SAMPLE_SPACING = 64;
+
+    /// The sample has few distinct keys if it has at most one per this many elements.
+    static constexpr int FEW_DISTINCT_RATIO = 8;
+
+    /// Integer inputs smaller than this go to pdqsort, since radix sort's histograms cost the same at any size.
+    static constexpr int MIN_RADIX_SIZE = 1024;
+
+    /// Seeds the choice of sampled pairs, so the same input always gets the same decision.
+    static constexpr std::uint64_t PROBE_SEED = 0x5eed;
+
+    /// Orders the elements.
+    [[no_unique_address]] InstrumentedCompare<Compare> compare_;
+
+    /// Sorts small inputs.
+    InsertionSorter<T, Compare> insertion_sorter_;
+
+    /// Merges the runs of presorted inputs.
+    PowerSorter<T, Compare> power_sorter_;
+
+    /// Sorts everything else.
+    PdqSorter<T, Compare> pdq_sorter_;
+
+    /**
+     * @struct Dereference
+     * @brief Projects a pointer into the input onto the element it points to.
+     */
+    struct Dereference
+    {
+        /// Returns the element @p element points to.
+        const T & operator()(const T * element) const
+        {
+            return *element;
+        }
+    };
+
+    /// Orders pointers into the input by the elements they point to.
+    using SampleCompare = ProjectedCompare<Dereference, Compare>;
+
+    /// Sorts the distinct-key sample, which points into the input so that no element is copied.
+    PdqSorter<const T *, SampleCompare> sample_sorter_;
+
+    /**
+     * @brief Sorts integer keys by counting how many there are of each.
+     *
+     * @param ary A std::span<T> representing the array to be sorted.
+     * @return false, leaving @p ary unchanged, if the keys span at least as many values as there are elements.
+     */
+    bool counting_sort(std::span<T> ary) const;
+
+public:
+    /// Inputs with at most this many elements are insertion sorted.
+    static constexpr int SMALL_SIZE = 32;
+
+    /// Inputs whose runs average at least this many elements go to Powersort.
+    static constexpr int RUN_LENGTH = 32;
+
+    /// Smaller inputs are decided on the scans alone, since sampling would cost too much of their sort.
+    static constexpr int MIN_SAMPLED_SIZE = 4096;
+
+    /**
+     * @brief Constructs a ProbingSorter object with the name "Probing".
+     *
+     * @param compare The comparator used to order the elements.
+     */
+    ProbingSorter(Compare compare = Compare())
+        : Sorter<T>("Probing"), compare_(compare), insertion_sorter_(compare),
+          power_sorter_(PowerSorter<T, Compare>::DEFAULT_MIN_RUN, compare), pdq_sorter_(compare),
+          sample_sorter_(SampleCompare{Dereference(), compare}) {}
+
+    /**
+     * @brief Measures how presorted an input is, without changing it.
+     *
+     * @param ary A std::span<const T> representing the array to be probed.
+     * @return The measurements.
+     */
+    Presortedness probe(std::span<const T> ary) const;
+
+    /**
+     * @brief Picks the strategy for an input from its measurements.
+     *
+     * @param presortedness The measurements of the input.
+     * @return The strategy.
+     */
+    SortStrategy choose(const Presortedness & presortedness) const;
+
+    /**
+     * @brief Probes an input and picks its strategy, without sorting it.
+     *
+     * @param ary A std::span<const T> representing the array to be probed.
+     * @return The measurements and the strategy.
+     */
+    ProbeDecision decide(std::span<const T> ary) const;
+
+    /**
+     * @brief Sorts the given array in place and returns how, so the decision can be logged.
+     *
+     * @param ary A std::span<T> representing the array to be sorted.
+     * @return The measurements and the strategy used.
+     */
+    ProbeDecision sort_and_decide(std::span<T> ary) const;
+
+    /**
+     * @brief Sorts the given array in place with the strategy its probe picks.
+     *
+     * @param ary A std::span<T> representing the array to be sorted.
+     */
+    void sort(std::span<T> ary) const override;
+};
+
+template <typename T, typename Compare>
+Presortedness ProbingSorter<T, Compare>::probe(std::span<const T> ary) const
+{
+    Presortedness presortedness;
+    int count = static_cast<int>(ary.size());
+    presortedness.size = count;
+    if (count < 2)
+    {
+        return presortedness;
+    }
+
+    // One pass counts the ascents, the descents and the turns between them, which end monotone runs. It goes
+    // a block at a time and stops once there are too many runs for Powersort to be chosen, as in random input.
+    // Small inputs are scanned to the end, since a partial count cannot tell them sorted or reversed. A turn is
+    // a change from the last strict direction, so a plateau between an ascent and a descent still ends a run.
+    int descents = compare_(ary[1], ary[0]);
+    int ascents = compare_(ary[0], ary[1]);
+    int turns = 0;
+    bool was_descent = descents;
+    bool was_ascent = ascents;
+    int scanned = 2;
+    while (scanned < count && (count <= SMALL_SIZE || static_cast<std::int64_t>(turns + 1) * RUN_LENGTH < count))
+    {
+        int end = std::min(count, scanned + SCAN_BLOCK);
+        bool counted = false;
+        if constexpr (std::is_arithmetic_v<T>)
+        {
+            // Comparing the previous pair again is cheaper than carrying the last direction, which would stop
+            // vectorization, but it only counts the turns right when no pair up to the end of the block is equal.
+            int block_descents = 0;
+            int block_ascents = 0;
+            int block_turns = 0;
+            for (int i = scanned; i < end; i++)
+            {
+                bool descent = compare_(ary[i], ary[i - 1]);
+                bool ascent = compare_(ary[i - 1], ary[i]);
+                block_descents += descent;
+                block_ascents += ascent;
+                block_turns += (compare_(ary[i - 2], ary[i - 1]) & descent)
+                    | (compare_(ary[i - 1], ary[i - 2]) & ascent);
+            }
+            if (block_descents + block_ascents == end - scanned
+                && compare_(ary[scanned - 2], ary[scanned - 1]) != compare_(ary[scanned - 1], ary[scanned - 2]))
+            {
+                descents += block_descents;
+                ascents += block_ascents;
+                turns += block_turns;
+                was_descent = compare_(ary[end - 1], ary[end - 2]);
+                was_ascent = !was_descent;
+                counted = true;
+            }
+            else if (block_descents + block_ascents == 0)
+            {
+                // A block of equal keys counts nothing and keeps the last direction.
+                counted = true;
+            }
+        }
+        if (!counted)
+        {
+            for (int i = scanned; i < end; i++)
+            {
+                bool descent = compare_(ary[i], ary[i - 1]);
+                bool ascent = compare_(ary[i - 1], ary[i]);
+                descents += descent;
+                ascents += ascent;
+                turns += (was_ascent & descent) | (was_descent & ascent);
+                was_descent = descent | (was_descent & !ascent);
+                was_ascent = ascent | (was_ascent & !descent);
+            }
+        }
+        scanned = end;
+    }
+    presortedness.scanned = scanned;
+    presortedness.descents = descents;
+    presortedness.ascents = ascents;
+    presortedness.runs = turns + 1;
+
+    // Sorted and reversed inputs are decided without a key range or samples.
+    if (descents == 0 || ascents == 0)
+    {
+        presortedness.inversion_fraction = descents > 0 ? 1.0 : 0.0;
+        return presortedness;
+    }
+
+    // Small inputs are decided on their exact key range, without sampling.
+    if (count < MIN_SAMPLED_SIZE)
+    {
+        if constexpr (INTEGER_KEYS)
+        {
+            // The range only matters while it is smaller than the size, so stop looking once it is not.
+            T smallest = ary[0];
+            T largest = ary[0];
+            std::uint64_t key_range = 0;
+            for (int begin = 0; begin < count && key_range < static_cast<std::uint64_t>(count); begin += SCAN_BLOCK)
+            {
+                for (T value : ary.subspan(begin, std::min(SCAN_BLOCK, count - begin)))
+                {
+                    smallest = std::min(smallest, value);
+                    largest = std::max(largest, value);
+                }
+                key_range = static_cast<std::uint64_t>(largest) - static_cast<std::uint64_t>(smallest);
+            }
+            presortedness.key_range = key_range;
+        }
+        return presortedness;
+    }
+
+    Xoshiro256 random(PROBE_SEED);
+    int sampled_pairs = std::min(count / SAMPLE_SPACING, MAX_PAIR_SAMPLES);
+    int inversions = 0;
+    for (int pair = 0; pair < sampled_pairs; pair++)
+    {
+        int i = static_cast<int>(random.below(count));
+        int j = static_cast<int>(random.below(count));
+        inversions += compare_(ary[std::max(i, j)], ary[std::min(i, j)]);
+    }
+    presortedness.sampled_pairs = sampled_pairs;
+    presortedness.inversion_fraction = static_cast<double>(inversions) / sampled_pairs;
+
+    int sample_size = std::min(count / SAMPLE_SPACING, MAX_DISTINCT_SAMPLES);
+    std::vector<const T *> sample;
+    sample.reserve(sample_size);
+    for (int i = 0; i < sample_size; i++)
+    {
+        sample.push_back(&ary[static_cast<std::int64_t>(i) * count / sample_size]);
+    }
+    sample_sorter_.sort(sample);
+    int distinct = 1;
+    for (int i = 1; i < sample_size; i++)
+    {
+        distinct += compare_(*sample[i - 1], *sample[i]);
+    }
+    presortedness.sample_size = sample_size;
+    presortedness.sampled_distinct = distinct;
+    if constexpr (INTEGER_KEYS)
+    {
+        // A pass over a large input for the exact range would cost a good part of a sort, and a range
+        // measured on the sample can only be too small, which counting_sort() finds out in its own pass.
+        auto [smallest, largest] = std::minmax(*sample.front(), *sample.back());
+        presortedness.key_range = static_cast<std::uint64_t>(largest) - static_cast<std::uint64_t>(smallest);
+    }
+    return presortedness;
+}
+
+template <typename T, typename Compare>
+SortStrategy ProbingSorter<T, Compare>::choose(const Presortedness & presortedness) const
+{
+    int count = presortedness.size;
+    if (presortedness.descents == 0)
+    {
+        return SortStrategy::ALREADY_SORTED;
+    }
+    if (presortedness.ascents == 0)
+    {
+        return SortStrategy::REVERSE;
+    }
+    if (count <= SMALL_SIZE)
+    {
+        return SortStrategy::INSERTION;
+    }
+    // Powersort merges a few long runs in close to linear time, and its insertion-sorted minimum runs
+    // absorb disorder that is only local, which leaves no far-apart pair inverted.
+    if (static_cast<std::int64_t>(presortedness.runs) * RUN_LENGTH < count
+        || (presortedness.sampled_pairs > 0 && presortedness.inversion_fraction == 0.0))
+    {
+        return SortStrategy::RUN_MERGE;
+    }
+    if (presortedness.key_range && *presortedness.key_range < static_cast<std::uint64_t>(count))
+    {
+        return SortStrategy::COUNTING;
+    }
+    if (presortedness.sample_size > 0
+        && presortedness.sampled_distinct * FEW_DISTINCT_RATIO <= presortedness.sample_size)
+    {
+        return SortStrategy::QUICK;
+    }
+    if (presortedness.key_range && count >= MIN_RADIX_SIZE)
+    {
+        return SortStrategy::RADIX;
+    }
+    return SortStrategy::QUICK;
+}
+
+template <typename T, typename Compare>
+ProbeDecision ProbingSorter<T, Compare>::decide(std::span<const T> ary) const
+{
+    ProbeDecision decision;
+    decision.presortedness = probe(ary);
+    decision.strategy = choose(decision.presortedness);
+    return decision;
+}
+
+template <typename T, typename Compare>
+bool ProbingSorter<T, Compare>::counting_sort(std::span<T> ary) const
+{
+    if constexpr (INTEGER_KEYS)
+    {
+        T smallest = ary[0];
+        T largest = ary[0];
+        for (T value : ary)
+        {
+            smallest = std::min(smallest, value);
+            largest = std::max(largest, value);
+        }
+        std::uint64_t key_range = static_cast<std::uint64_t>(largest) - static_cast<std::uint64_t>(smallest);
+        if (key_range >= ary.size())
+        {
+            return false;
+        }
+
+        int num_keys = static_cast<int>(key_range) + 1;
+        ManagedDynamicArray<int> counts(num_keys);
+        std::span<int> span_counts = counts.to_span();
+        std::fill(span_counts.begin(), span_counts.end(), 0);
+        for (T value : ary)
+        {
+            span_counts[static_cast<std::size_t>(value - smallest)]++;
+        }
+
+        // The keys are written back from the smallest, or from the largest when descending.
+        constexpr bool DESCENDING = std::is_same_v<Compare, std::greater<T>>;
+        int pos = 0;
+        for (int i = 0; i < num_keys; i++)
+        {
+            int key = DESCENDING ? num_keys - 1 - i : i;
+            std::fill_n(ary.begin() + pos, span_counts[key], static_cast<T>(smallest + key));
+            pos += span_counts[key];
+        }
+        Instrumentation::count_moves(ary.size());
+        return true;
+    }
+    return false;
+}
+
+template <typename T, typename Compare>
+ProbeDecision ProbingSorter<T, Compare>::sort_and_decide(std::span<T> ary) const
+{
+    ProbeDecision decision = decide(ary);
+    switch (decision.strategy)
+    {
+    case SortStrategy::ALREADY_SORTED:
+        break;
+    case SortStrategy::REVERSE:
+        std::reverse(ary.begin(), ary.end());
+        Instrumentation::count_moves(ary.size());
+        break;
+    case SortStrategy::INSERTION:
+        insertion_sorter_.sort(ary);
+        break;
+    case SortStrategy::RUN_MERGE:
+        power_sorter_.sort(ary);
+        break;
+    case SortStrategy::COUNTING:
+        if (counting_sort(ary))
+        {
+            break;
+        }
+        // The sample missed the extreme keys, which span too many values to count.
+        decision.strategy = SortStrategy::RADIX;
+        [[fallthrough]];
+    case SortStrategy::RADIX:
+        if constexpr (INTEGER_KEYS)
+        {
+            RadixSorter<T, Compare>().sort(ary);
+        }
+        break;
+    default:
+        pdq_sorter_.sort(ary);
+        break;
+    }
+    return decision;
+}
+
+template <typename T, typename Compare>
+void ProbingSorter<T, Compare>::sort(std::span<T> ary) const
+{
+    sort_and_decide(ary);
+}
@@ -1,26 +1,55 @@
+#include <algorithm>
+#include <functional>
 #include <span>
+#include <utility>
 #include "common.h"
 #pragma once
 
-template <typename T>
+/**
+ * @brief Selects how QuickSorter partitions each range around its pivot.
+ */
+enum class PartitionScheme
+{
+    /// Scan left to right and swap every element not ordered after the pivot forward.
+    LOMUTO = 0,
+    /// Classify whole blocks of elements into offset buffers, then swap in batches without data-dependent branches.
+    BLOCK = 1
+};
+
+template <typename T, typename Compare = std::less<T>>
 /**
  * @class QuickSorter
  * @brief Implements the Quick Sort algorithm for sorting arrays.
  * 
  * @tparam T The type of elements to sort.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
  *
  * Inherits from the Sorter base class and provides an implementation of the
- * quick sort algorithm using std::span<T> for array manipulation.
+ * quick sort algorithm using std::span<T> for array manipulation. The last
+ * element of each range is the pivot and the partition scheme is chosen at
+ * construction so the schemes can be benchmarked against each other.
  *
  * @note The sorting is performed in-place.
  */
 class QuickSorter : public Sorter<T>
 {
+    /// Number of elements classified at a time by block_partition().
+    static constexpr int PARTITION_BLOCK_SIZE = 64;
+
+    /// The scheme used to partition each range.
+    PartitionScheme scheme_;
+
+    /// Ranges with at most this many elements are finished with insertion sort.
+    int small_size_;
+
+    /// Orders the elements.
+    [[no_unique_address]] InstrumentedCompare<Compare> compare_;
+
     /**
      * @brief Partitions the given array segment for the quicksort algorithm.
      *
      * Organizes the values between the high and low indexes where the
-     * chosen pivot is moved to a new index where all values greater than
+     * chosen pivot is moved to a new index where all values ordered after
      * the pivot are to its right. The new index for the pivot is returned.
      *
      * @param ary A std::span<T> representing the array to partition.
@@ -30,6 +59,41 @@ class QuickSorter : public Sorter<T>
      */
     int partition(std::span<T> ary, int low, int high) const;
 
+    /**
+     * @brief Partitions the given array segment with the Lomuto scheme.
+     *
+     * @param ary A std::span<T> representing the array to partition.
+     * @param low The starting index of the segment to partition.
+     * @param high The ending index of the segment to partition (pivot element).
+     * @return The index position of the pivot after partitioning.
+     */
+    int lomuto_partition(std::span<T> ary, int low, int high) const;
+
+    /**
+     * @brief Partitions the given array segment with the BlockQuicksort scheme.
+     *
+     * Blocks are scanned from both ends of the segment. The offsets of elements
+     * on the wrong side of the pivot are recorded by adding each comparison result
+     * to a counter instead of branching on it, and then pairs of misplaced elements
+     * are swapped. The pivot ends at the same index as with lomuto_partition(), but
+     * the other elements may be arranged differently on each side of it.
+     *
+     * @param ary A std::span<T> representing the array to partition.
+     * @param low The starting index of the segment to partition.
+     * @param high The ending index of the segment to partition (pivot element).
+     * @return The index position of the pivot after partitioning.
+     */
+    int block_partition(std::span<T> ary, int low, int high) const;
+
+    /**
+     * @brief Sorts a subrange of the given array with insertion sort.
+     *
+     * @param ary A std::span<T> representing the array to sort.
+     * @param low The starting index of the subrange to sort.
+     * @param high The ending index of the subrange to sort.
+     */
+    void insertion_sort(std::span<T> ary, int low, int high) const;
+
     /**
      * @brief Sorts a subrange of the given array in place.
      *
@@ -43,13 +107,25 @@ class QuickSorter : public Sorter<T>
     void sort_between_indexes(std::span<T> ary, int low, int high) const;
 
 public:
+    /// Default number of elements at or below which ranges are finished with insertion sort.
+    static constexpr int DEFAULT_SMALL_SIZE = 1;
+
     /**
      * @brief Constructs a QuickSorter object and initializes its base Sorter with the name "Quick".
      *
      * This constructor sets up the QuickSorter by calling the base Sorter class constructor
      * with the string "Quick", identifying the sorting algorithm implemented by this class.
+     * The block partition scheme is named "Block Quick" instead.
+     *
+     * @param scheme The scheme used to partition each range.
+     * @param small_size Ranges with at most this many elements are finished with insertion sort.
+     * The default partitions all the way down, as no range of one element needs sorting.
+     * @param compare The comparator used to order the elements.
      */
-    QuickSorter() : Sorter<T>("Quick") {}
+    QuickSorter(PartitionScheme scheme = PartitionScheme::LOMUTO, int small_size = DEFAULT_SMALL_SIZE,
+        Compare compare = Compare())
+        : Sorter<T>(scheme == PartitionScheme::BLOCK ? "Block Quick" : "Quick"), scheme_(scheme),
+          small_size_(small_size), compare_(compare) {}
 
     /**
      * @brief Sorts the given array in-place.
@@ -61,4 +137,152 @@ public:
      * @param ary A std::span<T> representing the array to be sorted.
      */
     void sort(std::span<T> ary) const override;
-};
\ No newline at end of file
+};
+
+template <typename T, typename Compare>
+int QuickSorter<T, Compare>::partition(std::span<T> ary, int low, int high) const
+{
+    return scheme_ == PartitionScheme::BLOCK
+        ? block_partition(ary, low, high)
+        : lomuto_partition(ary, low, high);
+}
+
+template <typename T, typename Compare>
+int QuickSorter<T, Compare>::lomuto_partition(std::span<T> ary, int low, int high) const
+{
+    // The pivot stays at high until the final swap, so it is compared in place rather than copied.
+    const T & pivot = ary[high];
+    /* initialize the index below low because the index is guaranteed
+     * to be incremented before the pivot is moved to its new home. */
+    int new_pivot_index = low - 1;
+    for (int i = low; i < high; ++i)
+    {
+        if (!compare_(pivot, ary[i]))
+        {
+            this->swap_values(ary, ++new_pivot_index, i);
+        }
+    }
+    /* There will always be at least one swap call since if this is the
+     * first time, it means every value checked is ordered after the pivot. */
+    this->swap_values(ary, ++new_pivot_index, high);
+    return new_pivot_index;
+}
+
+template <typename T, typename Compare>
+int QuickSorter<T, Compare>::block_partition(std::span<T> ary, int low, int high) const
+{
+    const T & pivot = ary[high];
+    unsigned char left_offsets[PARTITION_BLOCK_SIZE];
+    unsigned char right_offsets[PARTITION_BLOCK_SIZE];
+    int left_count = 0, right_count = 0;
+    int left_start = 0, right_start = 0;
+    /* Everything before first is not ordered after the pivot and everything
+     * from last up to the pivot is. A block is only stepped over
+     * once all of its misplaced elements have been swapped out. */
+    int first = low;
+    int last = high;
+    while (last - first > 2 * PARTITION_BLOCK_SIZE)
+    {
+        if (left_count == 0)
+        {
+            left_start = 0;
+            for (int i = 0; i < PARTITION_BLOCK_SIZE; ++i)
+            {
+                left_offsets[left_count] = i;
+                left_count += compare_(pivot, ary[first + i]);
+            }
+        }
+        if (right_count == 0)
+        {
+            right_start = 0;
+            for (int i = 0; i < PARTITION_BLOCK_SIZE; ++i)
+            {
+                right_offsets[right_count] = i;
+                right_count += !compare_(pivot, ary[last - 1 - i]);
+            }
+        }
+
+        int num_swaps = std::min(left_count, right_count);
+        for (int i = 0; i < num_swaps; ++i)
+        {
+            this->swap_values(ary, first + left_offsets[left_start + i], last - 1 - right_offsets[right_start + i]);
+        }
+        left_count -= num_swaps;
+        right_count -= num_swaps;
+        left_start += num_swaps;
+        right_start += num_swaps;
+        if (left_count == 0)
+        {
+            first += PARTITION_BLOCK_SIZE;
+        }
+        if (right_count == 0)
+        {
+            last -= PARTITION_BLOCK_SIZE;
+        }
+    }
+
+    // Too little is left for whole blocks, so finish the way Lomuto would.
+    int new_pivot_index = first;
+    for (int i = first; i < last; ++i)
+    {
+        if (!compare_(pivot, ary[i]))
+        {
+            this->swap_values(ary, new_pivot_index++, i);
+        }
+    }
+    this->swap_values(ary, new_pivot_index, high);
+    return new_pivot_index;
+}
+
+template <typename T, typename Compare>
+void QuickSorter<T, Compare>::insertion_sort(std::span<T> ary, int low, int high) const
+{
+    for (int i = low + 1; i <= high; ++i)
+    {
+        if (!compare_(ary[i], ary[i - 1]))
+        {
+            continue;
+        }
+        T old = std::move(ary[i]);
+        int j = i;
+        do
+        {
+            ary[j] = std::move(ary[j - 1]);
+            --j;
+        } while (j > low && compare_(old, ary[j - 1]));
+        ary[j] = std::move(old);
+        Instrumentation::count_moves(i - j + 2);
+    }
+}
+
+template <typename T, typename Compare>
+void QuickSorter<T, Compare>::sort_between_indexes(std::span<T> ary, int low, int high) const
+{
+    Instrumentation::RecursionScope recursion;
+    /* Recurse into the smaller side and loop on the larger one so sorted
+     * input, which always leaves one side empty, cannot overflow the stack. */
+    while (high - low >= small_size_)
+    {
+        int pivot_index = partition(ary, low, high);
+        if (pivot_index - low < high - pivot_index)
+        {
+            sort_between_indexes(ary, low, pivot_index-1);
+            low = pivot_index+1;
+        }
+        else
+        {
+            sort_between_indexes(ary, pivot_index+1, high);
+            high = pivot_index-1;
+        }
+    }
+    if (low < high)
+    {
+        insertion_sort(ary, low, high);
+    }
+}
+
+template <typename T, typename Compare>
+void QuickSorter<T, Compare>::sort(std::span<T> ary) const
+{
+    sort_between_indexes(ary, 0, ary.size()-1);
+}
@@ -0,0 +1,428 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include "common.h"
+#include "thread_pool.h"
+#include "managed_dynamic_array.h"
+#pragma once
+
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @class RadixSorter
+ * @brief Implements a least-significant-digit radix sort for integral types.
+ *
+ * @tparam T A 32- or 64-bit signed or unsigned integer type.
+ * @tparam Compare std::less<T> for ascending order or std::greater<T> for descending order.
+ *
+ * Keys are distributed by 11-bit digits, so 32-bit keys take three passes and
+ * 64-bit keys take six. The sign bit of signed keys is flipped so negative values
+ * order before positive ones, and every bit of the key is flipped for descending
+ * order. The histograms for every pass are counted in a
+ * single read of the input, and a pass is skipped when every key has the same
+ * digit in it. Each pass scatters the elements between the array and one scratch
+ * buffer, so a sort does one allocation and no comparisons.
+ */
+class RadixSorter : public Sorter<T>
+{
+    static_assert(std::is_integral_v<T>, "RadixSorter only sorts integral types");
+    static_assert(std::is_same_v<Compare, std::less<T>> || std::is_same_v<Compare, std::greater<T>>,
+        "RadixSorter only sorts in ascending or descending order");
+
+protected:
+    /// true if the keys are sorted from largest to smallest.
+    static constexpr bool DESCENDING = std::is_same_v<Compare, std::greater<T>>;
+
+    /// The unsigned type the digits of a key are taken from.
+    using Key = std::make_unsigned_t<T>;
+
+    /// Number of bits in each digit.
+    static constexpr int DIGIT_BITS = 11;
+
+    /// Number of distinct digit values, and so the number of buckets per pass.
+    static constexpr int NUM_BUCKETS = 1 << DIGIT_BITS;
+
+    /// Number of passes needed to cover every bit of a key.
+    static constexpr int NUM_PASSES = (sizeof(T) * 8 + DIGIT_BITS - 1) / DIGIT_BITS;
+
+    /**
+     * @brief Returns the digit of a value used in the given pass.
+     *
+     * @param value The value to take the digit from.
+     * @param pass The pass number, starting from the least significant digit.
+     * @return The digit, in the range [0, NUM_BUCKETS).
+     */
+    static int digit(T value, int pass);
+
+    /**
+     * @brief Adds the digit counts of every pass for the given elements to a set of histograms.
+     *
+     * @param ary The elements to count.
+     * @param histograms NUM_PASSES consecutive histograms of NUM_BUCKETS counters each.
+     */
+    static void count_digits(std::span<const T> ary, std::span<int> histograms);
+
+    /**
+     * @brief Constructs a RadixSorter object with the given name.
+     *
+     * @param name The name to assign to the sorter.
+     */
+    RadixSorter(const char * name) : Sorter<T>(name) {}
+
+public:
+    /**
+     * @brief Constructs a RadixSorter object with the name "Radix".
+     */
+    RadixSorter() : Sorter<T>("Radix") {}
+
+    /**
+     * @brief Sorts the given array in-place.
+     *
+     * This function overrides the base class sort method and sorts the elements
+     * of the provided std::span<T> in the order given by Compare.
+     *
+     * @param ary A std::span<T> representing the array to be sorted.
+     */
+    void sort(std::span<T> ary) const override;
+
+    /**
+     * @brief Returns the order in which sort() touches the elements of the array.
+     *
+     * @return AccessPattern::SEQUENTIAL, since every pass reads the whole array from front to back.
+     */
+    AccessPattern access_pattern() const override
+    {
+        return AccessPattern::SEQUENTIAL;
+    }
+
+    /**
+     * @brief Sorts an array of keys in-place and moves a parallel array of values in lockstep.
+     *
+     * Each pass scatters the value at the same position its key goes to, so the
+     * values are never compared and equal keys keep their values in the original
+     * order.
+     *
+     * @tparam V The type of the values, std::uint32_t or std::uint64_t.
+     * @param keys The keys to sort.
+     * @param values The values to reorder along with @p keys.
+     * @throws std::runtime_error If @p values is not the same size as @p keys.
+     */
+    template <typename V>
+    void sort_pairs(std::span<T> keys, std::span<V> values) const;
+};
+
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @class ParallelRadixSorter
+ * @brief Implements a multi-threaded least-significant-digit radix sort for integral types.
+ *
+ * @tparam T A 32- or 64-bit signed or unsigned integer type.
+ * @tparam Compare std::less<T> for ascending order or std::greater<T> for descending order.
+ *
+ * The array is divided into one contiguous chunk per thread. In each pass every
+ * thread counts the digits of its own chunk into a private histogram. The
+ * histograms are then combined, digit by digit and chunk by chunk, into the
+ * positions where each thread writes, so the threads can scatter their chunks at
+ * the same time without synchronizing and the sort stays stable.
+ */
+class ParallelRadixSorter : public RadixSorter<T, Compare>
+{
+    /// Arrays smaller than this are not worth splitting between threads.
+    static constexpr int PARALLEL_RADIX_THRESHOLD = 1 << 16;
+
+    /// The pool the per-chunk counting and scattering tasks are forked onto.
+    std::unique_ptr<ThreadPool> pool_;
+
+public:
+    /**
+     * @brief Constructs a ParallelRadixSorter object with the name "Parallel Radix".
+     *
+     * @param num_threads Number of threads to sort with, including the calling thread.
+     * Zero or less uses the number of hardware threads.
+     */
+    ParallelRadixSorter(int num_threads = 0);
+
+    /**
+     * @brief Returns the number of threads used to sort, including the calling thread.
+     *
+     * @return The number of threads.
+     */
+    int num_threads() const;
+
+    /**
+     * @brief Sorts the given array in-place.
+     *
+     * This function overrides the base class sort method and sorts the elements
+     * of the provided std::span<T> in the order given by Compare.
+     *
+     * @param ary A std::span<T> representing the array to be sorted.
+     */
+    void sort(std::span<T> ary) const override;
+};
+
+template <typename T, typename Compare>
+int RadixSorter<T, Compare>::digit(T value, int pass)
+{
+    /* Flipping the sign bit maps the most negative value to zero and the
+     * most positive to the largest key, so signed keys sort as unsigned.
+     * Flipping every other bit as well reverses the order. */
+    const Key SIGN_FLIP = std::is_signed_v<T> ? Key(1) << (sizeof(T) * 8 - 1) : Key(0);
+    const Key FLIP = DESCENDING ? Key(~SIGN_FLIP) : SIGN_FLIP;
+    Key key = static_cast<Key>(value) ^ FLIP;
+    return static_cast<int>((key >> (pass * DIGIT_BITS)) & (NUM_BUCKETS - 1));
+}
+
+template <typename T, typename Compare>
+void RadixSorter<T, Compare>::count_digits(std::span<const T> ary, std::span<int> histograms)
+{
+    for (T value : ary)
+    {
+        for (int pass = 0; pass < NUM_PASSES; ++pass)
+        {
+            ++histograms[pass * NUM_BUCKETS + digit(value, pass)];
+        }
+    }
+}
+
+template <typename T, typename Compare>
+void RadixSorter<T, Compare>::sort(std::span<T> ary) const
+{
+    int count = ary.size();
+    if (count < 2)
+    {
+        return;
+    }
+
+    ManagedDynamicArray<int> histograms(NUM_PASSES * NUM_BUCKETS);
+    auto hist_span = histograms.to_span();
+    std::fill(hist_span.begin(), hist_span.end(), 0);
+    count_digits(ary, hist_span);
+
+    ManagedDynamicArray<T> scratch(count);
+    std::span<T> src = ary;
+    std::span<T> dst = scratch.to_span();
+    for (int pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        auto histogram = hist_span.subspan(pass * NUM_BUCKETS, NUM_BUCKETS);
+        if (histogram[digit(src[0], pass)] == count)
+        {
+            // Every key has the same digit, so the pass would not move anything.
+            continue;
+        }
+
+        // Turn the counts into the index where each bucket starts.
+        int offset = 0;
+        for (int & bucket : histogram)
+        {
+            int bucket_count = bucket;
+            bucket = offset;
+            offset += bucket_count;
+        }
+        for (T value : src)
+        {
+            dst[histogram[digit(value, pass)]++] = value;
+        }
+        Instrumentation::count_moves(count);
+        std::swap(src, dst);
+    }
+
+    if (src.data() != ary.data())
+    {
+        std::copy(src.begin(), src.end(), ary.begin());
+        Instrumentation::count_moves(count);
+    }
+}
+
+template <typename T, typename Compare>
+template <typename V>
+void RadixSorter<T, Compare>::sort_pairs(std::span<T> keys, std::span<V> values) const
+{
+    int count = keys.size();
+    if (static_cast<int>(values.size()) != count)
+    {
+        throw std::runtime_error("Values must hold " + std::to_string(count) + " elements to sort alongside the keys");
+    }
+    if (count < 2)
+    {
+        return;
+    }
+
+    ManagedDynamicArray<int> histograms(NUM_PASSES * NUM_BUCKETS);
+    auto hist_span = histograms.to_span();
+    std::fill(hist_span.begin(), hist_span.end(), 0);
+    count_digits(keys, hist_span);
+
+    ManagedDynamicArray<T> key_scratch(count);
+    ManagedDynamicArray<V> value_scratch(count);
+    std::span<T> src = keys;
+    std::span<T> dst = key_scratch.to_span();
+    std::span<V> src_values = values;
+    std::span<V> dst_values = value_scratch.to_span();
+    for (int pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        auto histogram = hist_span.subspan(pass * NUM_BUCKETS, NUM_BUCKETS);
+        if (histogram[digit(src[0], pass)] == count)
+        {
+            continue;
+        }
+
+        int offset = 0;
+        for (int & bucket : histogram)
+        {
+            int bucket_count = bucket;
+            bucket = offset;
+            offset += bucket_count;
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            int position = histogram[digit(src[i], pass)]++;
+            dst[position] = src[i];
+            dst_values[position] = std::move(src_values[i]);
+        }
+        Instrumentation::count_moves(count);
+        std::swap(src, dst);
+        std::swap(src_values, dst_values);
+    }
+
+    if (src.data() != keys.data())
+    {
+        std::copy(src.begin(), src.end(), keys.begin());
+        std::move(src_values.begin(), src_values.end(), values.begin());
+        Instrumentation::count_moves(count);
+    }
+}
+
+template <typename T, typename Compare>
+ParallelRadixSorter<T, Compare>::ParallelRadixSorter(int num_threads)
+    : RadixSorter<T, Compare>("Parallel Radix")
+{
+    if (num_threads <= 0)
+    {
+        num_threads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+    }
+    // The thread calling sort() helps while it waits, so it counts as one of the threads.
+    pool_ = std::make_unique<ThreadPool>(num_threads - 1);
+}
+
+template <typename T, typename Compare>
+int ParallelRadixSorter<T, Compare>::num_threads() const
+{
+    return pool_->num_threads() + 1;
+}
+
+template <typename T, typename Compare>
+void ParallelRadixSorter<T, Compare>::sort(std::span<T> ary) const
+{
+    const int NUM_PASSES = RadixSorter<T, Compare>::NUM_PASSES;
+    const int NUM_BUCKETS = RadixSorter<T, Compare>::NUM_BUCKETS;
+    int count = ary.size();
+    int num_chunks = num_threads();
+    if (count < PARALLEL_RADIX_THRESHOLD || num_chunks == 1)
+    {
+        RadixSorter<T, Compare>::sort(ary);
+        return;
+    }
+
+    // Spreading the remainder over the chunks keeps every start within the array, however many threads there are.
+    auto chunk_of = [&](std::span<T> span, int chunk)
+    {
+        int start = static_cast<std::int64_t>(count) * chunk / num_chunks;
+        int end = static_cast<std::int64_t>(count) * (chunk + 1) / num_chunks;
+        return span.subspan(start, end - start);
+    };
+    auto for_each_chunk = [&](auto body)
+    {
+        TaskGroup group(*pool_);
+        for (int chunk = 1; chunk < num_chunks; ++chunk)
+        {
+            group.run([&body, chunk] { body(chunk); });
+        }
+        body(0);
+        group.wait();
+    };
+
+    /* Each chunk owns NUM_PASSES consecutive histograms. The first read counts
+     * every pass at once, which is enough to find the passes that can be
+     * skipped and also gives the counts for the first pass that is not. */
+    const int CHUNK_STRIDE = NUM_PASSES * NUM_BUCKETS;
+    ManagedDynamicArray<int> histograms(num_chunks * CHUNK_STRIDE);
+    auto hist_span = histograms.to_span();
+    std::fill(hist_span.begin(), hist_span.end(), 0);
+    for_each_chunk([&](int chunk)
+    {
+        RadixSorter<T, Compare>::count_digits(chunk_of(ary, chunk), hist_span.subspan(chunk * CHUNK_STRIDE, CHUNK_STRIDE));
+    });
+
+    ManagedDynamicArray<T> scratch(count);
+    std::span<T> src = ary;
+    std::span<T> dst = scratch.to_span();
+    bool counts_current = true;
+    for (int pass = 0; pass < NUM_PASSES; ++pass)
+    {
+        auto histogram_of = [&](int chunk)
+        {
+            return hist_span.subspan(chunk * CHUNK_STRIDE + pass * NUM_BUCKETS, NUM_BUCKETS);
+        };
+        int first_digit = RadixSorter<T, Compare>::digit(src[0], pass);
+        int first_digit_count = 0;
+        for (int chunk = 0; chunk < num_chunks; ++chunk)
+        {
+            first_digit_count += histogram_of(chunk)[first_digit];
+        }
+        if (first_digit_count == count)
+        {
+            continue;
+        }
+
+        // An earlier pass moved elements between chunks, so count this digit again.
+        if (!counts_current)
+        {
+            for_each_chunk([&](int chunk)
+            {
+                auto histogram = histogram_of(chunk);
+                std::fill(histogram.begin(), histogram.end(), 0);
+                for (T value : chunk_of(src, chunk))
+                {
+                    ++histogram[RadixSorter<T, Compare>::digit(value, pass)];
+                }
+            });
+        }
+
+        /* Lay the buckets out digit by digit and, within a digit, chunk by
+         * chunk so each thread writes to its own positions in order. */
+        int offset = 0;
+        for (int bucket = 0; bucket < NUM_BUCKETS; ++bucket)
+        {
+            for (int chunk = 0; chunk < num_chunks; ++chunk)
+            {
+                int & slot = histogram_of(chunk)[bucket];
+                int bucket_count = slot;
+                slot = offset;
+                offset += bucket_count;
+            }
+        }
+        for_each_chunk([&](int chunk)
+        {
+            auto histogram = histogram_of(chunk);
+            for (T value : chunk_of(src, chunk))
+            {
+                dst[histogram[RadixSorter<T, Compare>::digit(value, pass)]++] = value;
+            }
+        });
+        Instrumentation::count_moves(count);
+        std::swap(src, dst);
+        counts_current = false;
+    }
+
+    if (src.data() != ary.data())
+    {
+        std::copy(src.begin(), src.end(), ary.begin());
+        Instrumentation::count_moves(count);
+    }
+}
@@ -0,0 +1,47 @@
+#include <compare>
+#include <cstdint>
+#pragma once
+
+/**
+ * @struct Record
+ * @brief A 128-byte record ordered by a 64-bit key, standing in for real payloads.
+ *
+ * The key is followed by an opaque payload that is carried along when records are
+ * moved. Comparisons only look at the key, so records with equal keys compare equal
+ * even when their payloads differ.
+ */
+struct Record
+{
+    /// Number of bytes in the payload, which brings the record to 128 bytes.
+    static constexpr int PAYLOAD_SIZE = 120;
+
+    /// The key records are ordered by.
+    std::int64_t key;
+
+    /// Data carried along with the key.
+    unsigned char payload[PAYLOAD_SIZE];
+
+    /**
+     * @brief Orders two records by their keys.
+     *
+     * @param other The record to compare against.
+     * @return The ordering of this record's key relative to the key of @p other.
+     */
+    std::strong_ordering operator<=>(const Record & other) const
+    {
+        return key <=> other.key;
+    }
+
+    /**
+     * @brief Checks whether two records have the same key.
+     *
+     * @param other The record to compare against.
+     * @return true if the keys are equal; false otherwise.
+     */
+    bool operator==(const Record & other) const
+    {
+        return key == other.key;
+    }
+};
+
+static_assert(sizeof(Record) == 128, "Record must stay 128 bytes");
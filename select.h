@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "managed_dynamic_array.h"
+#include "pdq.h"
+#include "streaming_top_k.h"
+#pragma once
+
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @brief Rearranges an array so that the element at index k is the one a sort would put there.
+ *
+ * Every element before index k is then not ordered after it and every element after
+ * it is not ordered before it, which is all a median or a percentile needs. This is
+ * PdqSorter::select_nth(), which runs introselect on pdqsort's partitions, so it takes
+ * O(n) time even in the worst case.
+ *
+ * @tparam T The type of elements.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
+ * @param ary The array.
+ * @param k The index to settle.
+ * @param compare The comparator used to order the elements.
+ * @throws std::runtime_error If @p k is not an index of @p ary.
+ *
+ * @section Example
+ * @code
+ * select_nth(values, values.size() / 2);
+ * int median = values[values.size() / 2];
+ * @endcode
+ */
+void select_nth(std::span<T> ary, int k, Compare compare = Compare());
+
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @brief Moves the first k elements in Compare order to the front of an array, in order.
+ *
+ * Takes O(n + k log k) time, against O(n log n) for sorting the whole array. The
+ * order of the rest of the array is unspecified.
+ *
+ * @tparam T The type of elements.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
+ * @param ary The array.
+ * @param k The number of elements to sort, from 0 to the size of @p ary.
+ * @param compare The comparator used to order the elements.
+ * @throws std::runtime_error If @p k is out of range.
+ */
+void partial_sort(std::span<T> ary, int k, Compare compare = Compare());
+
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @brief Returns the first k elements in Compare order, in order, leaving the input untouched.
+ *
+ * The elements are fed once through a StreamingTopK, whose bounded heap of k
+ * elements has the worst of them on top, so the result is the k smallest for the
+ * default ascending order or the k largest for std::greater<T>. An element only
+ * enters the heap if it beats the top, so when k is much smaller than n nearly
+ * every element costs a single comparison, or less where SIMD applies, and the
+ * worst case is O(n log k) with only k elements of extra space.
+ *
+ * @tparam T The type of elements, which must be default constructible.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
+ * @param values The elements to choose from.
+ * @param k The number of elements to return. Fewer are returned if there are fewer values.
+ * @param compare The comparator used to order the elements.
+ * @return The chosen elements in Compare order.
+ * @throws std::runtime_error If @p k is negative.
+ *
+ * @section Example
+ * @code
+ * auto best = top_k<int, std::greater<int>>(scores, 100);
+ * @endcode
+ */
+ManagedDynamicArray<T> top_k(std::span<const std::type_identity_t<T>> values, int k, Compare compare = Compare());
+
+template <typename T, typename Compare>
+void select_nth(std::span<T> ary, int k, Compare compare)
+{
+    PdqSorter<T, Compare>(compare).select_nth(ary, k);
+}
+
+template <typename T, typename Compare>
+void partial_sort(std::span<T> ary, int k, Compare compare)
+{
+    PdqSorter<T, Compare>(compare).partial_sort(ary, k);
+}
+
+template <typename T, typename Compare>
+ManagedDynamicArray<T> top_k(std::span<const std::type_identity_t<T>> values, int k, Compare compare)
+{
+    if (k < 0)
+    {
+        throw std::runtime_error("Cannot keep " + std::to_string(k) + " elements");
+    }
+    StreamingTopK<T, Compare> kept(std::min(k, static_cast<int>(values.size())), compare);
+    kept.add(values);
+    return kept.snapshot();
+}
@@ -1,13 +1,15 @@
+#include <functional>
 #include <span>
 #include "common.h"
 #pragma once
 
-template <typename T>
+template <typename T, typename Compare = std::less<T>>
 /**
  * @class SelectionSorter
  * @brief Implements the selection sort algorithm for sorting arrays.
  * 
  * @tparam T The type of elements to sort.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y.
  *
  * This class derives from the Sorter base class and provides an implementation
  * of the selection sort algorithm. It overrides the sort() method to perform
@@ -17,22 +19,53 @@ template <typename T>
  */
 class SelectionSorter : public Sorter<T>
 {
+    /// Orders the elements.
+    [[no_unique_address]] InstrumentedCompare<Compare> compare_;
+
 public:
     /**
      * @brief Constructs a SelectionSorter object with the name "Selection Sort".
      *
      * This constructor initializes the base Sorter class with the algorithm name,
      * allowing identification and usage of the selection sort algorithm.
+     *
+     * @param compare The comparator used to order the elements.
      */
-    SelectionSorter() : Sorter<T>("Selection Sort") {}
+    SelectionSorter(Compare compare = Compare()) : Sorter<T>("Selection Sort"), compare_(compare) {}
 
     /**
      * @brief Sorts the given array in-place.
      *
      * This function overrides the base class sort method and sorts the elements
-     * of the provided std::span<T> in ascending order.
+     * of the provided std::span<T> in the order given by Compare.
      *
      * @param ary Reference to a std::span<T> representing the array to be sorted.
      */
     void sort(std::span<T> ary) const override;
 };
+
+template <typename T, typename Compare>
+void SelectionSorter<T, Compare>::sort(std::span<T> ary) const
+{
+    int count = ary.size();
+    if (count < 2)
+    {
+        return;
+    }
+    
+    for (int i = 0; i < (count - 1); ++i)
+    {
+        int min_idx = i;
+        for (int j = i + 1; j < count; ++j)
+        {
+            if (compare_(ary[j], ary[min_idx]))
+            {
+                min_idx = j;
+            }
+        }
+        if (i != min_idx)
+        {
+            this->swap_values(ary, i, min_idx);
+        }
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+/* Building blocks for sorting and merging 32-bit ints held in AVX2 registers
+ * with bitonic networks. Each register holds 8 lanes. The functions are
+ * compiled for AVX2 regardless of the flags the rest of the program is built
+ * with, so callers must check cpu_supports_avx2() before using them. */
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CPPSORT_HAVE_AVX2_KERNELS 1
+#include <immintrin.h>
+#define CPPSORT_TARGET_AVX2 __attribute__((target("avx2")))
+
+/**
+ * @brief Compare-exchanges every lane with its partner, keeping the larger value
+ * in the lanes selected by MAX_LANES and the smaller value in the others.
+ *
+ * @tparam MAX_LANES Bit mask of the lanes that receive the larger value.
+ * @param v The register being sorted.
+ * @param partner @p v with every lane moved to the position of its partner.
+ * @return The register after the compare-exchange.
+ */
+template <int MAX_LANES>
+CPPSORT_TARGET_AVX2 inline __m256i avx2_compare_exchange(__m256i v, __m256i partner)
+{
+    return _mm256_blend_epi32(_mm256_min_epi32(v, partner), _mm256_max_epi32(v, partner), MAX_LANES);
+}
+
+/**
+ * @brief Reverses the order of the lanes in a register.
+ */
+CPPSORT_TARGET_AVX2 inline __m256i avx2_reverse(__m256i v)
+{
+    return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+}
+
+/**
+ * @brief Sorts a register whose lanes form a bitonic sequence into ascending order.
+ *
+ * Compares lanes 4, 2 and then 1 apart, which is the last half of a bitonic sort.
+ */
+CPPSORT_TARGET_AVX2 inline __m256i avx2_bitonic_clean(__m256i v)
+{
+    v = avx2_compare_exchange<0xF0>(v, _mm256_permute2x128_si256(v, v, 0x01));
+    v = avx2_compare_exchange<0xCC>(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = avx2_compare_exchange<0xAA>(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return v;
+}
+
+/**
+ * @brief Sorts the 8 lanes of a register into ascending order with a bitonic sorting network.
+ */
+CPPSORT_TARGET_AVX2 inline __m256i avx2_sort8(__m256i v)
+{
+    /* Build sorted pairs, then sorted quads, in alternating directions so
+     * each stage hands the next one bitonic sequences. */
+    v = avx2_compare_exchange<0x66>(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = avx2_compare_exchange<0x3C>(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = avx2_compare_exchange<0x5A>(v, _mm256_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return avx2_bitonic_clean(v);
+}
+
+/**
+ * @brief Merges two sorted registers so that @p lo holds the 8 smallest values and
+ * @p hi the 8 largest, both in ascending order.
+ */
+CPPSORT_TARGET_AVX2 inline void avx2_merge8(__m256i & lo, __m256i & hi)
+{
+    __m256i reversed = avx2_reverse(hi);
+    __m256i mins = _mm256_min_epi32(lo, reversed);
+    __m256i maxs = _mm256_max_epi32(lo, reversed);
+    lo = avx2_bitonic_clean(mins);
+    hi = avx2_bitonic_clean(maxs);
+}
+
+/**
+ * @brief Merges two sorted runs of registers into one sorted run.
+ *
+ * The first half of @p regs holds one ascending run and the second half another.
+ * Reversing the second run makes the whole sequence bitonic, which is then sorted
+ * by compare-exchanging registers half the run apart, a quarter apart and so on,
+ * before finishing each register on its own.
+ *
+ * @param regs The registers, which are sorted in place.
+ * @param num_regs The number of registers, a power of two no less than 2.
+ */
+CPPSORT_TARGET_AVX2 inline void avx2_merge_registers(__m256i * regs, int num_regs)
+{
+    int half = num_regs / 2;
+    for (int i = 0; i < half / 2; ++i)
+    {
+        __m256i temp = regs[half + i];
+        regs[half + i] = regs[num_regs - 1 - i];
+        regs[num_regs - 1 - i] = temp;
+    }
+    for (int i = half; i < num_regs; ++i)
+    {
+        regs[i] = avx2_reverse(regs[i]);
+    }
+    for (int distance = half; distance > 0; distance /= 2)
+    {
+        for (int i = 0; i < num_regs; ++i)
+        {
+            if ((i & distance) == 0)
+            {
+                __m256i mins = _mm256_min_epi32(regs[i], regs[i + distance]);
+                regs[i + distance] = _mm256_max_epi32(regs[i], regs[i + distance]);
+                regs[i] = mins;
+            }
+        }
+    }
+    for (int i = 0; i < num_regs; ++i)
+    {
+        regs[i] = avx2_bitonic_clean(regs[i]);
+    }
+}
+#endif
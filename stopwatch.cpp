@@ -3,13 +3,19 @@
 
 Stopwatch::Stopwatch()
 {
-    start_ = clock();
+    start_ = std::chrono::steady_clock::now();
 }
 
 int Stopwatch::elapsed_milliseconds() const
 {
-    double diff = clock() - start_;
-    const int MILLISECS_PER_SEC = 1000;
-    int elapsed_milliseconds = round(diff / CLOCKS_PER_SEC * MILLISECS_PER_SEC);
+    double diff = elapsed_nanoseconds();
+    const int NANOSECS_PER_MILLISEC = 1000000;
+    int elapsed_milliseconds = round(diff / NANOSECS_PER_MILLISEC);
     return elapsed_milliseconds;
-}
\ No newline at end of file
+}
+
+std::int64_t Stopwatch::elapsed_nanoseconds() const
+{
+    auto elapsed = std::chrono::steady_clock::now() - start_;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
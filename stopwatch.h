@@ -1,12 +1,15 @@
-#include <ctime>
+#include <chrono>
+#include <cstdint>
 #pragma once
 
 /**
  * @class Stopwatch
  * @brief A simple stopwatch utility for measuring elapsed time.
  *
- * This class provides functionality to measure the elapsed time in milliseconds
- * since the stopwatch was started. It uses the standard C++ <ctime> library.
+ * This class provides functionality to measure the wall-clock time elapsed
+ * since the stopwatch was started. It uses std::chrono::steady_clock, so the
+ * time of multi-threaded sorts and of waiting on files is counted as it passes
+ * rather than as the processor time summed over every thread.
  *
  * Usage:
  *   Stopwatch sw;
@@ -16,9 +19,9 @@
 class Stopwatch
 {
 private:
-    /// Stores the processor time at which the stopwatch was started.
-    /// This value is obtained from std::clock() and is used to measure elapsed CPU time.
-    std::clock_t start_;
+    /// Stores the time at which the stopwatch was started.
+    /// This value is obtained from std::chrono::steady_clock, which never goes backwards.
+    std::chrono::steady_clock::time_point start_;
 
 public:
     /**
@@ -30,4 +33,7 @@ public:
     /// @brief Returns the elapsed time in milliseconds since the stopwatch was started or last reset.
     /// @return The number of milliseconds elapsed as an integer.
     int elapsed_milliseconds() const;
-};
\ No newline at end of file
+    /// @brief Returns the elapsed time in nanoseconds since the stopwatch was started or last reset.
+    /// @return The number of nanoseconds elapsed.
+    std::int64_t elapsed_nanoseconds() const;
+};
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include "streaming_top_k.h"
+#include "cpu_features.h"
+#include "simd_bitonic.h"
+
+template <typename T, typename Compare>
+/**
+ * @brief Finds the first value in a range that beats a threshold, one comparison at a time.
+ */
+static int scalar_find_candidate(const T * values, int begin, int end, const T & threshold)
+{
+    Compare compare;
+    while (begin < end && !compare(values[begin], threshold))
+    {
+        ++begin;
+    }
+    return begin;
+}
+
+#ifdef CPPSORT_HAVE_AVX2_KERNELS
+template <bool DESCENDING>
+/**
+ * @brief Finds the first int in a range that beats a threshold, 8 at a time.
+ */
+CPPSORT_TARGET_AVX2 static int avx2_find_candidate(const int * values, int begin, int end, const int & threshold)
+{
+    __m256i limit = _mm256_set1_epi32(threshold);
+    for (; begin + 8 <= end; begin += 8)
+    {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + begin));
+        __m256i beats = DESCENDING ? _mm256_cmpgt_epi32(block, limit) : _mm256_cmpgt_epi32(limit, block);
+        unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(beats));
+        if (mask != 0)
+        {
+            return begin + std::countr_zero(mask);
+        }
+    }
+    return scalar_find_candidate<int, std::conditional_t<DESCENDING, std::greater<int>, std::less<int>>>(
+        values, begin, end, threshold);
+}
+
+template <bool DESCENDING>
+/**
+ * @brief Finds the first 64-bit int in a range that beats a threshold, 4 at a time.
+ */
+CPPSORT_TARGET_AVX2 static int avx2_find_candidate(const std::int64_t * values, int begin, int end,
+    const std::int64_t & threshold)
+{
+    __m256i limit = _mm256_set1_epi64x(threshold);
+    for (; begin + 4 <= end; begin += 4)
+    {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + begin));
+        __m256i beats = DESCENDING ? _mm256_cmpgt_epi64(block, limit) : _mm256_cmpgt_epi64(limit, block);
+        unsigned mask = _mm256_movemask_pd(_mm256_castsi256_pd(beats));
+        if (mask != 0)
+        {
+            return begin + std::countr_zero(mask);
+        }
+    }
+    return scalar_find_candidate<std::int64_t,
+        std::conditional_t<DESCENDING, std::greater<std::int64_t>, std::less<std::int64_t>>>(values, begin, end, threshold);
+}
+
+template <bool DESCENDING>
+/**
+ * @brief Finds the first double in a range that beats a threshold, 4 at a time.
+ *
+ * The ordered comparisons are false for NaN, as the scalar ones are, so NaN never beats the threshold.
+ */
+CPPSORT_TARGET_AVX2 static int avx2_find_candidate(const double * values, int begin, int end, const double & threshold)
+{
+    __m256d limit = _mm256_set1_pd(threshold);
+    for (; begin + 4 <= end; begin += 4)
+    {
+        __m256d block = _mm256_loadu_pd(values + begin);
+        unsigned mask = _mm256_movemask_pd(_mm256_cmp_pd(block, limit, DESCENDING ? _CMP_GT_OQ : _CMP_LT_OQ));
+        if (mask != 0)
+        {
+            return begin + std::countr_zero(mask);
+        }
+    }
+    return scalar_find_candidate<double, std::conditional_t<DESCENDING, std::greater<double>, std::less<double>>>(
+        values, begin, end, threshold);
+}
+#endif
+
+template <typename T>
+CandidateScan<T> avx2_candidate_scan([[maybe_unused]] bool descending)
+{
+#ifdef CPPSORT_HAVE_AVX2_KERNELS
+    if (cpu_supports_avx2())
+    {
+        if (descending)
+        {
+            return avx2_find_candidate<true>;
+        }
+        return avx2_find_candidate<false>;
+    }
+#endif
+    return nullptr;
+}
+
+template CandidateScan<int> avx2_candidate_scan<int>(bool);
+template CandidateScan<std::int64_t> avx2_candidate_scan<std::int64_t>(bool);
+template CandidateScan<double> avx2_candidate_scan<double>(bool);
@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <span>
+#include <type_traits>
+#include "heap.h"
+#include "instrumentation.h"
+#include "managed_dynamic_array.h"
+#include "pdq.h"
+#pragma once
+
+/**
+ * @brief A function that finds the first value in a range that beats a threshold.
+ *
+ * @tparam T The type of the values.
+ *
+ * Returns the index of the first of values[begin], ..., values[end - 1] that is
+ * ordered strictly before @p threshold, or @p end if there is none.
+ */
+template <typename T>
+using CandidateScan = int (*)(const T * values, int begin, int end, const T & threshold);
+
+template <typename T>
+/**
+ * @brief Returns the AVX2 candidate scan for T, which must be int, std::int64_t or double.
+ *
+ * It is kept out of the header so the AVX2 code and the processor check are only
+ * compiled once, in streaming_top_k.cpp, which instantiates it for those three types.
+ *
+ * @param descending true to find values greater than the threshold, false to find values less than it.
+ * @return The scan, or nullptr if the build or the running processor lacks AVX2.
+ */
+CandidateScan<T> avx2_candidate_scan(bool descending);
+
+template <typename T, typename Compare>
+/**
+ * @brief Returns the SIMD candidate scan for T and Compare, if the type and processor allow one.
+ *
+ * @return The scan, or nullptr if values have to be compared one at a time with Compare.
+ */
+CandidateScan<T> select_candidate_scan();
+
+template <typename T, typename Compare = std::less<T>>
+/**
+ * @class StreamingTopK
+ * @brief Keeps the first k values in Compare order out of a stream that never has to end.
+ *
+ * @tparam T The type of the values, which must be default constructible.
+ * @tparam Compare A function object where Compare(x, y) is true if x belongs before y. std::less<T>
+ * keeps the k smallest values and std::greater<T> the k largest.
+ *
+ * The values kept are held in a bounded heap whose top is the worst of them, the
+ * one Compare puts last. Once the heap is full its top is the threshold a new
+ * value has to beat, and a value that does replaces the top in a single sift.
+ * Memory is O(k) however many values go by.
+ *
+ * Batches are scanned for the next value that beats the threshold. For ints,
+ * 64-bit ints and doubles on processors with AVX2, the scan compares a whole
+ * register of values with the threshold at once, so the values that are rejected,
+ * which are nearly all of them once the heap has filled, never touch the heap
+ * and cost a fraction of a comparison each, when ordered by std::less or
+ * std::greater. Everything else compares one value at a time, which is still a
+ * single comparison per rejected value.
+ *
+ * @section Example
+ * @code
+ * StreamingTopK<int, std::greater<int>> best(100);
+ * while (read_batch(batch))
+ * {
+ *     best.add(batch);
+ * }
+ * auto leaders = best.snapshot();
+ * @endcode
+ */
+class StreamingTopK
+{
+    /**
+     * @struct WorstFirst
+     * @brief Orders the values kept in reverse, so the heap's top is the first to be evicted.
+     */
+    struct WorstFirst
+    {
+        /// The order the values are kept in.
+        [[no_unique_address]] Compare compare;
+
+        /// Returns true if @p x belongs after @p y.
+        bool operator()(const T & x, const T & y) const
+        {
+            return compare(y, x);
+        }
+    };
+
+    /// The heap whose top is the worst value kept, the first to be evicted.
+    using BoundedHeap = Heap<T, WorstFirst>;
+
+    /// Number of values to keep.
+    int capacity_;
+
+    /// Number of values offered so far.
+    std::int64_t seen_;
+
+    /// The values kept.
+    BoundedHeap heap_;
+
+    /// Finds the next value that beats the threshold with SIMD, or nullptr to compare one value at a time.
+    CandidateScan<T> scan_;
+
+    /// Orders the values. Its comparisons are counted by hand, so it can also order a fresh heap in clear().
+    [[no_unique_address]] Compare compare_;
+
+    /**
+     * @brief Finds the first value from an index on that beats a threshold, one comparison at a time.
+     *
+     * @param values The values to search.
+     * @param begin The index to start at.
+     * @param threshold The value to beat.
+     * @return The index of the value, or the size of @p values if there is none.
+     */
+    int find_candidate(std::span<const T> values, int begin, const T & threshold) const;
+
+public:
+    /**
+     * @brief Constructs an accumulator that keeps up to k values.
+     *
+     * @param k Number of values to keep.
+     * @param compare The comparator used to order the values.
+     * @throws std::runtime_error If @p k is negative.
+     */
+    explicit StreamingTopK(int k, Compare compare = Compare());
+
+    /**
+     * @brief Returns the number of values kept once enough have been offered.
+     *
+     * @return k.
+     */
+    int capacity() const;
+
+    /**
+     * @brief Returns the number of values kept now.
+     *
+     * @return The smaller of k and the number of values offered.
+     */
+    int size() const;
+
+    /**
+     * @brief Returns the number of values offered so far.
+     *
+     * @return The number of values.
+     */
+    std::int64_t seen() const;
+
+    /**
+     * @brief Returns the value a new one has to beat to be kept.
+     *
+     * @return The worst value kept if k values are kept; std::nullopt while any value would be kept.
+     */
+    std::optional<T> threshold() const;
+
+    /**
+     * @brief Offers a value.
+     *
+     * @param value The value, which is copied if it is kept.
+     */
+    void add(const T & value);
+
+    /**
+     * @brief Offers a batch of values.
+     *
+     * @param values The values, which are copied if they are kept.
+     */
+    void add(std::span<const T> values);
+
+    /**
+     * @brief Returns the values kept so far, in Compare order, without disturbing the accumulator.
+     *
+     * Copies the heap and sorts the copy, which takes O(k log k) time.
+     *
+     * @return The values kept.
+     */
+    ManagedDynamicArray<T> snapshot() const;
+
+    /**
+     * @brief Forgets every value kept and offered, so the accumulator can start a new window.
+     */
+    void clear();
+};
+
+template <typename T, typename Compare>
+CandidateScan<T> select_candidate_scan()
+{
+    // The registers compare with the built-in operators, so only the standard orders can use them.
+    if constexpr ((std::is_same_v<T, int> || std::is_same_v<T, std::int64_t> || std::is_same_v<T, double>)
+        && (std::is_same_v<Compare, std::less<T>> || std::is_same_v<Compare, std::greater<T>>))
+    {
+        return avx2_candidate_scan<T>(std::is_same_v<Compare, std::greater<T>>);
+    }
+    else
+    {
+        return nullptr;
+    }
+}
+
+template <typename T, typename Compare>
+StreamingTopK<T, Compare>::StreamingTopK(int k, Compare compare)
+    : capacity_(k), seen_(0), heap_(k < 0 ? 0 : k, WorstFirst{compare}), scan_(select_candidate_scan<T, Compare>()),
+      compare_(compare)
+{
+    if (k < 0)
+    {
+        throw std::runtime_error("Cannot keep " + std::to_string(k) + " values");
+    }
+}
+
+template <typename T, typename Compare>
+int StreamingTopK<T, Compare>::find_candidate(std::span<const T> values, int begin, const T & threshold) const
+{
+    int count = values.size();
+    while (begin < count && !compare_(values[begin], threshold))
+    {
+        ++begin;
+    }
+    return begin;
+}
+
+template <typename T, typename Compare>
+int StreamingTopK<T, Compare>::capacity() const
+{
+    return capacity_;
+}
+
+template <typename T, typename Compare>
+int StreamingTopK<T, Compare>::size() const
+{
+    return heap_.size();
+}
+
+template <typename T, typename Compare>
+std::int64_t StreamingTopK<T, Compare>::seen() const
+{
+    return seen_;
+}
+
+template <typename T, typename Compare>
+std::optional<T> StreamingTopK<T, Compare>::threshold() const
+{
+    if (capacity_ == 0 || heap_.size() < capacity_)
+    {
+        return std::nullopt;
+    }
+    return heap_[BoundedHeap::ROOT_INDEX];
+}
+
+template <typename T, typename Compare>
+void StreamingTopK<T, Compare>::add(const T & value)
+{
+    ++seen_;
+    if (heap_.size() < capacity_)
+    {
+        heap_.store(value);
+    }
+    else if (capacity_ > 0)
+    {
+        Instrumentation::count_comparison();
+        if (compare_(value, heap_[BoundedHeap::ROOT_INDEX]))
+        {
+            heap_.replace_top(value);
+        }
+    }
+}
+
+template <typename T, typename Compare>
+void StreamingTopK<T, Compare>::add(std::span<const T> values)
+{
+    int count = values.size();
+    int i = 0;
+    while (i < count && heap_.size() < capacity_)
+    {
+        heap_.store(values[i++]);
+    }
+    if (capacity_ > 0)
+    {
+        // Every value the scan skips is no better than the current top, so it would be rejected anyway.
+        // Both scans compare through a bare Compare, so the values they look at are counted here.
+        while (i < count)
+        {
+            const T & threshold = heap_[BoundedHeap::ROOT_INDEX];
+            int candidate = scan_ ? scan_(values.data(), i, count, threshold) : find_candidate(values, i, threshold);
+            Instrumentation::count_comparisons(std::min(candidate + 1, count) - i);
+            if (candidate == count)
+            {
+                break;
+            }
+            heap_.replace_top(values[candidate]);
+            i = candidate + 1;
+        }
+    }
+    seen_ += count;
+}
+
+template <typename T, typename Compare>
+ManagedDynamicArray<T> StreamingTopK<T, Compare>::snapshot() const
+{
+    int count = heap_.size();
+    ManagedDynamicArray<T> kept(count);
+    for (int i = 0; i < count; ++i)
+    {
+        kept[i] = heap_[BoundedHeap::ROOT_INDEX + i];
+    }
+    PdqSorter<T, Compare>(compare_).sort(kept.to_span());
+    return kept;
+}
+
+template <typename T, typename Compare>
+void StreamingTopK<T, Compare>::clear()
+{
+    heap_ = BoundedHeap(capacity_, WorstFirst{compare_});
+    seen_ = 0;
+}
@@ -0,0 +1,193 @@
+#include "thread_pool.h"
+
+/* The pool that owns the calling thread, if any, and the index of the
+ * worker within it. Both are set once when a worker starts. */
+static thread_local const ThreadPool * current_pool = nullptr;
+static thread_local int current_worker = -1;
+
+ThreadPool::ThreadPool(int num_threads)
+    : num_queued_(0), stopping_(false)
+{
+    if (num_threads < 0)
+    {
+        num_threads = 0;
+    }
+    // The extra queue at the end is shared by threads outside the pool.
+    for (int i = 0; i <= num_threads; ++i)
+    {
+        queues_.push_back(std::make_unique<TaskQueue>());
+    }
+    for (int i = 0; i < num_threads; ++i)
+    {
+        workers_.emplace_back([this, i] { worker_loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto & worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+int ThreadPool::num_threads() const
+{
+    return workers_.size();
+}
+
+int ThreadPool::current_worker_index() const
+{
+    return current_pool == this ? current_worker : -1;
+}
+
+bool ThreadPool::try_pop_back(int queue_idx, std::function<void()> & task)
+{
+    TaskQueue & queue = *queues_[queue_idx];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+    {
+        return false;
+    }
+    task = std::move(queue.tasks.back());
+    queue.tasks.pop_back();
+    --num_queued_;
+    return true;
+}
+
+bool ThreadPool::try_steal_front(int queue_idx, std::function<void()> & task)
+{
+    TaskQueue & queue = *queues_[queue_idx];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+    {
+        return false;
+    }
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    --num_queued_;
+    return true;
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    int worker_idx = current_worker_index();
+    int queue_idx = worker_idx < 0 ? num_threads() : worker_idx;
+    {
+        TaskQueue & queue = *queues_[queue_idx];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        /* Incrementing under the sleep mutex means a worker checking the
+         * count before going to sleep cannot miss this task. */
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        ++num_queued_;
+    }
+    wake_.notify_one();
+}
+
+bool ThreadPool::run_pending_task()
+{
+    if (num_queued_ == 0)
+    {
+        return false;
+    }
+
+    std::function<void()> task;
+    int worker_idx = current_worker_index();
+    int shared_idx = num_threads();
+    /* Outside threads treat the shared queue as their own and take its newest
+     * task, which keeps a waiting thread working on the job it forked. */
+    bool found = worker_idx >= 0
+        ? try_pop_back(worker_idx, task) || try_steal_front(shared_idx, task)
+        : try_pop_back(shared_idx, task);
+    // Start stealing from the next worker along so thieves spread out.
+    for (int i = 1; !found && i <= shared_idx; ++i)
+    {
+        int victim = (worker_idx + i + shared_idx) % shared_idx;
+        found = victim != worker_idx && try_steal_front(victim, task);
+    }
+    if (!found)
+    {
+        return false;
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::worker_loop(int worker_idx)
+{
+    current_pool = this;
+    current_worker = worker_idx;
+    while (true)
+    {
+        if (run_pending_task())
+        {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [this] { return stopping_ || num_queued_ > 0; });
+        if (stopping_ && num_queued_ == 0)
+        {
+            return;
+        }
+    }
+}
+
+TaskGroup::~TaskGroup()
+{
+    while (num_pending_ > 0)
+    {
+        if (!pool_.run_pending_task())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void TaskGroup::run(std::function<void()> task)
+{
+    ++num_pending_;
+    pool_.submit([this, task = std::move(task)]
+    {
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(error_mutex_);
+            if (!first_error_)
+            {
+                first_error_ = std::current_exception();
+            }
+        }
+        --num_pending_;
+    });
+}
+
+void TaskGroup::wait()
+{
+    while (num_pending_ > 0)
+    {
+        if (!pool_.run_pending_task())
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(error_mutex_);
+    if (first_error_)
+    {
+        std::exception_ptr error = first_error_;
+        first_error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,186 @@
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#pragma once
+
+/**
+ * @class ThreadPool
+ * @brief A fixed-size pool of worker threads that balance load by work stealing.
+ *
+ * Every worker owns a double-ended task queue. A worker pushes the tasks it
+ * spawns onto the back of its own queue and pops from the back as well, so
+ * recently forked (and cache-warm) work runs first. When its queue runs dry it
+ * steals from the front of another worker's queue, which is where the oldest
+ * and therefore largest pieces of a divide-and-conquer job sit. Threads that
+ * are not part of the pool submit to a shared queue that every worker drains.
+ *
+ * Tasks are normally submitted through a TaskGroup, whose wait() lets the
+ * calling thread execute pending tasks instead of blocking, so a pool of n
+ * workers keeps n + 1 threads busy during a fork/join computation.
+ */
+class ThreadPool
+{
+    /**
+     * @brief A mutex-protected deque of tasks owned by one worker.
+     */
+    struct TaskQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    /// One queue per worker followed by the shared queue used by outside threads.
+    std::vector<std::unique_ptr<TaskQueue>> queues_;
+
+    /// The worker threads owned by the pool.
+    std::vector<std::thread> workers_;
+
+    /// Guards sleeping and waking idle workers.
+    std::mutex sleep_mutex_;
+
+    /// Signalled whenever a task is queued or the pool is shutting down.
+    std::condition_variable wake_;
+
+    /// Number of tasks sitting in any of the queues.
+    std::atomic<int> num_queued_;
+
+    /// Set once the destructor asks the workers to exit.
+    bool stopping_;
+
+    /**
+     * @brief Returns the queue index of the calling thread in this pool.
+     *
+     * @return The worker index, or -1 if the caller is not one of this pool's workers.
+     */
+    int current_worker_index() const;
+
+    /**
+     * @brief Removes a task from the back of the given queue.
+     *
+     * @param queue_idx Index of the queue to pop from.
+     * @param task Receives the task if one was available.
+     * @return true if a task was removed; false if the queue was empty.
+     */
+    bool try_pop_back(int queue_idx, std::function<void()> & task);
+
+    /**
+     * @brief Removes a task from the front of the given queue.
+     *
+     * @param queue_idx Index of the queue to steal from.
+     * @param task Receives the task if one was available.
+     * @return true if a task was removed; false if the queue was empty.
+     */
+    bool try_steal_front(int queue_idx, std::function<void()> & task);
+
+    /**
+     * @brief The loop run by each worker thread until the pool is destroyed.
+     *
+     * @param worker_idx Index of the worker and of the queue it owns.
+     */
+    void worker_loop(int worker_idx);
+
+public:
+    /**
+     * @brief Starts a pool with the given number of worker threads.
+     *
+     * @param num_threads Number of workers to start. Zero is allowed, in which case
+     * every task runs on whichever thread waits for it.
+     */
+    explicit ThreadPool(int num_threads);
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool & operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Stops the workers after the queued tasks have been drained.
+     */
+    ~ThreadPool();
+
+    /**
+     * @brief Returns the number of worker threads in the pool.
+     *
+     * @return The number of workers, not counting threads that help while waiting.
+     */
+    int num_threads() const;
+
+    /**
+     * @brief Queues a task for execution by the pool.
+     *
+     * Workers push onto their own queue; any other thread pushes onto the shared queue.
+     *
+     * @param task The task to run.
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * @brief Runs a single queued task on the calling thread if one is available.
+     *
+     * The caller's own queue is tried first, then the shared queue and finally the
+     * other workers' queues.
+     *
+     * @return true if a task was run; false if every queue was empty.
+     */
+    bool run_pending_task();
+};
+
+/**
+ * @class TaskGroup
+ * @brief Tracks a set of tasks forked onto a ThreadPool so they can be joined.
+ *
+ * Usage:
+ *   TaskGroup group(pool);
+ *   group.run([&] { left_half(); });
+ *   right_half();
+ *   group.wait();
+ *
+ * The first exception thrown by a task is rethrown from wait().
+ */
+class TaskGroup
+{
+    /// The pool the tasks are submitted to.
+    ThreadPool & pool_;
+
+    /// Number of tasks that have been submitted but have not finished.
+    std::atomic<int> num_pending_;
+
+    /// Guards first_error_.
+    std::mutex error_mutex_;
+
+    /// The first exception thrown by one of the tasks, if any.
+    std::exception_ptr first_error_;
+
+public:
+    /**
+     * @brief Constructs an empty group of tasks for the given pool.
+     *
+     * @param pool The pool the tasks will run on.
+     */
+    explicit TaskGroup(ThreadPool & pool) : pool_(pool), num_pending_(0) {}
+
+    TaskGroup(const TaskGroup &) = delete;
+    TaskGroup & operator=(const TaskGroup &) = delete;
+
+    /**
+     * @brief Waits for outstanding tasks so none outlive the group.
+     */
+    ~TaskGroup();
+
+    /**
+     * @brief Forks a task onto the pool.
+     *
+     * @param task The task to run.
+     */
+    void run(std::function<void()> task);
+
+    /**
+     * @brief Blocks until every task in the group has finished, running queued
+     * tasks on the calling thread in the meantime.
+     */
+    void wait();
+};